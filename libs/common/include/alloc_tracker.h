@@ -0,0 +1,115 @@
+/**
+ * @file alloc_tracker.h
+ * @brief 堆分配统计工具的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 替换全局 operator new/delete，统计每个线程以及整个进程的分配次数、
+ * 释放次数和分配字节数，用于守住"稳态热路径零分配"的约束：
+ * - AllocTracker: 读取当前线程/整个进程的累计计数，可临时暂停统计
+ * - AllocRegion: 作用域区域，记录构造时的计数，delta() 返回区域内发生的分配
+ *
+ * 该工具是可选的：它被编译为独立的静态库 alloc_tracker，只有显式链接
+ * 该库的程序才会替换全局 operator new/delete，其余程序不受影响。
+ *
+ * @note 计数使用 thread_local 与 relaxed 原子变量，开销很小但不为零，
+ *       不建议在生产程序中链接
+ *
+ * @example
+ * @code
+ * AllocRegion region(AllocRegion::Scope::Process);
+ * run_hot_path();
+ * AllocCounters delta = region.delta();
+ * std::cout << delta.allocations << " allocations" << std::endl;
+ * @endcode
+ */
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct AllocCounters
+ * @brief 分配计数
+ */
+struct AllocCounters {
+    uint64_t allocations = 0;       ///< operator new 调用次数
+    uint64_t deallocations = 0;     ///< operator delete 调用次数（不含空指针）
+    uint64_t bytes = 0;             ///< 累计申请的字节数
+};
+
+/**
+ * @class AllocTracker
+ * @brief 全局分配计数的访问接口
+ */
+class AllocTracker {
+public:
+    /**
+     * @brief 当前线程的累计计数
+     */
+    static AllocCounters thread_counters();
+
+    /**
+     * @brief 整个进程的累计计数
+     */
+    static AllocCounters process_counters();
+
+    /**
+     * @brief 暂停或恢复统计
+     * @param enabled false 时分配照常进行但不计数（例如跳过预热阶段）
+     */
+    static void set_enabled(bool enabled);
+
+    /**
+     * @brief 当前是否在统计
+     */
+    static bool is_enabled();
+};
+
+/**
+ * @class AllocRegion
+ * @brief 作用域分配统计区域
+ */
+class AllocRegion {
+public:
+    /**
+     * @brief 统计范围
+     */
+    enum class Scope {
+        Thread,     ///< 只统计创建区域的线程
+        Process     ///< 统计所有线程
+    };
+
+    /**
+     * @brief 构造函数，记录当前计数作为起点
+     * @param scope 统计范围
+     */
+    explicit AllocRegion(Scope scope = Scope::Thread);
+
+    /**
+     * @brief 区域开始以来发生的分配
+     * @return 计数差值
+     *
+     * @note Scope::Thread 的区域只能在创建它的线程中读取
+     */
+    AllocCounters delta() const;
+
+    /**
+     * @brief 把当前计数重新设为起点
+     */
+    void reset();
+
+private:
+    /**
+     * @brief 按统计范围读取当前计数
+     */
+    AllocCounters current() const;
+
+    Scope scope_;               // 统计范围
+    AllocCounters start_;       // 起点计数
+};
+
+#endif // ALLOC_TRACKER_H
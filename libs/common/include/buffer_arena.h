@@ -0,0 +1,274 @@
+/**
+ * @file buffer_arena.h
+ * @brief 大页内存区域与定长缓冲池的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 为网络库的接收/发送缓冲区提供预先分配好的内存：
+ * - BufferArena: 一次性 mmap 一块连续内存，优先使用 MAP_HUGETLB 大页，
+ *   失败时退回普通页并通过 madvise(MADV_HUGEPAGE) 请求透明大页（THP）；
+ *   可选 MAP_POPULATE / 逐页预写入（pre-fault）以及 mlock 锁定物理内存
+ * - BufferPool: 从 BufferArena 中切分出固定大小的内存块，并用空闲链表复用
+ * - SizeClassPool: 一组按 2 的幂分档（512B ~ 64KB）的 BufferPool，
+ *   按请求大小选择最小的够用档位
+ *
+ * 启动时即完成缺页与 TLB 填充，服务器从第一个请求开始就处于稳态延迟。
+ *
+ * @note 这些类都不可拷贝
+ *
+ * @example
+ * @code
+ * BufferArena::Options opts;
+ * opts.size = 8 * 1024 * 1024;
+ * opts.lock = true;
+ * BufferArena arena(opts);
+ * BufferPool pool(arena, 4096, 256);
+ * char* buf = pool.acquire();
+ * // ... 使用 buf ...
+ * pool.release(buf);
+ * @endcode
+ */
+
+#ifndef BUFFER_ARENA_H
+#define BUFFER_ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <memory>
+
+/**
+ * @class BufferArena
+ * @brief 基于 mmap 的大页内存区域，只做顺序分配（bump allocation）
+ *
+ * @details
+ * 内存在构造时一次性映射，析构时一次性释放，中途不归还。
+ * 分配出去的内存由上层（如 BufferPool）负责复用。
+ */
+class BufferArena {
+public:
+    /**
+     * @brief 内存区域配置项
+     */
+    struct Options {
+        size_t size = 16 * 1024 * 1024;     ///< 区域大小（字节），会向上取整到页大小
+        bool use_hugepages = true;          ///< 优先 MAP_HUGETLB，失败时退回 THP madvise
+        bool populate = true;               ///< 使用 MAP_POPULATE 在映射时建立页表
+        bool prefault = false;              ///< 映射后逐页写入一次，强制触发缺页
+        bool lock = false;                  ///< 使用 mlock 锁定物理内存，避免被换出
+    };
+
+    /**
+     * @brief 构造函数，映射内存区域
+     * @param options 内存区域配置
+     *
+     * @details 映射失败时 is_valid() 返回 false，所有分配都会返回 nullptr
+     */
+    explicit BufferArena(const Options& options);
+
+    /**
+     * @brief 构造函数，使用默认配置
+     */
+    BufferArena() : BufferArena(Options{}) {}
+
+    /**
+     * @brief 析构函数
+     * @details 解除映射（以及 mlock）
+     */
+    ~BufferArena();
+
+    /// @brief 禁止拷贝构造
+    BufferArena(const BufferArena&) = delete;
+    /// @brief 禁止拷贝赋值
+    BufferArena& operator=(const BufferArena&) = delete;
+    /// @brief 禁止移动构造
+    BufferArena(BufferArena&&) = delete;
+    /// @brief 禁止移动赋值
+    BufferArena& operator=(BufferArena&&) = delete;
+
+    /**
+     * @brief 从区域中分配一段内存
+     * @param size 需要的字节数
+     * @param alignment 对齐要求，必须是 2 的幂，默认为缓存行大小
+     * @return 内存指针，区域耗尽时返回 nullptr
+     *
+     * @note 该函数是线程安全的
+     */
+    void* allocate(size_t size, size_t alignment = 64);
+
+    /**
+     * @brief 判断指针是否位于本区域内
+     * @param ptr 要判断的指针
+     * @return true 属于本区域，false 不属于
+     */
+    bool owns(const void* ptr) const;
+
+    /**
+     * @brief 区域是否映射成功
+     */
+    bool is_valid() const { return base_ != nullptr; }
+
+    /**
+     * @brief 区域总容量（字节）
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief 已分配的字节数
+     */
+    size_t used() const;
+
+    /**
+     * @brief 是否由 MAP_HUGETLB 大页支撑
+     */
+    bool is_hugetlb() const { return hugetlb_; }
+
+    /**
+     * @brief 是否已通过 mlock 锁定
+     */
+    bool is_locked() const { return locked_; }
+
+private:
+    /**
+     * @brief 逐页写入一个字节，强制建立物理页映射
+     * @param page_size 步长（普通页或大页大小）
+     */
+    void prefault(size_t page_size);
+
+    char* base_;                        // 区域起始地址
+    size_t capacity_;                   // 区域大小
+    size_t mapped_size_;                // 实际映射大小（含对齐余量）
+    char* mapped_base_;                 // 实际映射起始地址
+    size_t offset_;                     // 下一次分配的偏移
+    bool hugetlb_;                      // 是否为 MAP_HUGETLB 映射
+    bool locked_;                       // 是否已 mlock
+    mutable std::mutex mutex_;          // 分配互斥锁
+};
+
+/**
+ * @class BufferPool
+ * @brief 定长缓冲块池，块内存来自 BufferArena
+ *
+ * @details
+ * 构造时一次性从区域中切分出全部缓冲块。池空时退回到堆上分配，
+ * 保证调用方总能拿到缓冲区；堆上分配的块在归还时直接释放。
+ */
+class BufferPool {
+public:
+    /**
+     * @brief 构造函数
+     * @param arena 提供内存的区域，生命周期必须长于本池
+     * @param block_size 每个缓冲块的大小（字节）
+     * @param block_count 预先切分的缓冲块数量
+     */
+    BufferPool(BufferArena& arena, size_t block_size, size_t block_count);
+
+    /**
+     * @brief 析构函数
+     */
+    ~BufferPool() = default;
+
+    /// @brief 禁止拷贝构造
+    BufferPool(const BufferPool&) = delete;
+    /// @brief 禁止拷贝赋值
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief 获取一个缓冲块
+     * @return 大小为 block_size() 的缓冲区指针
+     *
+     * @note 该函数是线程安全的
+     */
+    char* acquire();
+
+    /**
+     * @brief 归还缓冲块
+     * @param block 由 acquire() 返回的指针
+     *
+     * @note 该函数是线程安全的
+     */
+    void release(char* block);
+
+    /**
+     * @brief 每个缓冲块的大小
+     */
+    size_t block_size() const { return block_size_; }
+
+    /**
+     * @brief 当前空闲的缓冲块数量
+     */
+    size_t available() const;
+
+private:
+    BufferArena& arena_;                // 内存来源
+    size_t block_size_;                 // 缓冲块大小
+    std::vector<char*> free_list_;      // 空闲缓冲块
+    mutable std::mutex mutex_;          // 空闲链表互斥锁
+};
+
+/**
+ * @class SizeClassPool
+ * @brief 按大小分档的缓冲池
+ *
+ * @details
+ * 档位为 MIN_CLASS_SIZE 到 MAX_CLASS_SIZE 之间的 2 的幂，每档是一个 BufferPool。
+ * 超过最大档位的请求直接在堆上分配，归还时直接释放。
+ */
+class SizeClassPool {
+public:
+    /// @brief 最小档位大小
+    static constexpr size_t MIN_CLASS_SIZE = 512;
+    /// @brief 最大档位大小
+    static constexpr size_t MAX_CLASS_SIZE = 65536;
+    /// @brief 档位数量
+    static constexpr size_t CLASS_COUNT = 8;
+
+    /**
+     * @brief 构造函数
+     * @param arena 提供内存的区域，生命周期必须长于本池
+     * @param bytes_per_class 每个档位预先切分的字节数（至少切分一个块）
+     */
+    SizeClassPool(BufferArena& arena, size_t bytes_per_class);
+
+    /// @brief 禁止拷贝构造
+    SizeClassPool(const SizeClassPool&) = delete;
+    /// @brief 禁止拷贝赋值
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    /**
+     * @brief 获取一个至少 size 字节的缓冲块
+     * @param size 需要的字节数
+     * @param capacity 输出参数，缓冲块的实际容量
+     * @return 缓冲块指针
+     *
+     * @note 该函数是线程安全的
+     */
+    char* acquire(size_t size, size_t& capacity);
+
+    /**
+     * @brief 归还缓冲块
+     * @param block 由 acquire() 返回的指针
+     * @param capacity acquire() 输出的容量
+     *
+     * @note 该函数是线程安全的
+     */
+    void release(char* block, size_t capacity);
+
+    /**
+     * @brief 计算 size 所属档位的大小
+     * @param size 需要的字节数
+     * @return 档位大小；超过最大档位时返回 size 本身
+     */
+    static size_t class_size(size_t size);
+
+private:
+    /**
+     * @brief 计算档位下标
+     */
+    static size_t class_index(size_t class_size);
+
+    std::vector<std::unique_ptr<BufferPool>> pools_;    // 各档位的缓冲池
+};
+
+#endif // BUFFER_ARENA_H
@@ -0,0 +1,112 @@
+/**
+ * @file busy_poll.h
+ * @brief I/O 线程忙轮询模式的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 阻塞在 epoll_wait/recv 上的线程每条消息都要经历一次睡眠和唤醒，延迟增加数微秒。
+ * 忙轮询模式下 I/O 线程改用不阻塞的调用（epoll_wait 超时为 0、recv 带 MSG_DONTWAIT）
+ * 自旋等待数据：
+ * - 取到数据后保持自旋；连续空转超过 idle_timeout 后退回阻塞等待，空闲时 CPU 占用有上限
+ * - 阻塞等待返回数据后重新进入自旋
+ * - 可选地为 socket 设置 SO_BUSY_POLL / SO_PREFER_BUSY_POLL，让内核在读取时直接轮询网卡队列
+ *
+ * BusyPoller 只记录一个线程的自旋状态，由各 I/O 循环按自己的系统调用使用。
+ *
+ * @example
+ * @code
+ * BusyPoller poller(options);
+ * while (running) {
+ *     int flags = poller.spinning() ? MSG_DONTWAIT : 0;
+ *     ssize_t n = recv(fd, buffer, size, flags);
+ *     if (n < 0 && errno == EAGAIN) {
+ *         poller.on_idle();
+ *         continue;
+ *     }
+ *     poller.on_work();
+ *     // 处理数据
+ * }
+ * @endcode
+ */
+
+#ifndef BUSY_POLL_H
+#define BUSY_POLL_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @struct BusyPollOptions
+ * @brief 忙轮询配置
+ */
+struct BusyPollOptions {
+    bool enabled = false;                           ///< 是否启用忙轮询
+    std::chrono::microseconds idle_timeout{1000};   ///< 连续空转超过该时长后退回阻塞等待，0 表示一直自旋
+    int socket_busy_poll_us = 0;                    ///< 大于 0 时为 socket 设置 SO_BUSY_POLL（微秒），超过 net.core.busy_read 需要 CAP_NET_ADMIN
+    bool prefer_busy_poll = false;                  ///< 为 socket 设置 SO_PREFER_BUSY_POLL（Linux 5.11+）
+};
+
+/**
+ * @class BusyPoller
+ * @brief 单个 I/O 线程的自旋/阻塞状态
+ */
+class BusyPoller {
+public:
+    /**
+     * @brief 构造函数
+     * @param options 忙轮询配置，未启用时 spinning() 总是返回 false
+     */
+    explicit BusyPoller(const BusyPollOptions& options)
+        : enabled_(options.enabled)
+        , spinning_(options.enabled)
+        , idle_timeout_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(options.idle_timeout).count())
+        , idle_spins_(0)
+        , idle_since_ticks_(0) {}
+
+    /**
+     * @brief 下一次轮询是否应该不阻塞
+     */
+    bool spinning() const { return spinning_; }
+
+    /**
+     * @brief 本次轮询取到了数据：保持（或重新进入）自旋并重新计时
+     */
+    void on_work() {
+        spinning_ = enabled_;
+        idle_spins_ = 0;
+    }
+
+    /**
+     * @brief 本次不阻塞的轮询没有数据：暂停片刻，空转超时后退回阻塞等待
+     */
+    void on_idle();
+
+    /**
+     * @brief 自旋等待中让出执行单元片刻（x86 的 pause / ARM 的 yield）
+     */
+    static void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
+    /**
+     * @brief 按配置为 socket 设置 SO_BUSY_POLL / SO_PREFER_BUSY_POLL
+     * @param fd socket 文件描述符
+     * @param options 忙轮询配置
+     * @return true 设置成功或无需设置，false 内核拒绝（errno 保留）
+     */
+    static bool apply_socket_options(int fd, const BusyPollOptions& options);
+
+private:
+    bool enabled_;              // 是否启用忙轮询
+    bool spinning_;             // 当前是否处于自旋阶段
+    int64_t idle_timeout_ns_;   // 空转超时（纳秒），0 表示一直自旋
+    uint32_t idle_spins_;       // 本次空转的连续次数
+    uint64_t idle_since_ticks_; // 本次空转开始时的周期计数（Clock::ticks()）
+};
+
+#endif // BUSY_POLL_H
@@ -0,0 +1,151 @@
+/**
+ * @file clock.h
+ * @brief 热路径时间戳用的时钟的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 每秒数百万个事件时，每个事件读一次 std::chrono::steady_clock::now() 的开销不可忽略。
+ * 本时钟把两类用法分开：
+ * - 时刻（超时、过期、限速）：I/O 循环每轮调用 refresh() 读一次单调时钟并缓存在线程局部变量中，
+ *   本轮内的回调和库代码通过 cached_ns() 直接取用，精度为一轮
+ * - 时长（耗时统计、延迟测量）：ticks() 读取 CPU 周期计数器（x86 上为不变 TSC 的 rdtsc，
+ *   AArch64 上为 cntvct_el0），ticks_to_ns() 按校准出的频率换算为纳秒；
+ *   计数器不可用时退回 clock_gettime，周期即纳秒
+ *
+ * now_ns() / cached_ns() 与 std::chrono::steady_clock 使用同一时间轴（CLOCK_MONOTONIC），
+ * 可以直接与 steady_clock::time_point 换算出的纳秒比较。ticks() 只用于求差。
+ *
+ * TSC 频率在首次换算时校准（约 2 毫秒的自旋），可以调用 calibrate() 提前完成；
+ * 事件循环和服务器启动时会调用。
+ *
+ * @example
+ * @code
+ * // 事件循环中：每轮一次
+ * int64_t now = Clock::refresh();
+ * // 回调中：不再读时钟
+ * if (deadline_ns <= Clock::cached_ns()) { ... }
+ *
+ * // 精确测量
+ * uint64_t begin = Clock::ticks();
+ * handle(message);
+ * int64_t elapsed_ns = Clock::elapsed_ns(begin);
+ * @endcode
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @class Clock
+ * @brief 缓存的粗粒度时刻与周期计数器时长的静态工具
+ */
+class Clock {
+public:
+    /**
+     * @brief 读取单调时钟（纳秒，与 steady_clock 同一时间轴）
+     */
+    static int64_t now_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    /**
+     * @brief 读取单调时钟并缓存到本线程
+     * @return 当前时刻（纳秒）
+     *
+     * @details 由 I/O 循环在每轮开始时调用
+     */
+    static int64_t refresh() {
+        cached_ns_ = now_ns();
+        return cached_ns_;
+    }
+
+    /**
+     * @brief 本线程缓存的时刻
+     * @return 最近一次 refresh() 的结果；本线程没有缓存（不是 I/O 循环线程）时直接读取时钟
+     */
+    static int64_t cached_ns() {
+        return cached_ns_ != 0 ? cached_ns_ : now_ns();
+    }
+
+    /**
+     * @brief 清除本线程的缓存
+     *
+     * @details I/O 循环退出时调用，之后复用该线程的任务不会读到过期的缓存
+     */
+    static void invalidate() { cached_ns_ = 0; }
+
+    /**
+     * @brief 读取周期计数器
+     * @return 周期数，只用于求差
+     */
+    static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        if (tsc_usable()) {
+            return __rdtsc();
+        }
+#elif defined(__aarch64__)
+        uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#endif
+        return static_cast<uint64_t>(now_ns());
+    }
+
+    /**
+     * @brief 把周期差换算为纳秒
+     * @param ticks 周期差
+     * @return 纳秒数
+     */
+    static int64_t ticks_to_ns(uint64_t ticks);
+
+    /**
+     * @brief 从 begin 到现在经过的纳秒数
+     * @param begin 起点处 ticks() 的结果
+     */
+    static int64_t elapsed_ns(uint64_t begin) {
+        return ticks_to_ns(ticks() - begin);
+    }
+
+    /**
+     * @brief 提前完成周期计数器的频率校准（线程安全，只执行一次）
+     */
+    static void calibrate();
+
+    /**
+     * @brief 周期计数器的频率（每秒周期数）
+     */
+    static double ticks_per_second();
+
+    /**
+     * @brief 周期计数器的来源："tsc"、"cntvct" 或 "clock_gettime"
+     */
+    static const char* source();
+
+private:
+    /**
+     * @brief 是否使用 TSC（CPU 声明不变 TSC 时）
+     */
+    static bool tsc_usable() {
+        static const bool usable = detect_invariant_tsc();
+        return usable;
+    }
+
+    /**
+     * @brief 通过 CPUID 检测不变 TSC
+     */
+    static bool detect_invariant_tsc();
+
+    inline static thread_local int64_t cached_ns_ = 0;     // 本线程缓存的时刻，0 表示没有缓存
+};
+
+#endif // CLOCK_H
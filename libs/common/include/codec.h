@@ -0,0 +1,160 @@
+/**
+ * @file codec.h
+ * @brief 消息编解码器（分帧策略）的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 编解码器作为 BasicTcpServer / BasicUdpServer 的模板参数，决定如何从连续的
+ * 字节中切出一条条消息。所有编解码器都提供同样的成员函数：
+ *
+ * @code
+ * // 返回值：> 0 本条消息占用的字节数（message 指向其中的消息内容）
+ * //         0 数据不足一条完整消息
+ * //         CODEC_ERROR 数据非法，连接应被关闭（UDP 下丢弃该数据报）
+ * size_t decode(const char* data, size_t length, std::string_view& message);
+ * @endcode
+ *
+ * decode 在头文件中定义，随服务器模板一起实例化，可以被编译器内联。
+ * message 只在回调期间有效，指向服务器的输入缓冲区，不发生拷贝。
+ */
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+/// @brief decode 返回该值表示数据非法
+constexpr size_t CODEC_ERROR = static_cast<size_t>(-1);
+
+/**
+ * @class RawCodec
+ * @brief 不分帧：每次读到的全部数据（或一个数据报）作为一条消息
+ */
+class RawCodec {
+public:
+    size_t decode(const char* data, size_t length, std::string_view& message) {
+        message = std::string_view(data, length);
+        return length;
+    }
+};
+
+/**
+ * @class LineCodec
+ * @brief 按换行符分帧，消息内容不含行尾的 "\n" 或 "\r\n"
+ */
+class LineCodec {
+public:
+    /**
+     * @brief 构造函数
+     * @param max_length 单行最大长度，超过时视为非法数据
+     */
+    explicit LineCodec(size_t max_length = 64 * 1024) : max_length_(max_length) {}
+
+    size_t decode(const char* data, size_t length, std::string_view& message) {
+        const char* end = static_cast<const char*>(memchr(data, '\n', length));
+        if (!end) {
+            return length > max_length_ ? CODEC_ERROR : 0;
+        }
+
+        size_t line_length = static_cast<size_t>(end - data);
+        size_t content_length = line_length;
+        if (content_length > 0 && data[content_length - 1] == '\r') {
+            --content_length;
+        }
+        message = std::string_view(data, content_length);
+        return line_length + 1;
+    }
+
+private:
+    size_t max_length_;     // 单行最大长度
+};
+
+/**
+ * @class LengthPrefixCodec
+ * @brief 4 字节大端长度前缀 + 消息内容，消息内容不含长度前缀
+ */
+class LengthPrefixCodec {
+public:
+    /// @brief 长度前缀的字节数
+    static constexpr size_t HEADER_SIZE = 4;
+
+    /**
+     * @brief 构造函数
+     * @param max_length 消息内容最大长度，超过时视为非法数据
+     */
+    explicit LengthPrefixCodec(size_t max_length = 16 * 1024 * 1024) : max_length_(max_length) {}
+
+    size_t decode(const char* data, size_t length, std::string_view& message) {
+        if (length < HEADER_SIZE) {
+            return 0;
+        }
+
+        const unsigned char* header = reinterpret_cast<const unsigned char*>(data);
+        size_t body_length = (static_cast<size_t>(header[0]) << 24) | (static_cast<size_t>(header[1]) << 16)
+                           | (static_cast<size_t>(header[2]) << 8) | static_cast<size_t>(header[3]);
+        if (body_length > max_length_) {
+            return CODEC_ERROR;
+        }
+        if (length - HEADER_SIZE < body_length) {
+            return 0;
+        }
+
+        message = std::string_view(data + HEADER_SIZE, body_length);
+        return HEADER_SIZE + body_length;
+    }
+
+    /**
+     * @brief 写入长度前缀，供发送方组帧
+     * @param body_length 消息内容长度
+     * @param header 输出缓冲区，至少 HEADER_SIZE 字节
+     */
+    static void encode_header(uint32_t body_length, char* header) {
+        header[0] = static_cast<char>((body_length >> 24) & 0xFF);
+        header[1] = static_cast<char>((body_length >> 16) & 0xFF);
+        header[2] = static_cast<char>((body_length >> 8) & 0xFF);
+        header[3] = static_cast<char>(body_length & 0xFF);
+    }
+
+private:
+    size_t max_length_;     // 消息内容最大长度
+};
+
+/**
+ * @class SplitterCodec
+ * @brief 由运行时设置的分帧函数决定消息边界，消息内容为整帧
+ *
+ * @details 供基于 std::function 的 TcpServer 使用；未设置分帧函数时等同于 RawCodec
+ */
+class SplitterCodec {
+public:
+    /**
+     * @brief 分帧函数类型
+     * @param data 尚未处理的数据起始地址
+     * @param length 尚未处理的数据长度
+     * @return 第一个完整消息的字节数；数据不足一个完整消息时返回 0
+     */
+    using Splitter = std::function<size_t(const char* data, size_t length)>;
+
+    Splitter splitter;      ///< 分帧函数
+
+    size_t decode(const char* data, size_t length, std::string_view& message) {
+        if (!splitter) {
+            message = std::string_view(data, length);
+            return length;
+        }
+
+        size_t frame_length = splitter(data, length);
+        if (frame_length == 0 || frame_length > length) {
+            return 0;
+        }
+        message = std::string_view(data, frame_length);
+        return frame_length;
+    }
+};
+
+#endif // CODEC_H
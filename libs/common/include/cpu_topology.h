@@ -0,0 +1,86 @@
+/**
+ * @file cpu_topology.h
+ * @brief CPU 与 NUMA 拓扑查询、线程绑核的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 不依赖 libnuma，直接读取内核接口：
+ * - 本进程允许运行的 CPU：sched_getaffinity()
+ * - 每个 CPU 所属的 NUMA 节点：/sys/devices/system/node/node<N>/cpulist
+ *   （没有该目录的系统视为只有节点 0）
+ *
+ * 用于把 I/O 线程绑定到固定的 CPU，并为连接挑选与内核处理其收包软中断
+ * 相同或相近（同一 NUMA 节点）的 I/O 线程。
+ *
+ * @example
+ * @code
+ * CpuTopology topology;
+ * for (int cpu : topology.cpus()) {
+ *     std::cout << cpu << " -> node " << topology.node_of(cpu) << std::endl;
+ * }
+ * CpuTopology::pin_current_thread(topology.cpus().front());
+ * @endcode
+ */
+
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @class CpuTopology
+ * @brief 构造时探测一次的 CPU/NUMA 拓扑快照
+ */
+class CpuTopology {
+public:
+    /**
+     * @brief 构造函数
+     * @details 读取本进程的 CPU 亲和性与各 CPU 的 NUMA 节点
+     */
+    CpuTopology();
+
+    /**
+     * @brief 本进程允许运行的 CPU 编号（升序）
+     */
+    const std::vector<int>& cpus() const { return cpus_; }
+
+    /**
+     * @brief 查询 CPU 所属的 NUMA 节点
+     * @param cpu CPU 编号
+     * @return 节点编号，未知时返回 0
+     */
+    int node_of(int cpu) const;
+
+    /**
+     * @brief 系统中最大的 CPU 编号加一（可用于按 CPU 编号建表）
+     */
+    int cpu_limit() const { return static_cast<int>(nodes_.size()); }
+
+    /**
+     * @brief 把调用线程绑定到指定 CPU
+     * @param cpu CPU 编号
+     * @return true 绑定成功，false 失败（CPU 不存在或不在允许范围内）
+     */
+    static bool pin_current_thread(int cpu);
+
+    /**
+     * @brief 调用线程当前运行的 CPU
+     * @return CPU 编号，失败时返回 -1
+     */
+    static int current_cpu();
+
+    /**
+     * @brief 解析内核的 CPU 列表格式（如 "0-3,8,10-11"）
+     * @param list CPU 列表字符串
+     * @return CPU 编号（按出现顺序）
+     */
+    static std::vector<int> parse_cpu_list(const std::string& list);
+
+private:
+    std::vector<int> cpus_;     // 允许运行的 CPU
+    std::vector<int> nodes_;    // CPU 编号 -> NUMA 节点
+};
+
+#endif // CPU_TOPOLOGY_H
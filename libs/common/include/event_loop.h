@@ -0,0 +1,249 @@
+/**
+ * @file event_loop.h
+ * @brief 基于 epoll 的事件循环类的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 一个事件循环对应一个 I/O 线程：
+ * - 通过 epoll 等待多个文件描述符的就绪事件
+ * - 就绪事件通过统一的事件处理函数分发（携带注册时的上下文指针）
+ * - 其他线程可以通过 queue_in_loop() 把任务投递到循环线程执行，
+ *   使用 eventfd 唤醒阻塞中的 epoll_wait；循环处理本次唤醒之前的重复唤醒会被合并，
+ *   一批突发投递只写一次 eventfd
+ * - 上层可以注册唤醒处理函数，配合自己的无锁队列（如 MpscQueue）在唤醒后批量取走数据
+ * - 上层可以注册就绪列表处理函数，在每轮末尾继续处理上一轮因配额用完而让出的工作；
+ *   仍有剩余工作时下一轮 epoll_wait 不阻塞
+ * - 可选地把尚未执行的任务记账到 MemoryBudget（Category::Task）
+ * - 累计处理事件和任务所花的时间（不含阻塞等待），供上层计算各循环的利用率
+ * - 可选的忙轮询模式：以零超时调用 epoll_wait 自旋，空转超过设定时长后才阻塞等待
+ * - 可选的定时处理函数：由 timerfd 按固定间隔唤醒，在到期的那一轮中调用一次
+ *
+ * @note 该类不可拷贝和移动
+ *
+ * @example
+ * @code
+ * EventLoop loop;
+ * loop.set_event_handler([](void* context, uint32_t events) {
+ *     // 处理 context 对应的连接
+ * });
+ * loop.add(fd, EPOLLIN, context);
+ * std::thread t([&] { loop.run(); });
+ * // ...
+ * loop.stop();
+ * t.join();
+ * @endcode
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include "memory_budget.h"
+#include "busy_poll.h"
+
+/**
+ * @class EventLoop
+ * @brief epoll 事件循环，每个实例只能在一个线程中运行
+ */
+class EventLoop {
+public:
+    /**
+     * @brief 就绪事件处理函数类型
+     * @param context 注册文件描述符时传入的上下文指针
+     * @param events epoll 事件掩码（EPOLLIN、EPOLLOUT 等）
+     */
+    using EventHandler = std::function<void(void* context, uint32_t events)>;
+
+    /**
+     * @brief 投递到循环线程执行的任务类型
+     */
+    using Task = std::function<void()>;
+
+    /**
+     * @brief 就绪列表处理函数类型
+     * @return true 仍有未处理完的工作，false 已全部处理完
+     */
+    using ReadyHandler = std::function<bool()>;
+
+    /**
+     * @brief 构造函数
+     * @details 创建 epoll 实例和用于唤醒的 eventfd
+     */
+    EventLoop();
+
+    /**
+     * @brief 析构函数
+     * @details 关闭 epoll 和 eventfd
+     */
+    ~EventLoop();
+
+    /// @brief 禁止拷贝构造
+    EventLoop(const EventLoop&) = delete;
+    /// @brief 禁止拷贝赋值
+    EventLoop& operator=(const EventLoop&) = delete;
+    /// @brief 禁止移动构造
+    EventLoop(EventLoop&&) = delete;
+    /// @brief 禁止移动赋值
+    EventLoop& operator=(EventLoop&&) = delete;
+
+    /**
+     * @brief 注册文件描述符
+     * @param fd 文件描述符
+     * @param events 关注的 epoll 事件
+     * @param context 事件就绪时回传给处理函数的上下文
+     * @return true 注册成功，false 注册失败
+     *
+     * @note 该函数是线程安全的（epoll_ctl 本身线程安全）
+     */
+    bool add(int fd, uint32_t events, void* context);
+
+    /**
+     * @brief 修改已注册文件描述符关注的事件
+     * @param fd 文件描述符
+     * @param events 新的 epoll 事件
+     * @param context 上下文指针
+     * @return true 修改成功，false 修改失败
+     */
+    bool modify(int fd, uint32_t events, void* context);
+
+    /**
+     * @brief 取消注册文件描述符
+     * @param fd 文件描述符
+     * @return true 成功，false 失败
+     */
+    bool remove(int fd);
+
+    /**
+     * @brief 设置就绪事件处理函数
+     * @param handler 处理函数，必须在 run() 之前设置
+     */
+    void set_event_handler(EventHandler handler);
+
+    /**
+     * @brief 设置唤醒处理函数
+     * @param handler 每次被 wakeup() 唤醒后在循环线程中调用（先于投递的任务），必须在 run() 之前设置
+     */
+    void set_wakeup_handler(Task handler);
+
+    /**
+     * @brief 设置就绪列表处理函数
+     * @param handler 每轮在就绪事件、唤醒处理和投递的任务之后调用，必须在 run() 之前设置
+     *
+     * @details 返回 true 时下一轮以零超时调用 epoll_wait，先收集新的就绪事件再继续处理，
+     *          用于边缘触发下没有读写到 EAGAIN 就让出的连接
+     */
+    void set_ready_handler(ReadyHandler handler);
+
+    /**
+     * @brief 设置定时处理函数
+     * @param interval 调用间隔，必须大于 0
+     * @param handler 每次到期后在循环线程中调用一次（在唤醒处理之后、投递的任务之前），必须在 run() 之前设置
+     * @return true 设置成功，false 创建 timerfd 失败
+     *
+     * @details 错过的多次到期合并为一次调用；忙轮询的自旋阶段同样按时调用
+     */
+    bool set_timer_handler(std::chrono::milliseconds interval, Task handler);
+
+    /**
+     * @brief 唤醒循环线程
+     *
+     * @details 循环线程处理本次唤醒之前，重复调用不会再写 eventfd。
+     *          配合无锁队列使用时，应在入队之后调用
+     *
+     * @note 该函数是线程安全的
+     */
+    void wakeup();
+
+    /**
+     * @brief 设置任务队列的内存记账对象
+     * @param budget 内存预算，nullptr 表示不记账；生命周期必须长于本循环
+     *
+     * @details 必须在 run() 之前设置。每个排队中的任务按 sizeof(Task) 记账
+     */
+    void set_memory_budget(MemoryBudget* budget) { budget_ = budget; }
+
+    /**
+     * @brief 设置忙轮询模式
+     * @param options 忙轮询配置
+     *
+     * @details 必须在 run() 之前设置。自旋中没有取到事件的空转不计入忙碌时间，
+     *          只有取到事件或就绪列表仍有工作的轮次才计入。
+     *          socket 级的选项由注册文件描述符的上层自行设置
+     */
+    void set_busy_poll(const BusyPollOptions& options) { busy_poll_ = options; }
+
+    /**
+     * @brief 运行事件循环，直到 stop() 被调用
+     * @details 阻塞调用线程，调用线程即成为循环线程
+     */
+    void run();
+
+    /**
+     * @brief 请求停止事件循环
+     * @details 可在任意线程调用，run() 会在当前一轮处理完后返回
+     */
+    void stop();
+
+    /**
+     * @brief 把任务投递到循环线程执行
+     * @param task 要执行的任务
+     *
+     * @note 该函数是线程安全的
+     */
+    void queue_in_loop(Task task);
+
+    /**
+     * @brief 累计的忙碌时间（纳秒）
+     * @return 从 epoll_wait 返回到本轮处理结束的时间之和（含正在进行的一轮），不含阻塞等待
+     *
+     * @details 两次采样之差除以采样间隔即为该区间内的利用率。一轮处理很长
+     *          （如连接持续有数据可读）时也能及时反映出来
+     *
+     * @note 该函数是线程安全的；与循环线程并发时结果可能有一轮以内的误差
+     */
+    uint64_t busy_time_ns() const;
+
+    /**
+     * @brief 判断当前线程是否为循环线程
+     */
+    bool is_in_loop_thread() const { return thread_id_ == std::this_thread::get_id(); }
+
+    /**
+     * @brief epoll 和 eventfd 是否创建成功
+     */
+    bool is_valid() const { return epoll_fd_ >= 0 && wakeup_fd_ >= 0; }
+
+private:
+    /**
+     * @brief 执行所有已投递的任务
+     */
+    void run_pending_tasks();
+
+    int epoll_fd_;                              // epoll 文件描述符
+    int wakeup_fd_;                             // 唤醒用 eventfd
+    int timer_fd_;                              // 定时用 timerfd，未设置定时处理函数时为 -1
+    std::atomic<bool> quit_;                    // 停止标志
+    std::atomic<std::thread::id> thread_id_;    // 循环线程 ID
+
+    EventHandler handler_;                      // 就绪事件处理函数
+    Task wakeup_handler_;                       // 唤醒处理函数
+    ReadyHandler ready_handler_;                // 就绪列表处理函数
+    Task timer_handler_;                        // 定时处理函数
+    std::atomic<bool> wakeup_pending_;          // 已写 eventfd、循环尚未处理
+    MemoryBudget* budget_;                      // 任务队列的内存记账对象
+    BusyPollOptions busy_poll_;                 // 忙轮询配置
+    std::atomic<uint64_t> busy_ns_;             // 已结束各轮的忙碌时间之和（纳秒），仅由循环线程写入
+    std::atomic<int64_t> busy_since_ns_;        // 当前一轮开始的时刻（纳秒），空闲等待时为 0
+
+    std::mutex tasks_mutex_;                    // 任务队列互斥锁
+    std::vector<Task> pending_tasks_;           // 待执行任务
+};
+
+#endif // EVENT_LOOP_H
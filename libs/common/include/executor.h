@@ -0,0 +1,260 @@
+/**
+ * @file executor.h
+ * @brief 消息回调执行器的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 执行器作为 BasicTcpServer / BasicUdpServer 的模板参数，决定消息回调在哪里执行。
+ * 所有执行器都提供同样的成员函数模板：
+ *
+ * @code
+ * // key: 顺序键（TCP 为客户端 fd，UDP 为发送方地址），同一键的消息按到达顺序处理
+ * // message: 只在本次调用期间有效；需要转交其他线程的执行器必须自行拷贝
+ * // handler: 可拷贝的可调用对象，签名为 void(std::string_view message)
+ * template <typename Handler>
+ * void execute(uint64_t key, std::string_view message, Handler&& handler);
+ * @endcode
+ *
+ * 内置实现：
+ * - InlineExecutor: 在 I/O 线程中直接执行，没有任何交接开销
+ * - PoolExecutor: 拷贝消息后投递到线程池，不保证同一键的顺序
+ * - StrandExecutor: 按键哈希到若干串行队列，同一键串行、不同键并行
+ * - FunctionExecutor: 拷贝消息后交给用户提供的投递函数（如已有的事件循环）
+ * - AdaptiveExecutor: 回调耗时低于阈值时内联执行，超过阈值后转交串行队列
+ *
+ * 也可以传入任何满足上述接口的自定义类型。
+ *
+ * @note 转交给其他线程执行时，回调运行时连接可能已经断开（fd 甚至可能已被复用）
+ */
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "thread_pool.h"
+#include "clock.h"
+
+/**
+ * @class InlineExecutor
+ * @brief 在当前 I/O 线程中直接执行，调用可以被完全内联
+ */
+class InlineExecutor {
+public:
+    template <typename Handler>
+    void execute(uint64_t, std::string_view message, Handler&& handler) {
+        handler(message);
+    }
+};
+
+/**
+ * @class PoolExecutor
+ * @brief 把回调投递到自有的线程池中执行
+ *
+ * @details 同一键的消息可能被不同线程并发处理，需要顺序时使用 StrandExecutor
+ */
+class PoolExecutor {
+public:
+    /**
+     * @brief 构造函数
+     * @param thread_count 线程池大小
+     * @param init 线程初始化函数（如 Realtime::worker_init()），可为空
+     */
+    explicit PoolExecutor(size_t thread_count = std::thread::hardware_concurrency(),
+                          ThreadPool::ThreadInit init = nullptr)
+        : pool_(std::make_unique<ThreadPool>(thread_count, std::move(init))) {
+    }
+
+    template <typename Handler>
+    void execute(uint64_t, std::string_view message, Handler&& handler) {
+        pool_->submit([handler, owned = std::string(message)]() { handler(owned); });
+    }
+
+private:
+    std::unique_ptr<ThreadPool> pool_;      // 执行回调的线程池
+};
+
+/**
+ * @class StrandExecutor
+ * @brief 按键分到若干串行队列（strand）执行
+ *
+ * @details 每个串行队列是一个单线程的线程池，同一键总是落在同一队列
+ */
+class StrandExecutor {
+public:
+    /**
+     * @brief 构造函数
+     * @param strand_count 串行队列数量
+     * @param init 线程初始化函数（如 Realtime::worker_init()），可为空
+     */
+    explicit StrandExecutor(size_t strand_count = std::thread::hardware_concurrency(),
+                            ThreadPool::ThreadInit init = nullptr) {
+        if (strand_count == 0) {
+            strand_count = 1;
+        }
+        strands_.reserve(strand_count);
+        for (size_t i = 0; i < strand_count; ++i) {
+            strands_.push_back(std::make_unique<ThreadPool>(1, init));
+        }
+    }
+
+    template <typename Handler>
+    void execute(uint64_t key, std::string_view message, Handler&& handler) {
+        strands_[key % strands_.size()]->submit([handler, owned = std::string(message)]() { handler(owned); });
+    }
+
+private:
+    std::vector<std::unique_ptr<ThreadPool>> strands_;  // 串行队列
+};
+
+/**
+ * @class FunctionExecutor
+ * @brief 把回调交给用户提供的投递函数
+ *
+ * @details 适合把消息处理接入应用已有的线程或事件循环，投递函数需要是线程安全的
+ */
+class FunctionExecutor {
+public:
+    /**
+     * @brief 投递函数类型
+     * @param key 顺序键
+     * @param task 要执行的任务（已持有消息副本）
+     */
+    using Post = std::function<void(uint64_t key, std::function<void()> task)>;
+
+    /**
+     * @brief 构造函数
+     * @param post 投递函数，为空时退化为内联执行
+     */
+    explicit FunctionExecutor(Post post = nullptr) : post_(std::move(post)) {}
+
+    template <typename Handler>
+    void execute(uint64_t key, std::string_view message, Handler&& handler) {
+        if (!post_) {
+            handler(message);
+            return;
+        }
+        post_(key, [handler, owned = std::string(message)]() { handler(owned); });
+    }
+
+private:
+    Post post_;     // 投递函数
+};
+
+/**
+ * @class AdaptiveExecutor
+ * @brief 按实测回调耗时在内联执行与串行队列之间切换
+ *
+ * @details
+ * 每个串行队列维护回调耗时的指数移动平均：
+ * - 平均耗时超过阈值后，落在该队列的消息转交队列线程执行，不再阻塞 I/O 线程
+ * - 平均耗时回落到阈值一半以下、且队列中已没有积压任务时，恢复内联执行
+ *
+ * 转交标志与积压任务数放在同一个原子状态字中：转交任务时以 CAS 在标志仍在的前提下增加计数，
+ * 恢复内联是从“转交且无积压”到“内联”的一次 CAS。多个 I/O 线程共用一个串行队列时，
+ * 一旦有任务转交成功，恢复内联的 CAS 就会失败，因此同一键的消息始终按到达顺序处理。
+ * 每次回调额外读两次周期计数器（Clock::ticks()）。
+ */
+class AdaptiveExecutor {
+public:
+    /**
+     * @brief 构造函数
+     * @param threshold 平均回调耗时阈值
+     * @param strand_count 串行队列数量
+     * @param init 串行队列线程的初始化函数（如 Realtime::worker_init()），可为空
+     */
+    explicit AdaptiveExecutor(std::chrono::nanoseconds threshold = std::chrono::microseconds(50),
+                              size_t strand_count = std::thread::hardware_concurrency(),
+                              ThreadPool::ThreadInit init = nullptr)
+        : threshold_ns_(threshold.count())
+        , strands_(strand_count == 0 ? 1 : strand_count) {
+        for (Strand& strand : strands_) {
+            strand.pool = std::make_unique<ThreadPool>(1, init);
+        }
+    }
+
+    template <typename Handler>
+    void execute(uint64_t key, std::string_view message, Handler&& handler) {
+        Strand& strand = strands_[key % strands_.size()];
+
+        uint32_t state = strand.state.load(std::memory_order_acquire);
+        while ((state & OFFLOADING) != 0) {
+            int64_t average = strand.average_ns.load(std::memory_order_relaxed);
+            if (average > threshold_ns_ / 2 || (state & PENDING_MASK) != 0) {
+                // 标志仍在时才登记积压，与其他线程的恢复内联互斥
+                if (!strand.state.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel,
+                                                        std::memory_order_acquire)) {
+                    continue;
+                }
+                strand.pool->submit([&strand, handler, owned = std::string(message)]() {
+                    record(strand, timed(handler, owned));
+                    strand.state.fetch_sub(1, std::memory_order_release);
+                });
+                return;
+            }
+            // 转交且无积压时才恢复内联；期间有任务转交则重新判断
+            if (strand.state.compare_exchange_weak(state, 0, std::memory_order_acquire, std::memory_order_acquire)) {
+                break;
+            }
+        }
+
+        record(strand, timed(handler, message));
+        if (strand.average_ns.load(std::memory_order_relaxed) > threshold_ns_) {
+            strand.state.fetch_or(OFFLOADING, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 当前处于转交模式的串行队列数量
+     */
+    size_t offloading_strands() const {
+        size_t count = 0;
+        for (const Strand& strand : strands_) {
+            count += (strand.state.load(std::memory_order_relaxed) & OFFLOADING) != 0 ? 1 : 0;
+        }
+        return count;
+    }
+
+private:
+    static constexpr uint32_t OFFLOADING = 1u << 31;        // 状态字中的转交标志
+    static constexpr uint32_t PENDING_MASK = OFFLOADING - 1; // 状态字中的积压任务数
+
+    /**
+     * @struct Strand
+     * @brief 串行队列及其耗时统计
+     */
+    struct Strand {
+        std::unique_ptr<ThreadPool> pool;           // 单线程线程池
+        std::atomic<int64_t> average_ns{0};         // 回调耗时的指数移动平均
+        std::atomic<uint32_t> state{0};             // 转交标志（最高位）与已转交尚未完成的任务数
+    };
+
+    template <typename Handler>
+    static int64_t timed(Handler& handler, std::string_view message) {
+        uint64_t begin = Clock::ticks();
+        handler(message);
+        return Clock::elapsed_ns(begin);
+    }
+
+    static void record(Strand& strand, int64_t elapsed_ns) {
+        // 权重 1/8 的指数移动平均；队列线程与多个 I/O 线程可能同时更新，以 CAS 合并
+        int64_t average = strand.average_ns.load(std::memory_order_relaxed);
+        while (!strand.average_ns.compare_exchange_weak(average, average + (elapsed_ns - average) / 8,
+                                                        std::memory_order_relaxed)) {
+        }
+    }
+
+    int64_t threshold_ns_;          // 平均耗时阈值（纳秒）
+    std::vector<Strand> strands_;   // 串行队列
+};
+
+#endif // EXECUTOR_H
@@ -0,0 +1,138 @@
+/**
+ * @file histogram.h
+ * @brief 对数线性直方图的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 延迟、RTT 等指标跨越多个数量级，用固定宽度的桶要么分辨率不够，要么桶数太多。
+ * 本直方图按对数线性划分：小于 16 的值各占一个桶，之后每个 2 的幂区间再等分为 16 个子桶，
+ * 相对误差不超过 1/16（约 6%），覆盖全部 64 位取值只需 976 个桶。
+ *
+ * 记录只是对桶、计数、总和做一次 relaxed 原子加，可以在多个线程中并发调用而无需加锁；
+ * 读取百分位时扫描全部桶，适合在统计线程中低频调用。
+ *
+ * @example
+ * @code
+ * Histogram latency;
+ * latency.record(elapsed_ns);
+ * Histogram::Summary s = latency.summary();
+ * std::cout << "p99 " << s.p99 << " ns" << std::endl;
+ * @endcode
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class Histogram
+ * @brief 无锁的对数线性直方图
+ */
+class Histogram {
+public:
+    /// @brief 每个 2 的幂区间的子桶数（以 2 为底的对数）
+    static constexpr unsigned SUB_BITS = 4;
+    /// @brief 每个 2 的幂区间的子桶数
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    /// @brief 桶数
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    /**
+     * @struct Summary
+     * @brief 直方图的摘要，百分位为所在桶的上界（不超过最大值）
+     */
+    struct Summary {
+        uint64_t count = 0;     ///< 样本数
+        double mean = 0;        ///< 平均值
+        uint64_t p50 = 0;       ///< 中位数
+        uint64_t p90 = 0;       ///< 90 百分位
+        uint64_t p99 = 0;       ///< 99 百分位
+        uint64_t p999 = 0;      ///< 99.9 百分位
+        uint64_t max = 0;       ///< 最大值
+    };
+
+    Histogram();
+
+    /// @brief 禁止拷贝构造
+    Histogram(const Histogram&) = delete;
+    /// @brief 禁止拷贝赋值
+    Histogram& operator=(const Histogram&) = delete;
+
+    /**
+     * @brief 记录一个样本
+     * @param value 样本值
+     *
+     * @note 该函数是线程安全的
+     */
+    void record(uint64_t value) {
+        buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief 把另一个直方图的样本累加到本直方图
+     * @param other 另一个直方图
+     */
+    void merge(const Histogram& other);
+
+    /**
+     * @brief 清空所有样本
+     */
+    void reset();
+
+    /**
+     * @brief 样本数
+     */
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 最大值
+     */
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 计算百分位
+     * @param quantile 分位（0~1）
+     * @return 第 quantile 分位的样本所在桶的上界（不超过最大值），没有样本时为 0
+     */
+    uint64_t percentile(double quantile) const;
+
+    /**
+     * @brief 生成摘要
+     */
+    Summary summary() const;
+
+    /**
+     * @brief 样本值所在的桶
+     */
+    static size_t bucket_of(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        size_t group = msb - SUB_BITS + 1;
+        size_t sub = static_cast<size_t>(value >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return group * SUB_BUCKETS + sub;
+    }
+
+    /**
+     * @brief 桶的上界（包含）
+     */
+    static uint64_t bucket_upper(size_t bucket);
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKETS];    // 各桶的样本数
+    std::atomic<uint64_t> count_;               // 样本数
+    std::atomic<uint64_t> sum_;                 // 样本总和
+    std::atomic<uint64_t> max_;                 // 最大值
+};
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,198 @@
+/**
+ * @file magic_ring_buffer.h
+ * @brief 双重映射环形缓冲区（magic ring buffer）的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 把同一个 memfd 的物理页连续映射两次：[base, base + N) 与 [base + N, base + 2N)
+ * 指向同一块内存。因此从任意位置开始、长度不超过 N 的区域在虚拟地址上
+ * 都是连续的：
+ * - 可读区域即使跨越环尾也能当作一整段交给分帧函数/解码器，无需拼接
+ * - 可写区域同样连续，可以直接交给 read/readv 填充
+ * - 消费数据只移动读指针，永远不需要 memmove 压缩
+ *
+ * RingBufferPool 按 2 的幂分档缓存环形缓冲区，避免频繁 memfd_create/mmap。
+ *
+ * @note 每个环形缓冲区占用两个内存映射（VMA），大量持有时需关注 vm.max_map_count
+ *
+ * @example
+ * @code
+ * MagicRingBuffer ring(4096);
+ * ssize_t n = read(fd, ring.write_ptr(), ring.writable());
+ * ring.commit(n);
+ * size_t frame = parse(ring.read_ptr(), ring.size());  // 总是连续
+ * ring.consume(frame);
+ * @endcode
+ */
+
+#ifndef MAGIC_RING_BUFFER_H
+#define MAGIC_RING_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+
+/**
+ * @class MagicRingBuffer
+ * @brief 双重映射的环形字节缓冲区
+ *
+ * @note 该类不是线程安全的，同一时间只能由一个线程读写
+ */
+class MagicRingBuffer {
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 容量，会向上取整到页大小的 2 的幂倍
+     *
+     * @details 映射失败时 is_valid() 返回 false
+     */
+    explicit MagicRingBuffer(size_t capacity);
+
+    /**
+     * @brief 析构函数
+     * @details 解除两段映射
+     */
+    ~MagicRingBuffer();
+
+    /// @brief 禁止拷贝构造
+    MagicRingBuffer(const MagicRingBuffer&) = delete;
+    /// @brief 禁止拷贝赋值
+    MagicRingBuffer& operator=(const MagicRingBuffer&) = delete;
+
+    /**
+     * @brief 映射是否成功
+     */
+    bool is_valid() const { return base_ != nullptr; }
+
+    /**
+     * @brief 缓冲区容量
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief 可读字节数
+     */
+    size_t size() const { return static_cast<size_t>(tail_ - head_); }
+
+    /**
+     * @brief 可写字节数
+     */
+    size_t writable() const { return capacity_ - size(); }
+
+    /**
+     * @brief 可读区域起始地址，之后 size() 字节连续可读
+     */
+    char* read_ptr() const { return base_ + (head_ & mask_); }
+
+    /**
+     * @brief 可写区域起始地址，之后 writable() 字节连续可写
+     */
+    char* write_ptr() const { return base_ + (tail_ & mask_); }
+
+    /**
+     * @brief 提交已写入 write_ptr() 的字节
+     * @param length 写入的字节数，不能超过 writable()
+     */
+    void commit(size_t length) { tail_ += length; }
+
+    /**
+     * @brief 消费 read_ptr() 开始的字节
+     * @param length 消费的字节数，不能超过 size()
+     */
+    void consume(size_t length);
+
+    /**
+     * @brief 追加数据
+     * @param data 数据起始地址
+     * @param length 数据长度
+     * @return true 追加成功，false 空间不足
+     */
+    bool append(const char* data, size_t length);
+
+    /**
+     * @brief 清空缓冲区
+     */
+    void clear() { head_ = tail_ = 0; }
+
+private:
+    char* base_;            // 第一段映射的起始地址
+    size_t capacity_;       // 容量（2 的幂）
+    uint64_t mask_;         // capacity_ - 1
+    uint64_t head_;         // 读位置（单调递增）
+    uint64_t tail_;         // 写位置（单调递增）
+};
+
+/**
+ * @class RingBufferPool
+ * @brief 按 2 的幂分档缓存的环形缓冲区池
+ *
+ * @details
+ * 最小档位为一页，超过 MAX_POOLED_SIZE 的环形缓冲区不缓存，归还时直接销毁。
+ */
+class RingBufferPool {
+public:
+    /// @brief 缓存的最大档位
+    static constexpr size_t MAX_POOLED_SIZE = 1024 * 1024;
+
+    /**
+     * @brief 构造函数
+     * @param max_cached_per_class 每个档位最多缓存的环形缓冲区数量
+     */
+    explicit RingBufferPool(size_t max_cached_per_class = 1024);
+
+    /**
+     * @brief 析构函数
+     * @details 销毁所有缓存的环形缓冲区
+     */
+    ~RingBufferPool();
+
+    /// @brief 禁止拷贝构造
+    RingBufferPool(const RingBufferPool&) = delete;
+    /// @brief 禁止拷贝赋值
+    RingBufferPool& operator=(const RingBufferPool&) = delete;
+
+    /**
+     * @brief 获取容量至少为 size 的空环形缓冲区
+     * @param size 需要的容量
+     * @return 环形缓冲区指针，映射失败时返回 nullptr
+     *
+     * @note 该函数是线程安全的
+     */
+    MagicRingBuffer* acquire(size_t size);
+
+    /**
+     * @brief 归还环形缓冲区
+     * @param ring 由 acquire() 返回的指针
+     *
+     * @note 该函数是线程安全的
+     */
+    void release(MagicRingBuffer* ring);
+
+    /**
+     * @brief 预先创建环形缓冲区，避免上线后首次使用时的映射开销
+     * @param size 档位大小
+     * @param count 预先创建的数量
+     */
+    void prewarm(size_t size, size_t count);
+
+    /**
+     * @brief 计算 size 所属档位的容量
+     * @param size 需要的容量
+     * @return 不小于 size 的页大小的 2 的幂倍
+     */
+    static size_t class_size(size_t size);
+
+private:
+    /**
+     * @brief 计算档位下标
+     */
+    static size_t class_index(size_t class_size);
+
+    size_t max_cached_per_class_;                           // 每档最多缓存数量
+    std::vector<std::vector<MagicRingBuffer*>> free_lists_; // 各档位的空闲列表
+    std::mutex mutex_;                                      // 空闲列表互斥锁
+};
+
+#endif // MAGIC_RING_BUFFER_H
@@ -0,0 +1,127 @@
+/**
+ * @file memory_budget.h
+ * @brief 内存预算与用量统计类的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 网络库持有的所有缓冲内存（输入缓冲区、输出缓冲区、投递到事件循环的任务）
+ * 都按类别记账到同一个 MemoryBudget 中：
+ * - 各类别的当前用量、总用量和历史峰值可作为监控指标（gauge）读取
+ * - 可配置全局上限，由上层在超限时执行相应的处理策略
+ *
+ * 记账只使用原子计数，不加锁，可在任意线程调用。
+ *
+ * @example
+ * @code
+ * MemoryBudget budget(64 * 1024 * 1024);
+ * if (budget.would_exceed(length)) {
+ *     // 执行超限策略
+ * }
+ * budget.charge(MemoryBudget::Category::Output, length);
+ * // ...
+ * budget.release(MemoryBudget::Category::Output, length);
+ * @endcode
+ */
+
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class MemoryBudget
+ * @brief 按类别记账的内存预算
+ */
+class MemoryBudget {
+public:
+    /**
+     * @brief 内存类别
+     */
+    enum class Category {
+        Input = 0,  ///< 输入缓冲区（半包）
+        Output,     ///< 输出缓冲区（待发送数据）
+        Task        ///< 投递到事件循环、尚未执行的任务
+    };
+
+    /// @brief 类别数量
+    static constexpr size_t CATEGORY_COUNT = 3;
+
+    /**
+     * @brief 构造函数
+     * @param limit 全局上限（字节），0 表示不限制
+     */
+    explicit MemoryBudget(size_t limit = 0);
+
+    /// @brief 禁止拷贝构造
+    MemoryBudget(const MemoryBudget&) = delete;
+    /// @brief 禁止拷贝赋值
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * @brief 设置全局上限
+     * @param limit 上限（字节），0 表示不限制
+     */
+    void set_limit(size_t limit) { limit_.store(limit, std::memory_order_relaxed); }
+
+    /**
+     * @brief 全局上限，0 表示不限制
+     */
+    size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 记入一笔用量
+     * @param category 内存类别
+     * @param bytes 字节数
+     *
+     * @details 无条件记账，是否允许超限由调用方先通过 would_exceed() 判断
+     */
+    void charge(Category category, size_t bytes);
+
+    /**
+     * @brief 扣除一笔用量
+     * @param category 内存类别
+     * @param bytes 字节数，必须与之前记入的一致
+     */
+    void release(Category category, size_t bytes);
+
+    /**
+     * @brief 再记入 bytes 字节后是否会超过全局上限
+     * @param bytes 将要记入的字节数
+     * @return true 会超限，false 不会超限或未设置上限
+     */
+    bool would_exceed(size_t bytes) const;
+
+    /**
+     * @brief 当前是否已超过全局上限
+     */
+    bool exceeded() const { return would_exceed(0); }
+
+    /**
+     * @brief 当前总用量
+     */
+    size_t used() const { return total_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 指定类别的当前用量
+     * @param category 内存类别
+     */
+    size_t used(Category category) const {
+        return used_[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 总用量的历史峰值
+     */
+    size_t peak() const { return peak_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> limit_;                                 // 全局上限
+    std::array<std::atomic<size_t>, CATEGORY_COUNT> used_;      // 各类别用量
+    std::atomic<size_t> total_;                                 // 总用量
+    std::atomic<size_t> peak_;                                  // 总用量峰值
+};
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,95 @@
+/**
+ * @file mpsc_queue.h
+ * @brief 无锁多生产者单消费者（MPSC）侵入式队列的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 生产者用一次 CAS 把节点压到链表头部；消费者用一次 exchange 取走整条链表，
+ * 再原地反转为先进先出顺序。push() 返回队列此前是否为空，调用方据此只在
+ * 空→非空的转换时唤醒消费者，一批突发投递只需一次唤醒。
+ *
+ * 节点由调用方分配和释放，只需要提供 `Node* next` 成员。
+ *
+ * @example
+ * @code
+ * struct Item { Item* next; int value; };
+ * MpscQueue<Item> queue;
+ * if (queue.push(new Item{nullptr, 1})) {
+ *     wake_consumer();
+ * }
+ * for (Item* item = queue.take_all(); item; ) {
+ *     Item* next = item->next;
+ *     delete item;
+ *     item = next;
+ * }
+ * @endcode
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+
+/**
+ * @class MpscQueue
+ * @brief 侵入式无锁 MPSC 队列
+ * @tparam Node 节点类型，必须有 `Node* next` 成员
+ *
+ * @details
+ * 只支持整体取出，不存在单个弹出时的 ABA 问题。投递与取出使用顺序一致的原子操作，
+ * 与调用方的唤醒标志组成全序，保证合并唤醒时不会漏掉节点。
+ */
+template <typename Node>
+class MpscQueue {
+public:
+    MpscQueue() : head_(nullptr) {}
+
+    /// @brief 禁止拷贝构造
+    MpscQueue(const MpscQueue&) = delete;
+    /// @brief 禁止拷贝赋值
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * @brief 投递节点
+     * @param node 节点，投递后归消费者所有
+     * @return true 投递前队列为空（调用方应唤醒消费者），false 队列中已有节点
+     *
+     * @note 该函数是线程安全的，无锁
+     */
+    bool push(Node* node) {
+        Node* head = head_.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(head, node));
+        return head == nullptr;
+    }
+
+    /**
+     * @brief 取出全部节点（只能由消费者线程调用）
+     * @return 按投递顺序链接的节点链表，队列为空时返回 nullptr
+     */
+    Node* take_all() {
+        Node* node = head_.exchange(nullptr);
+        Node* reversed = nullptr;
+        while (node) {
+            Node* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+        return reversed;
+    }
+
+    /**
+     * @brief 队列当前是否为空（仅供参考）
+     */
+    bool empty() const {
+        return head_.load(std::memory_order_relaxed) == nullptr;
+    }
+
+private:
+    std::atomic<Node*> head_;   // 最近投递的节点
+};
+
+#endif // MPSC_QUEUE_H
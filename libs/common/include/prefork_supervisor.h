@@ -0,0 +1,284 @@
+/**
+ * @file prefork_supervisor.h
+ * @brief 预先 fork 的多进程服务器监督者的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 用 N 个工作进程代替 N 个线程，获得故障隔离，并避开分配器和锁的跨线程争用：
+ * - 监督者（父进程）fork 出 N 个工作进程，每个进程运行同一个入口函数，
+ *   通常在其中创建开启 SO_REUSEPORT 的 TcpServer/UdpServer，由内核在各进程的监听 socket 之间分配连接和数据报
+ * - 工作进程因信号或非零退出码结束时视为崩溃，按退避间隔重新 fork；返回 0 视为正常结束，不再重启
+ * - 各工作进程把指标写入 fork 之前映射的共享内存（每个进程一个槽位），
+ *   父进程无需任何 IPC 即可随时汇总
+ *
+ * 指标分两类：计数器（只增，工作进程重启后继续累加，不会因崩溃丢失已计入的值）
+ * 和瞬时值（如当前连接数，工作进程结束时由监督者清零）。
+ *
+ * @note fork 只复制调用线程，run() 应在创建其他线程之前调用；工作进程中的入口函数
+ *       自行创建服务器和线程。该类不可拷贝和移动
+ *
+ * @example
+ * @code
+ * enum { MESSAGES = 0 };      // 计数器下标
+ * enum { CONNECTIONS = 0 };   // 瞬时值下标
+ *
+ * PreforkSupervisor supervisor([](PreforkSupervisor::Worker& worker) {
+ *     TcpServer server("0.0.0.0", 8080, 1);
+ *     server.set_reuse_port(true);
+ *     server.set_message_callback([&](int fd, const std::string& message) {
+ *         worker.add(MESSAGES, 1);
+ *         server.send_to(fd, message);
+ *     });
+ *     if (!server.start()) {
+ *         return 1;
+ *     }
+ *     while (worker.wait(std::chrono::milliseconds(100))) {
+ *         worker.set(CONNECTIONS, server.connection_count());
+ *     }
+ *     return 0;
+ * });
+ * supervisor.run();
+ * @endcode
+ */
+
+#ifndef PREFORK_SUPERVISOR_H
+#define PREFORK_SUPERVISOR_H
+
+#include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PreforkSupervisor
+ * @brief fork 并看护一组工作进程，通过共享内存汇总它们的指标
+ */
+class PreforkSupervisor {
+    struct Slot;    // 共享内存中每个工作进程的槽位，定义在实现文件中
+
+public:
+    /// @brief 每个工作进程的计数器数量
+    static constexpr size_t MAX_COUNTERS = 16;
+
+    /// @brief 每个工作进程的瞬时值数量
+    static constexpr size_t MAX_GAUGES = 16;
+
+    /**
+     * @brief 监督者配置
+     */
+    struct Options {
+        size_t workers = 0;                                     ///< 工作进程数量，0 表示本进程允许运行的 CPU 数
+        std::chrono::milliseconds restart_delay{100};           ///< 崩溃后首次重启前的等待时间
+        std::chrono::milliseconds max_restart_delay{5000};      ///< 连续崩溃时等待时间翻倍的上限
+        std::chrono::milliseconds stop_timeout{5000};           ///< 停止时等待工作进程退出的时间，超时后 SIGKILL
+    };
+
+    /**
+     * @class Worker
+     * @brief 工作进程中的上下文，指向该进程在共享内存中的槽位
+     */
+    class Worker {
+    public:
+        /**
+         * @brief 工作进程下标（0 ~ workers-1），重启后不变
+         */
+        size_t index() const { return index_; }
+
+        /**
+         * @brief 该槽位被重启的次数（首次启动为 0）
+         */
+        uint64_t restarts() const;
+
+        /**
+         * @brief 计数器加上 delta
+         * @param counter 计数器下标，必须小于 MAX_COUNTERS
+         * @param delta 增量
+         *
+         * @note 该函数是线程安全的，工作进程中的任意线程都可以调用
+         */
+        void add(size_t counter, uint64_t delta);
+
+        /**
+         * @brief 设置瞬时值
+         * @param gauge 瞬时值下标，必须小于 MAX_GAUGES
+         * @param value 新值
+         *
+         * @note 该函数是线程安全的
+         */
+        void set(size_t gauge, uint64_t value);
+
+        /**
+         * @brief 是否已收到停止请求（SIGTERM/SIGINT 或监督者退出）
+         */
+        bool stop_requested() const;
+
+        /**
+         * @brief 等待一段时间或直到收到停止请求
+         * @param timeout 最长等待时间
+         * @return true 继续运行，false 应该停止
+         */
+        bool wait(std::chrono::milliseconds timeout) const;
+
+    private:
+        friend class PreforkSupervisor;
+
+        Worker(size_t index, Slot* slot) : index_(index), slot_(slot) {}
+
+        size_t index_;      // 工作进程下标
+        Slot* slot_;        // 共享内存中的槽位
+    };
+
+    /**
+     * @brief 工作进程入口函数类型
+     * @return 进程退出码，0 表示正常结束（不会被重启）
+     */
+    using WorkerMain = std::function<int(Worker& worker)>;
+
+    /**
+     * @brief 单个工作进程的状态
+     */
+    struct WorkerStatus {
+        pid_t pid = 0;                  ///< 进程号，0 表示当前没有运行
+        uint64_t restarts = 0;          ///< 崩溃后被重启的次数
+    };
+
+    /**
+     * @brief 全部工作进程的汇总指标
+     */
+    struct Metrics {
+        size_t running = 0;                             ///< 正在运行的工作进程数
+        uint64_t restarts = 0;                          ///< 累计重启次数
+        uint64_t counters[MAX_COUNTERS] = {};           ///< 各计数器之和
+        uint64_t gauges[MAX_GAUGES] = {};               ///< 各瞬时值之和
+    };
+
+    /**
+     * @brief 汇总报告回调类型（在 run() 的调用线程中执行）
+     */
+    using ReportHandler = std::function<void(const Metrics& metrics)>;
+
+    /**
+     * @brief 构造函数
+     * @param main 工作进程入口函数
+     * @param options 监督者配置
+     *
+     * @details 映射共享内存槽位；映射失败时 run() 直接返回失败
+     */
+    PreforkSupervisor(WorkerMain main, const Options& options);
+
+    /**
+     * @brief 使用默认配置构造（每个 CPU 一个工作进程）
+     * @param main 工作进程入口函数
+     */
+    explicit PreforkSupervisor(WorkerMain main) : PreforkSupervisor(std::move(main), Options{}) {}
+
+    /**
+     * @brief 析构函数
+     * @details 解除共享内存映射，必须在 run() 返回之后析构
+     */
+    ~PreforkSupervisor();
+
+    /// @brief 禁止拷贝构造
+    PreforkSupervisor(const PreforkSupervisor&) = delete;
+    /// @brief 禁止拷贝赋值
+    PreforkSupervisor& operator=(const PreforkSupervisor&) = delete;
+    /// @brief 禁止移动构造
+    PreforkSupervisor(PreforkSupervisor&&) = delete;
+    /// @brief 禁止移动赋值
+    PreforkSupervisor& operator=(PreforkSupervisor&&) = delete;
+
+    /**
+     * @brief 设置定期汇总报告
+     * @param interval 报告间隔
+     * @param handler 报告回调
+     *
+     * @note 必须在 run() 之前调用
+     */
+    void set_report_handler(std::chrono::milliseconds interval, ReportHandler handler);
+
+    /**
+     * @brief fork 工作进程并看护，直到 stop() 被调用或全部工作进程正常结束
+     * @return true 正常停止，false 共享内存映射或 fork 失败
+     *
+     * @details 阻塞调用线程。停止时向所有工作进程发送 SIGTERM，
+     *          超过 stop_timeout 仍未退出的发送 SIGKILL
+     */
+    bool run();
+
+    /**
+     * @brief 请求停止
+     *
+     * @note 只写一个原子标志，可以在信号处理函数或其他线程中调用
+     */
+    void stop() { stopping_.store(true, std::memory_order_relaxed); }
+
+    /**
+     * @brief 汇总各工作进程的指标
+     *
+     * @note 该函数是线程安全的，只读取共享内存
+     */
+    Metrics metrics() const;
+
+    /**
+     * @brief 各工作进程的状态
+     * @return 按下标排列的状态
+     */
+    std::vector<WorkerStatus> workers() const;
+
+    /**
+     * @brief 工作进程数量
+     */
+    size_t worker_count() const { return worker_count_; }
+
+private:
+    /**
+     * @brief fork 一个工作进程
+     * @param index 工作进程下标
+     * @return true 成功，false fork 失败
+     */
+    bool spawn(size_t index);
+
+    /**
+     * @brief 在子进程中运行入口函数并退出（不返回）
+     * @param index 工作进程下标
+     */
+    [[noreturn]] void worker_main(size_t index);
+
+    /**
+     * @brief 回收已退出的工作进程，崩溃的安排重启
+     * @param now 当前时间
+     */
+    void reap(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief 向运行中的工作进程发送 SIGTERM 并等待退出
+     */
+    void stop_workers();
+
+    /**
+     * @brief 获取槽位
+     */
+    Slot* slot(size_t index) const;
+
+    WorkerMain main_;                                   // 工作进程入口函数
+    Options options_;                                   // 监督者配置
+    size_t worker_count_;                               // 工作进程数量
+    void* shared_;                                      // 共享内存起始地址，失败时为 nullptr
+    size_t shared_size_;                                // 共享内存大小
+    pid_t parent_pid_;                                  // 监督者进程号
+    std::atomic<bool> stopping_;                        // 停止标志
+
+    std::chrono::milliseconds report_interval_;         // 汇总报告间隔
+    ReportHandler report_handler_;                      // 汇总报告回调
+
+    std::vector<std::chrono::milliseconds> delays_;     // 各槽位下一次重启的等待时间
+    std::vector<std::chrono::steady_clock::time_point> restart_at_; // 各槽位计划重启的时刻，未计划时为默认值
+    std::vector<std::chrono::steady_clock::time_point> started_at_; // 各槽位最近一次启动的时刻
+};
+
+#endif // PREFORK_SUPERVISOR_H
@@ -0,0 +1,192 @@
+/**
+ * @file rcu.h
+ * @brief 基于纪元（epoch）的 RCU 与可热替换的单值容器的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 用于在服务运行期间无锁地替换回调等只读配置：
+ * - 读者用 Rcu::ReadGuard 标记读临界区，区内通过 RcuCell::load() 取得当前值，
+ *   每次读取只是一次 acquire 加载，没有锁，也没有引用计数
+ * - 写者用 RcuCell::store() 发布新值，旧值在宽限期（所有进入时刻早于发布的
+ *   读临界区都已退出）之后才释放
+ *
+ * ReadGuard 可以嵌套，只有最外层进入时需要一次内存屏障。事件循环和接收线程
+ * 按每次唤醒进入一次读临界区，其中每条消息的回调只付出嵌套计数的开销。
+ *
+ * @example
+ * @code
+ * RcuCell<std::function<void(int)>> callback;
+ * callback.store([](int v) { ... });          // 任意线程，任意时刻
+ *
+ * Rcu::ReadGuard guard;                        // 读者线程
+ * const auto* fn = callback.load();
+ * if (fn && *fn) (*fn)(42);
+ * @endcode
+ */
+
+#ifndef RCU_H
+#define RCU_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Rcu
+ * @brief 全局 RCU 域：读临界区标记与宽限期等待
+ *
+ * @details
+ * 每个读者线程首次进入读临界区时登记一个按缓存行对齐的槽位，记录进入时的纪元；
+ * 线程退出后槽位回收复用。写者推进全局纪元，并等待（或检查）所有槽位
+ * 都已退出旧纪元的读临界区。
+ */
+class Rcu {
+public:
+    /**
+     * @class ReadGuard
+     * @brief 读临界区（RAII），可以嵌套
+     */
+    class ReadGuard {
+    public:
+        ReadGuard() { Rcu::read_lock(); }
+        ~ReadGuard() { Rcu::read_unlock(); }
+
+        /// @brief 禁止拷贝构造
+        ReadGuard(const ReadGuard&) = delete;
+        /// @brief 禁止拷贝赋值
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    /**
+     * @brief 进入读临界区
+     */
+    static void read_lock();
+
+    /**
+     * @brief 退出读临界区
+     */
+    static void read_unlock();
+
+    /**
+     * @brief 当前线程是否处于读临界区
+     */
+    static bool in_read_section();
+
+    /**
+     * @brief 推进全局纪元
+     * @return 新纪元；此后进入的读者都能看到推进前发布的数据
+     */
+    static uint64_t advance();
+
+    /**
+     * @brief 检查 epoch 的宽限期是否已过（不阻塞）
+     * @param epoch advance() 返回的纪元
+     * @return true 所有早于 epoch 进入的读临界区都已退出
+     */
+    static bool grace_passed(uint64_t epoch);
+
+    /**
+     * @brief 等待宽限期结束
+     *
+     * @details 阻塞到调用前已进入的所有读临界区都退出。
+     *          不能在读临界区内调用，否则会等待自己
+     */
+    static void synchronize();
+};
+
+/**
+ * @class RcuCell
+ * @brief 可被无锁读取、随时替换的单个值
+ * @tparam T 值类型
+ *
+ * @details 读者必须在 Rcu::ReadGuard 内调用 load()，并且不能把指针带出读临界区
+ */
+template <typename T>
+class RcuCell {
+public:
+    RcuCell() : current_(nullptr) {}
+
+    /**
+     * @brief 构造函数
+     * @param value 初始值
+     */
+    explicit RcuCell(T value) : current_(new T(std::move(value))) {}
+
+    /**
+     * @brief 析构函数
+     * @details 调用方必须保证此时已没有读者
+     */
+    ~RcuCell() {
+        delete current_.load(std::memory_order_relaxed);
+        for (auto& retired : retired_) {
+            delete retired.second;
+        }
+    }
+
+    /// @brief 禁止拷贝构造
+    RcuCell(const RcuCell&) = delete;
+    /// @brief 禁止拷贝赋值
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    /**
+     * @brief 读取当前值（必须处于读临界区）
+     * @return 当前值的指针，未设置时为 nullptr
+     */
+    const T* load() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 发布新值
+     * @param value 新值
+     *
+     * @details
+     * 读临界区外调用时等待宽限期后立即释放旧值；在读临界区内调用（例如在回调中
+     * 替换回调）时不能等待自己，旧值挂入待回收列表，由之后的 store() 或析构释放。
+     *
+     * @note 该函数是线程安全的
+     */
+    void store(T value) {
+        T* previous = current_.exchange(new T(std::move(value)), std::memory_order_acq_rel);
+
+        if (Rcu::in_read_section()) {
+            uint64_t epoch = Rcu::advance();
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            if (previous) {
+                retired_.emplace_back(epoch, previous);
+            }
+            reclaim_locked();
+            return;
+        }
+
+        Rcu::synchronize();
+        delete previous;
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        reclaim_locked();
+    }
+
+private:
+    /**
+     * @brief 释放宽限期已过的旧值（需持有 retired_mutex_）
+     */
+    void reclaim_locked() {
+        size_t kept = 0;
+        for (auto& retired : retired_) {
+            if (Rcu::grace_passed(retired.first)) {
+                delete retired.second;
+            } else {
+                retired_[kept++] = retired;
+            }
+        }
+        retired_.resize(kept);
+    }
+
+    std::atomic<T*> current_;                           // 当前值
+    std::mutex retired_mutex_;                          // 待回收列表互斥锁
+    std::vector<std::pair<uint64_t, T*>> retired_;      // 待回收的旧值及其纪元
+};
+
+#endif // RCU_H
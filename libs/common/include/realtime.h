@@ -0,0 +1,124 @@
+/**
+ * @file realtime.h
+ * @brief 实时调度、内存锁定与线程栈预缺页的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 延迟的长尾主要来自两类停顿：线程被其他任务抢占，以及首次访问内存时的缺页。
+ * 本文件提供三项可选措施：
+ * - 把 I/O 线程和工作线程切换到 SCHED_FIFO，并按角色使用不同的优先级
+ * - mlockall(MCL_CURRENT | MCL_FUTURE)，锁定已有和之后映射的内存，避免换出与再次缺页
+ * - 线程启动时预写入一段栈，处理消息时不再在栈上触发缺页
+ *
+ * 没有权限时（缺少 CAP_SYS_NICE / CAP_IPC_LOCK，或 RLIMIT_RTPRIO / RLIMIT_MEMLOCK 不足）
+ * 不会失败：线程保持普通调度继续运行，每类失败只打印一次警告，
+ * 全部结果记录在进程级的状态中，可随时通过 status() / report() 查看。
+ *
+ * @note SCHED_FIFO 线程在有工作时不会让出 CPU，与忙轮询一起使用时必须为这些线程
+ *       预留专用的 CPU，否则同一 CPU 上的普通线程只能依靠内核的实时限流获得运行时间
+ *
+ * @example
+ * @code
+ * RealtimeOptions options;
+ * options.enabled = true;
+ *
+ * UdpServer server("0.0.0.0", 9000, 2);
+ * server.set_realtime(options);                                  // 接收线程使用 io_priority
+ * ThreadPool workers(4, Realtime::worker_init(options));         // 工作线程使用 worker_priority
+ * server.start();
+ * std::cout << Realtime::report() << std::endl;
+ * @endcode
+ */
+
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/**
+ * @struct RealtimeOptions
+ * @brief 实时化配置
+ */
+struct RealtimeOptions {
+    bool enabled = false;                   ///< 是否启用
+    int io_priority = 50;                   ///< I/O 线程（事件循环、接收线程）的 SCHED_FIFO 优先级，0 表示保持普通调度
+    int worker_priority = 40;               ///< 工作线程（线程池、执行器）的 SCHED_FIFO 优先级，0 表示保持普通调度
+    bool lock_memory = true;                ///< 首个线程配置时对整个进程 mlockall
+    size_t stack_prefault = 256 * 1024;     ///< 每个线程启动时预写入的栈字节数，0 表示不预写入
+};
+
+/**
+ * @struct RealtimeStatus
+ * @brief 进程内实时化措施的累计结果
+ */
+struct RealtimeStatus {
+    bool memory_locked = false;             ///< mlockall 是否成功
+    int memory_error = 0;                   ///< mlockall 失败时的 errno，未尝试或成功时为 0
+    size_t realtime_threads = 0;            ///< 成功切换为 SCHED_FIFO 的线程数（累计）
+    size_t fallback_threads = 0;            ///< 切换失败、保持普通调度的线程数（累计）
+    int thread_error = 0;                   ///< 最近一次切换失败的 errno
+    size_t prefaulted_bytes = 0;            ///< 已预写入的栈字节数（所有线程累计）
+};
+
+/**
+ * @class Realtime
+ * @brief 实时化措施的静态工具函数，结果记入进程级状态
+ */
+class Realtime {
+public:
+    /**
+     * @brief 按配置实时化调用线程
+     * @param options 实时化配置，未启用时什么也不做
+     * @param priority SCHED_FIFO 优先级（按系统范围截断），0 表示保持普通调度
+     * @return true 全部措施成功（或未启用），false 至少一项退化
+     *
+     * @details 依次：进程内首次调用时 mlockall（lock_memory 为 true 时），切换调度策略，预写入栈
+     */
+    static bool configure_current_thread(const RealtimeOptions& options, int priority);
+
+    /**
+     * @brief 以 io_priority 实时化调用线程
+     * @param options 实时化配置
+     * @return 同 configure_current_thread()
+     */
+    static bool configure_io_thread(const RealtimeOptions& options) {
+        return configure_current_thread(options, options.io_priority);
+    }
+
+    /**
+     * @brief 生成线程池的线程初始化函数，以 worker_priority 实时化每个工作线程
+     * @param options 实时化配置
+     * @return 可传给 ThreadPool 构造函数的初始化函数，未启用时为空
+     */
+    static std::function<void(size_t)> worker_init(const RealtimeOptions& options);
+
+    /**
+     * @brief 锁定进程的全部内存（只尝试一次，之后直接返回首次的结果）
+     * @return true 已锁定，false 失败（原因见 status().memory_error）
+     */
+    static bool lock_memory();
+
+    /**
+     * @brief 预写入调用线程的栈
+     * @param bytes 期望预写入的字节数，超过剩余栈空间时截断
+     * @return 实际预写入的字节数
+     */
+    static size_t prefault_stack(size_t bytes);
+
+    /**
+     * @brief 获取累计状态
+     *
+     * @note 该函数是线程安全的
+     */
+    static RealtimeStatus status();
+
+    /**
+     * @brief 生成可读的状态报告（多行），失败项附带所需的权限或资源限制
+     */
+    static std::string report();
+};
+
+#endif // REALTIME_H
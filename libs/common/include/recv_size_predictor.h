@@ -0,0 +1,75 @@
+/**
+ * @file recv_size_predictor.h
+ * @brief 自适应接收缓冲区大小预测器的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 参考 Netty 的 AdaptiveRecvByteBufAllocator：
+ * - 预先生成一张递增的大小表（16 ~ 496 按 16 递增，之后按 2 倍递增）
+ * - 一次读取填满了缓冲区，说明数据还多，下一次大小立刻跳升 4 档
+ * - 连续两次读取都明显小于当前大小，才下降 1 档
+ *
+ * 大流量连接很快得到大缓冲区以减少系统调用次数；小消息连接的缓冲区
+ * 会慢慢缩小以节省内存。每个预测器只占 4 个字节，适合按连接保存。
+ *
+ * @example
+ * @code
+ * RecvSizePredictor predictor;
+ * size_t size = predictor.next_size();
+ * ssize_t n = recv(fd, buffer, size, 0);
+ * predictor.record(n);
+ * @endcode
+ */
+
+#ifndef RECV_SIZE_PREDICTOR_H
+#define RECV_SIZE_PREDICTOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class RecvSizePredictor
+ * @brief 根据历史读取量预测下一次接收缓冲区大小
+ */
+class RecvSizePredictor {
+public:
+    /// @brief 默认最小接收大小
+    static constexpr size_t DEFAULT_MINIMUM = 64;
+    /// @brief 默认初始接收大小
+    static constexpr size_t DEFAULT_INITIAL = 2048;
+    /// @brief 默认最大接收大小
+    static constexpr size_t DEFAULT_MAXIMUM = 65536;
+
+    /**
+     * @brief 构造函数，使用默认的最小/初始/最大大小
+     */
+    RecvSizePredictor();
+
+    /**
+     * @brief 构造函数
+     * @param minimum 最小接收大小
+     * @param initial 初始接收大小
+     * @param maximum 最大接收大小
+     */
+    RecvSizePredictor(size_t minimum, size_t initial, size_t maximum);
+
+    /**
+     * @brief 获取下一次接收应使用的缓冲区大小
+     */
+    size_t next_size() const;
+
+    /**
+     * @brief 记录一次实际读取的字节数，并调整下一次的大小
+     * @param bytes_read 实际读取的字节数
+     */
+    void record(size_t bytes_read);
+
+private:
+    uint8_t min_index_;         // 最小大小在表中的下标
+    uint8_t max_index_;         // 最大大小在表中的下标
+    uint8_t index_;             // 当前大小在表中的下标
+    bool decrease_now_;         // 上一次读取是否已经偏小
+};
+
+#endif // RECV_SIZE_PREDICTOR_H
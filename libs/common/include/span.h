@@ -0,0 +1,46 @@
+/**
+ * @file span.h
+ * @brief 连续元素视图的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * C++17 中没有 std::span，这里提供批量回调所需的最小实现：
+ * 只引用调用方的数组，不持有也不拷贝元素。
+ */
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+
+/**
+ * @class Span
+ * @brief 指向连续元素的只读视图
+ * @tparam T 元素类型
+ */
+template <typename T>
+class Span {
+public:
+    Span() : data_(nullptr), size_(0) {}
+
+    /**
+     * @brief 构造函数
+     * @param data 首元素地址
+     * @param size 元素数量
+     */
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t index) const { return data_[index]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+private:
+    T* data_;       // 首元素地址
+    size_t size_;   // 元素数量
+};
+
+#endif // SPAN_H
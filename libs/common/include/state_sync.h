@@ -0,0 +1,253 @@
+/**
+ * @file state_sync.h
+ * @brief 基于已确认基线的状态增量同步的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 用于高频广播整份状态快照（持仓、报价等）而大部分字段在相邻两次之间不变的场景：
+ * - 服务端 StateSyncEncoder 保存最近若干份快照，并记录每个客户端已确认（ack）的序号
+ * - 每次广播时，对每个客户端以其已确认的快照为基线，只发送按字节异或得到的变化区段
+ * - 基线不在历史中（新连接、重连、确认落后太多或客户端报告丢失）时发送完整快照
+ * - 客户端 StateSyncDecoder 保存最近若干份已应用的快照，按消息中的基线序号还原
+ *
+ * 基线总是客户端已确认的快照而不是上一次发送的快照，因此中间的消息即使被丢弃
+ * （如过期、低优先级被丢弃或 UDP 丢包），后续增量仍然可以解码。
+ *
+ * 编码器与传输无关：确认消息的格式由应用协议决定，广播时通过回调交给
+ * TcpServer::send_to、UdpServer::send_to 等发送。
+ *
+ * 消息格式（整数均为大端序）：
+ * @code
+ * [1B 类型: 1 完整 / 2 增量][8B 序号][8B 基线序号，完整快照为 0][4B 快照长度]
+ * 完整: [快照内容]
+ * 增量: 若干个 [varint 跳过的字节数][varint 区段长度][区段内新旧字节的异或]
+ * @endcode
+ *
+ * @example
+ * @code
+ * // 服务端
+ * StateSyncEncoder encoder;
+ * server.set_connection_callback([&](int fd, const std::string&) { encoder.add_client(fd); });
+ * server.set_disconnect_callback([&](int fd) { encoder.remove_client(fd); });
+ * // 客户端回复 "ACK <seq>" 或 "RESET"
+ * server.set_message_callback([&](int fd, const std::string& msg) { ... encoder.acknowledge(fd, seq); });
+ *
+ * encoder.publish(snapshot);
+ * encoder.broadcast([&](uint64_t fd, std::string_view message) {
+ *     server.send_to(static_cast<int>(fd), message);
+ * });
+ *
+ * // 客户端
+ * StateSyncDecoder decoder;
+ * if (decoder.apply(data, length) == StateSyncDecoder::Result::Applied) {
+ *     use(decoder.state());
+ *     send_ack(decoder.sequence());
+ * }
+ * @endcode
+ */
+
+#ifndef STATE_SYNC_H
+#define STATE_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class StateSyncEncoder
+ * @brief 状态同步的服务端：保存快照历史与各客户端的已确认基线，生成增量
+ *
+ * @note 所有成员函数都是线程安全的
+ */
+class StateSyncEncoder {
+public:
+    /**
+     * @brief 构造函数
+     * @param history 保留的快照份数，客户端的确认落后超过该份数后改发完整快照
+     */
+    explicit StateSyncEncoder(size_t history = 32);
+
+    /// @brief 禁止拷贝构造
+    StateSyncEncoder(const StateSyncEncoder&) = delete;
+    /// @brief 禁止拷贝赋值
+    StateSyncEncoder& operator=(const StateSyncEncoder&) = delete;
+
+    /**
+     * @brief 发布一份新快照
+     * @param snapshot 快照内容
+     * @return 新快照的序号（从 1 开始递增）
+     */
+    uint64_t publish(std::string_view snapshot);
+
+    /**
+     * @brief 登记客户端（没有基线，下一次收到完整快照）
+     * @param client 客户端标识（如 fd 或编码后的地址）
+     */
+    void add_client(uint64_t client);
+
+    /**
+     * @brief 注销客户端
+     * @param client 客户端标识
+     */
+    void remove_client(uint64_t client);
+
+    /**
+     * @brief 记录客户端已应用的快照序号
+     * @param client 客户端标识
+     * @param sequence 已应用的序号；比当前记录旧的确认被忽略
+     */
+    void acknowledge(uint64_t client, uint64_t sequence);
+
+    /**
+     * @brief 清除客户端的基线（客户端报告无法解码或重连时调用），下一次发送完整快照
+     * @param client 客户端标识
+     */
+    void reset_client(uint64_t client);
+
+    /**
+     * @brief 为单个客户端编码最新快照
+     * @param client 客户端标识
+     * @param out 输出的消息
+     * @return true 已编码，false 客户端未登记、尚未发布快照或客户端已确认最新快照
+     */
+    bool encode(uint64_t client, std::string& out);
+
+    /**
+     * @brief 把最新快照发给所有需要更新的客户端
+     * @tparam Send 可调用对象，签名为 void(uint64_t client, std::string_view message)
+     * @param send 发送函数，在锁外调用
+     *
+     * @details 基线相同的客户端共享同一份编码结果，每个不同的基线只编码一次
+     */
+    template <typename Send>
+    void broadcast(Send&& send) {
+        std::vector<std::string> messages;
+        std::vector<std::pair<uint64_t, size_t>> targets;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (snapshots_.empty()) {
+                return;
+            }
+            uint64_t latest = snapshots_.back().sequence;
+            std::unordered_map<uint64_t, size_t> by_baseline;
+            for (const auto& [client, acked] : clients_) {
+                if (acked == latest) {
+                    continue;
+                }
+                uint64_t baseline = find_locked(acked) ? acked : 0;
+                auto [it, inserted] = by_baseline.try_emplace(baseline, messages.size());
+                if (inserted) {
+                    messages.emplace_back();
+                    encode_locked(baseline, messages.back());
+                }
+                targets.emplace_back(client, it->second);
+            }
+        }
+        for (const auto& [client, index] : targets) {
+            send(client, std::string_view(messages[index]));
+        }
+    }
+
+    /**
+     * @brief 最新快照的序号，尚未发布时为 0
+     */
+    uint64_t sequence() const;
+
+private:
+    /**
+     * @struct Snapshot
+     * @brief 一份已发布的快照
+     */
+    struct Snapshot {
+        uint64_t sequence;      // 序号
+        std::string data;       // 内容
+    };
+
+    /**
+     * @brief 按序号查找历史快照（需持有 mutex_）
+     * @return 快照指针，不在历史中（或序号为 0）时返回 nullptr
+     */
+    const Snapshot* find_locked(uint64_t sequence) const;
+
+    /**
+     * @brief 以 baseline 为基线编码最新快照（需持有 mutex_）
+     * @param baseline 基线序号，0 表示完整快照
+     * @param out 输出的消息
+     */
+    void encode_locked(uint64_t baseline, std::string& out) const;
+
+    size_t history_;                                    // 保留的快照份数
+    std::deque<Snapshot> snapshots_;                    // 快照历史，序号连续递增
+    std::unordered_map<uint64_t, uint64_t> clients_;    // 客户端 -> 已确认序号（0 表示没有基线）
+    mutable std::mutex mutex_;                          // 互斥锁
+};
+
+/**
+ * @class StateSyncDecoder
+ * @brief 状态同步的客户端：应用完整快照或增量，保存最近的快照作为可能的基线
+ *
+ * @note 该类不是线程安全的，应在接收线程中使用
+ */
+class StateSyncDecoder {
+public:
+    /**
+     * @brief apply() 的结果
+     */
+    enum class Result {
+        Applied,            ///< 已应用，state() 为新快照，应向服务端确认 sequence()
+        Stale,              ///< 序号不新于当前快照，已忽略
+        MissingBaseline,    ///< 找不到增量的基线，应请求服务端重置（reset_client）
+        Malformed           ///< 消息格式错误
+    };
+
+    /**
+     * @brief 构造函数
+     * @param history 保留的快照份数，应不小于服务端确认往返期间发布的快照数
+     */
+    explicit StateSyncDecoder(size_t history = 32);
+
+    /**
+     * @brief 应用一条同步消息
+     * @param data 消息起始地址
+     * @param length 消息长度
+     * @return 应用结果
+     */
+    Result apply(const char* data, size_t length);
+
+    /**
+     * @brief 当前快照内容（尚未收到时为空）
+     */
+    const std::string& state() const;
+
+    /**
+     * @brief 当前快照序号（尚未收到时为 0）
+     */
+    uint64_t sequence() const;
+
+    /**
+     * @brief 丢弃所有快照（如重连前调用）
+     */
+    void reset();
+
+private:
+    /**
+     * @struct Snapshot
+     * @brief 一份已应用的快照
+     */
+    struct Snapshot {
+        uint64_t sequence;      // 序号
+        std::string data;       // 内容
+    };
+
+    size_t history_;                    // 保留的快照份数
+    std::deque<Snapshot> snapshots_;    // 已应用的快照，最后一份为当前快照
+};
+
+#endif // STATE_SYNC_H
@@ -40,13 +40,20 @@
  */
 class ThreadPool {
 public:
+    /**
+     * @brief 线程初始化函数类型
+     * @param index 工作线程下标（0 ~ num_threads-1）
+     */
+    using ThreadInit = std::function<void(size_t index)>;
+    
     /**
      * @brief 构造函数，创建线程池
      * @param num_threads 工作线程数量，默认为 CPU 核心数
+     * @param init 线程初始化函数，在每个工作线程取任务之前调用一次（如调整调度策略、预写入栈），可为空
      * 
      * @details 创建指定数量的工作线程，并立即开始等待任务
      */
-    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency());
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency(), ThreadInit init = nullptr);
     
     /**
      * @brief 析构函数
@@ -0,0 +1,160 @@
+/**
+ * @file timestamping.h
+ * @brief 内核收发时间戳（SO_TIMESTAMPING）的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 用户态只能看到 recvmsg 返回和 send 调用的时刻，无法区分数据在内核中排队的时间与
+ * 用户态自身的处理时间。开启 SO_TIMESTAMPING 的软件时间戳后：
+ * - 接收：内核在协议栈收到数据包时打上时间戳，通过 recvmsg 控制信息中的
+ *   SCM_TIMESTAMPING 交给用户态（TCP 为本次读取的最后一个数据包的时间戳）
+ * - 发送：数据包交给网卡驱动时内核打上时间戳，连同 OPT_ID 分配的编号放入 socket 的
+ *   错误队列（MSG_ERRQUEUE），UDP 的编号为发送调用的序号，TCP 为该次发送最后一个字节的偏移
+ *
+ * 软件时间戳使用 CLOCK_REALTIME，因此与之比较的用户态时刻也用 realtime_ns() 读取。
+ * 由此得到三段延迟：
+ * - rx_queue：内核收包 → recvmsg 返回（socket 接收队列中的排队与线程唤醒）
+ * - rx_dispatch：recvmsg 返回 → 这批数据分发完毕（用户态处理）
+ * - tx_queue：发送调用 → 数据包交给驱动（协议栈、qdisc 中的排队）
+ *
+ * @note 只使用软件时间戳，不需要网卡支持，也不需要特权；硬件时间戳需要为网卡配置
+ *       SIOCSHWTSTAMP，不在本文件的范围内
+ */
+
+#ifndef TIMESTAMPING_H
+#define TIMESTAMPING_H
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include "histogram.h"
+
+/**
+ * @struct TimestampingOptions
+ * @brief 内核时间戳配置
+ */
+struct TimestampingOptions {
+    bool rx = false;        ///< 接收时间戳：记录 rx_queue / rx_dispatch，并随消息交付
+    bool tx = false;        ///< 发送时间戳：从错误队列读取，记录 tx_queue
+};
+
+/**
+ * @struct TxTimestamp
+ * @brief 错误队列中的一条发送时间戳
+ */
+struct TxTimestamp {
+    uint32_t id;            ///< OPT_ID 编号
+    int64_t ns;             ///< 内核时间戳（CLOCK_REALTIME，纳秒）
+};
+
+/**
+ * @struct WireLatencyStats
+ * @brief 三段延迟的摘要（纳秒）
+ */
+struct WireLatencyStats {
+    Histogram::Summary rx_queue;        ///< 内核收包 → recvmsg 返回
+    Histogram::Summary rx_dispatch;     ///< recvmsg 返回 → 分发完毕
+    Histogram::Summary tx_queue;        ///< 发送调用 → 内核发送时间戳
+    uint64_t tx_unmatched = 0;          ///< 对应不到发送调用（或延迟不合理）而丢弃的发送时间戳
+};
+
+/**
+ * @struct WireLatency
+ * @brief 三段延迟的直方图
+ */
+struct WireLatency {
+    Histogram rx_queue;                 ///< 内核收包 → recvmsg 返回
+    Histogram rx_dispatch;              ///< recvmsg 返回 → 分发完毕
+    Histogram tx_queue;                 ///< 发送调用 → 内核发送时间戳
+    std::atomic<uint64_t> tx_unmatched{0}; ///< 丢弃的发送时间戳
+
+    /**
+     * @brief 把另一组直方图累加进来
+     */
+    void merge(const WireLatency& other) {
+        rx_queue.merge(other.rx_queue);
+        rx_dispatch.merge(other.rx_dispatch);
+        tx_queue.merge(other.tx_queue);
+        tx_unmatched.fetch_add(other.tx_unmatched.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 生成摘要
+     */
+    WireLatencyStats stats() const {
+        WireLatencyStats stats;
+        stats.rx_queue = rx_queue.summary();
+        stats.rx_dispatch = rx_dispatch.summary();
+        stats.tx_queue = tx_queue.summary();
+        stats.tx_unmatched = tx_unmatched.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
+
+/**
+ * @class Timestamping
+ * @brief SO_TIMESTAMPING 的静态工具函数
+ */
+class Timestamping {
+public:
+    /// @brief recvmsg 控制信息缓冲区的大小，容纳 SCM_TIMESTAMPING 与 IP_RECVERR
+    static constexpr size_t CONTROL_SIZE = 128;
+
+    /// @brief 一次从错误队列读取的最大条数
+    static constexpr size_t TX_BATCH = 16;
+
+    /// @brief 超过该值（1 秒）的延迟视为编号错配，丢弃
+    static constexpr int64_t MAX_PLAUSIBLE_NS = 1000000000;
+
+    /**
+     * @brief 为 socket 开启软件时间戳
+     * @param fd socket 文件描述符（TCP 必须是已建立的连接，OPT_ID 不能设在监听 socket 上）
+     * @param options 时间戳配置，都未开启时什么也不做
+     * @return true 成功，false 失败（errno 为 setsockopt 的错误）
+     *
+     * @details 发送时间戳使用 OPT_ID | OPT_TSONLY：错误队列中只有编号和时间戳，不回传数据包内容。
+     *          TCP 连接必须在发送任何数据之前开启，编号才等于从 0 起算的字节偏移
+     */
+    static bool enable(int fd, const TimestampingOptions& options);
+
+    /**
+     * @brief 读取 CLOCK_REALTIME（纳秒），与软件时间戳同一时间轴
+     */
+    static int64_t realtime_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    /**
+     * @brief 从 recvmsg 的控制信息中取出接收时间戳
+     * @param msg recvmsg 填充的消息头（msg_control 指向至少 CONTROL_SIZE 字节）
+     * @return 内核时间戳（CLOCK_REALTIME，纳秒），没有时为 0
+     */
+    static int64_t rx_timestamp(const msghdr& msg);
+
+    /**
+     * @brief 不阻塞地从错误队列读取发送时间戳
+     * @param fd socket 文件描述符
+     * @param out 输出数组，至少 max 个元素
+     * @param max 最多读取的条数，不超过 TX_BATCH
+     * @param more 输出参数，取满 max 条、队列中可能还有剩余时为 true
+     * @return 读到的时间戳条数
+     *
+     * @details 一次 recvmmsg 取走最多 max 条；错误队列中其他来源的条目（如 ICMP 错误）被跳过
+     */
+    static size_t read_tx(int fd, TxTimestamp* out, size_t max, bool& more);
+
+    /**
+     * @brief 延迟是否在合理范围内（非负且不超过 MAX_PLAUSIBLE_NS）
+     */
+    static bool plausible(int64_t delay_ns) {
+        return delay_ns >= 0 && delay_ns <= MAX_PLAUSIBLE_NS;
+    }
+};
+
+#endif // TIMESTAMPING_H
@@ -0,0 +1,244 @@
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+/// @brief 当前线程的计数（零初始化，不需要动态初始化，可在 operator new 中安全使用）
+thread_local AllocCounters t_counters;
+
+/// @brief 进程级计数
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_deallocations{0};
+std::atomic<uint64_t> g_bytes{0};
+
+/// @brief 统计开关
+std::atomic<bool> g_enabled{true};
+
+/**
+ * @brief 记录一次分配
+ */
+void record_allocation(size_t size) {
+    if (!g_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    ++t_counters.allocations;
+    t_counters.bytes += size;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一次释放
+ */
+void record_deallocation(void* ptr) {
+    if (!ptr || !g_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    ++t_counters.deallocations;
+    g_deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 分配内存并计数
+ * @param size 字节数
+ * @param alignment 对齐要求，0 表示默认对齐
+ * @return 内存指针，失败时返回 nullptr
+ */
+void* allocate(size_t size, size_t alignment) {
+    if (size == 0) {
+        size = 1;
+    }
+
+    void* ptr = nullptr;
+    if (alignment == 0) {
+        ptr = std::malloc(size);
+    } else if (posix_memalign(&ptr, alignment, size) != 0) {
+        ptr = nullptr;
+    }
+
+    if (ptr) {
+        record_allocation(size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief 分配内存，失败时抛出 std::bad_alloc
+ */
+void* allocate_or_throw(size_t size, size_t alignment) {
+    void* ptr = allocate(size, alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+/**
+ * @brief 释放内存并计数
+ */
+void deallocate(void* ptr) {
+    record_deallocation(ptr);
+    std::free(ptr);
+}
+
+} // namespace
+
+// ============================================================================
+// 全局 operator new/delete 替换
+// ============================================================================
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(size, 0);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+// ============================================================================
+// AllocTracker / AllocRegion
+// ============================================================================
+
+/**
+ * @brief 当前线程的累计计数
+ */
+AllocCounters AllocTracker::thread_counters() {
+    return t_counters;
+}
+
+/**
+ * @brief 整个进程的累计计数
+ */
+AllocCounters AllocTracker::process_counters() {
+    AllocCounters counters;
+    counters.allocations = g_allocations.load(std::memory_order_relaxed);
+    counters.deallocations = g_deallocations.load(std::memory_order_relaxed);
+    counters.bytes = g_bytes.load(std::memory_order_relaxed);
+    return counters;
+}
+
+/**
+ * @brief 暂停或恢复统计
+ * @param enabled 是否统计
+ */
+void AllocTracker::set_enabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 当前是否在统计
+ */
+bool AllocTracker::is_enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 构造函数实现
+ * @param scope 统计范围
+ */
+AllocRegion::AllocRegion(Scope scope)
+    : scope_(scope)
+    , start_(current()) {
+}
+
+/**
+ * @brief 按统计范围读取当前计数
+ */
+AllocCounters AllocRegion::current() const {
+    return scope_ == Scope::Thread ? AllocTracker::thread_counters() : AllocTracker::process_counters();
+}
+
+/**
+ * @brief 区域开始以来发生的分配
+ * @return 计数差值
+ */
+AllocCounters AllocRegion::delta() const {
+    AllocCounters now = current();
+    AllocCounters delta;
+    delta.allocations = now.allocations - start_.allocations;
+    delta.deallocations = now.deallocations - start_.deallocations;
+    delta.bytes = now.bytes - start_.bytes;
+    return delta;
+}
+
+/**
+ * @brief 把当前计数重新设为起点
+ */
+void AllocRegion::reset() {
+    start_ = current();
+}
@@ -0,0 +1,304 @@
+#include "buffer_arena.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+/// @brief 大页大小（x86_64 / aarch64 默认的 PMD 大页）
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * @brief 将 value 向上取整到 alignment 的整数倍
+ */
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief 构造函数实现
+ * @param options 内存区域配置
+ *
+ * @details
+ * 映射顺序：
+ * 1. use_hugepages 时先尝试 MAP_HUGETLB（需要系统预留大页）
+ * 2. 失败则映射普通匿名内存，按大页对齐后 madvise(MADV_HUGEPAGE)
+ * 3. 按配置预写入并 mlock
+ */
+BufferArena::BufferArena(const Options& options)
+    : base_(nullptr)
+    , capacity_(0)
+    , mapped_size_(0)
+    , mapped_base_(nullptr)
+    , offset_(0)
+    , hugetlb_(false)
+    , locked_(false) {
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    int populate_flag = options.populate ? MAP_POPULATE : 0;
+
+    // 1. 尝试 hugetlbfs 大页
+    if (options.use_hugepages) {
+        size_t size = align_up(options.size, HUGE_PAGE_SIZE);
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate_flag, -1, 0);
+        if (addr != MAP_FAILED) {
+            mapped_base_ = static_cast<char*>(addr);
+            mapped_size_ = size;
+            base_ = mapped_base_;
+            capacity_ = size;
+            hugetlb_ = true;
+        }
+    }
+
+    // 2. 退回普通页（可选透明大页）
+    if (!base_) {
+        size_t size = align_up(options.size, options.use_hugepages ? HUGE_PAGE_SIZE : page_size);
+        // 透明大页需要 2MB 对齐，多映射一个大页用于对齐
+        size_t extra = options.use_hugepages ? HUGE_PAGE_SIZE : 0;
+        // THP 模式下 MAP_POPULATE 会先填充小页，改为 madvise 之后再预写入
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | (options.use_hugepages ? 0 : populate_flag);
+        void* addr = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (addr == MAP_FAILED) {
+            std::cerr << "[BufferArena] Failed to map " << size << " bytes: " << strerror(errno) << std::endl;
+            return;
+        }
+        mapped_base_ = static_cast<char*>(addr);
+        mapped_size_ = size + extra;
+        base_ = reinterpret_cast<char*>(align_up(reinterpret_cast<uintptr_t>(mapped_base_),
+                                                 options.use_hugepages ? HUGE_PAGE_SIZE : page_size));
+        capacity_ = size;
+
+        if (options.use_hugepages) {
+#ifdef MADV_HUGEPAGE
+            if (madvise(base_, capacity_, MADV_HUGEPAGE) < 0) {
+                std::cerr << "[BufferArena] madvise(MADV_HUGEPAGE) failed: " << strerror(errno) << std::endl;
+            }
+#endif
+            if (options.populate) {
+#ifdef MADV_POPULATE_WRITE
+                if (madvise(base_, capacity_, MADV_POPULATE_WRITE) < 0) {
+                    prefault(page_size);
+                }
+#else
+                prefault(page_size);
+#endif
+            }
+        }
+    }
+
+    // 3. 显式预写入
+    if (options.prefault) {
+        prefault(hugetlb_ ? HUGE_PAGE_SIZE : page_size);
+    }
+
+    // 4. 锁定物理内存
+    if (options.lock) {
+        if (mlock(base_, capacity_) == 0) {
+            locked_ = true;
+        } else {
+            std::cerr << "[BufferArena] mlock failed: " << strerror(errno) << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief 析构函数实现
+ */
+BufferArena::~BufferArena() {
+    if (!mapped_base_) {
+        return;
+    }
+    if (locked_) {
+        munlock(base_, capacity_);
+    }
+    munmap(mapped_base_, mapped_size_);
+}
+
+/**
+ * @brief 逐页写入
+ * @param page_size 步长
+ */
+void BufferArena::prefault(size_t page_size) {
+    volatile char* p = base_;
+    for (size_t offset = 0; offset < capacity_; offset += page_size) {
+        p[offset] = 0;
+    }
+}
+
+/**
+ * @brief 从区域中顺序分配
+ * @param size 字节数
+ * @param alignment 对齐要求
+ * @return 内存指针或 nullptr
+ */
+void* BufferArena::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!base_) {
+        return nullptr;
+    }
+
+    size_t offset = align_up(offset_, alignment);
+    if (offset + size > capacity_) {
+        return nullptr;
+    }
+
+    offset_ = offset + size;
+    return base_ + offset;
+}
+
+/**
+ * @brief 判断指针是否属于本区域
+ */
+bool BufferArena::owns(const void* ptr) const {
+    const char* p = static_cast<const char*>(ptr);
+    return base_ && p >= base_ && p < base_ + capacity_;
+}
+
+/**
+ * @brief 获取已分配字节数
+ */
+size_t BufferArena::used() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return offset_;
+}
+
+/**
+ * @brief 构造函数实现
+ * @param arena 内存来源
+ * @param block_size 缓冲块大小
+ * @param block_count 预切分数量
+ *
+ * @details 区域容量不足时只切分能放下的部分，其余在 acquire() 时退回堆分配
+ */
+BufferPool::BufferPool(BufferArena& arena, size_t block_size, size_t block_count)
+    : arena_(arena)
+    , block_size_(block_size) {
+    free_list_.reserve(block_count);
+    for (size_t i = 0; i < block_count; ++i) {
+        char* block = static_cast<char*>(arena_.allocate(block_size_));
+        if (!block) {
+            break;
+        }
+        free_list_.push_back(block);
+    }
+}
+
+/**
+ * @brief 获取缓冲块
+ * @return 缓冲块指针
+ */
+char* BufferPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_list_.empty()) {
+            char* block = free_list_.back();
+            free_list_.pop_back();
+            return block;
+        }
+    }
+
+    // 池已耗尽，退回堆分配
+    return new char[block_size_];
+}
+
+/**
+ * @brief 归还缓冲块
+ * @param block 缓冲块指针
+ */
+void BufferPool::release(char* block) {
+    if (!block) {
+        return;
+    }
+
+    // 堆上分配的块直接释放
+    if (!arena_.owns(block)) {
+        delete[] block;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_list_.push_back(block);
+}
+
+/**
+ * @brief 获取空闲缓冲块数量
+ */
+size_t BufferPool::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_list_.size();
+}
+
+/**
+ * @brief 构造函数实现
+ * @param arena 内存来源
+ * @param bytes_per_class 每个档位预先切分的字节数
+ */
+SizeClassPool::SizeClassPool(BufferArena& arena, size_t bytes_per_class) {
+    pools_.reserve(CLASS_COUNT);
+    for (size_t size = MIN_CLASS_SIZE; size <= MAX_CLASS_SIZE; size <<= 1) {
+        size_t count = bytes_per_class / size;
+        pools_.push_back(std::make_unique<BufferPool>(arena, size, count > 0 ? count : 1));
+    }
+}
+
+/**
+ * @brief 计算档位大小
+ * @param size 需要的字节数
+ * @return 档位大小
+ */
+size_t SizeClassPool::class_size(size_t size) {
+    if (size > MAX_CLASS_SIZE) {
+        return size;
+    }
+    size_t result = MIN_CLASS_SIZE;
+    while (result < size) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief 计算档位下标
+ * @param class_size 档位大小
+ * @return 下标
+ */
+size_t SizeClassPool::class_index(size_t class_size) {
+    size_t index = 0;
+    for (size_t size = MIN_CLASS_SIZE; size < class_size; size <<= 1) {
+        ++index;
+    }
+    return index;
+}
+
+/**
+ * @brief 获取缓冲块
+ * @param size 需要的字节数
+ * @param capacity 输出实际容量
+ * @return 缓冲块指针
+ */
+char* SizeClassPool::acquire(size_t size, size_t& capacity) {
+    capacity = class_size(size);
+    if (capacity > MAX_CLASS_SIZE) {
+        return new char[capacity];
+    }
+    return pools_[class_index(capacity)]->acquire();
+}
+
+/**
+ * @brief 归还缓冲块
+ * @param block 缓冲块指针
+ * @param capacity 缓冲块容量
+ */
+void SizeClassPool::release(char* block, size_t capacity) {
+    if (!block) {
+        return;
+    }
+    if (capacity > MAX_CLASS_SIZE) {
+        delete[] block;
+        return;
+    }
+    pools_[class_index(capacity)]->release(block);
+}
@@ -0,0 +1,64 @@
+#include "busy_poll.h"
+#include "clock.h"
+
+#include <sys/socket.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+/// @brief 空转时每隔多少次读取一次时钟
+constexpr uint32_t CLOCK_CHECK_SPINS = 64;
+
+/**
+ * @brief 本次不阻塞的轮询没有数据
+ *
+ * @details 空转开始时记下周期计数，之后每 CLOCK_CHECK_SPINS 次检查一次是否超时
+ */
+void BusyPoller::on_idle() {
+    if (!spinning_) {
+        return;
+    }
+    relax();
+    if (idle_timeout_ns_ == 0) {
+        return;
+    }
+
+    if (idle_spins_++ == 0) {
+        idle_since_ticks_ = Clock::ticks();
+        return;
+    }
+    if (idle_spins_ % CLOCK_CHECK_SPINS == 0 && Clock::elapsed_ns(idle_since_ticks_) >= idle_timeout_ns_) {
+        spinning_ = false;
+        idle_spins_ = 0;
+    }
+}
+
+/**
+ * @brief 按配置为 socket 设置内核忙轮询选项
+ * @param fd socket 文件描述符
+ * @param options 忙轮询配置
+ * @return 是否成功
+ */
+bool BusyPoller::apply_socket_options(int fd, const BusyPollOptions& options) {
+    if (!options.enabled) {
+        return true;
+    }
+    if (options.socket_busy_poll_us > 0) {
+        int value = options.socket_busy_poll_us;
+        if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) < 0) {
+            return false;
+        }
+    }
+    if (options.prefer_busy_poll) {
+        int one = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one)) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,133 @@
+#include "clock.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/// @brief 校准 TSC 频率的采样时长（纳秒）
+constexpr int64_t CALIBRATION_NS = 2000000;
+
+/// @brief 换算系数的定点小数位数
+constexpr unsigned MULT_SHIFT = 32;
+
+namespace {
+
+/**
+ * @struct Calibration
+ * @brief 周期计数器的频率与换算系数
+ */
+struct Calibration {
+    const char* source;     // 计数器来源
+    double hz;              // 每秒周期数
+    uint64_t mult;          // 每周期纳秒数，左移 MULT_SHIFT 位的定点数
+};
+
+/**
+ * @brief 按频率构造换算系数
+ */
+Calibration make_calibration(const char* source, double hz) {
+    Calibration calibration;
+    calibration.source = source;
+    calibration.hz = hz;
+    calibration.mult = static_cast<uint64_t>(1e9 / hz * static_cast<double>(uint64_t(1) << MULT_SHIFT));
+    return calibration;
+}
+
+/**
+ * @brief 测量周期计数器的频率
+ *
+ * @details x86 上自旋 CALIBRATION_NS 对照单调时钟；AArch64 直接读取 cntfrq_el0；
+ *          没有可用计数器时周期即纳秒
+ */
+Calibration measure() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (strcmp(Clock::source(), "tsc") == 0) {
+        int64_t begin_ns = Clock::now_ns();
+        uint64_t begin_ticks = __rdtsc();
+        int64_t end_ns;
+        do {
+            end_ns = Clock::now_ns();
+        } while (end_ns - begin_ns < CALIBRATION_NS);
+        uint64_t end_ticks = __rdtsc();
+        double hz = static_cast<double>(end_ticks - begin_ticks) * 1e9 / static_cast<double>(end_ns - begin_ns);
+        return make_calibration("tsc", hz);
+    }
+#elif defined(__aarch64__)
+    uint64_t frequency;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+    if (frequency != 0) {
+        return make_calibration("cntvct", static_cast<double>(frequency));
+    }
+#endif
+    return make_calibration("clock_gettime", 1e9);
+}
+
+/**
+ * @brief 首次调用时完成校准（函数内静态变量的初始化是线程安全的）
+ */
+const Calibration& calibration() {
+    static const Calibration instance = measure();
+    return instance;
+}
+
+}  // namespace
+
+/**
+ * @brief 通过 CPUID 检测不变 TSC
+ * @return CPU 声明不变 TSC（扩展叶 0x80000007 的 EDX 第 8 位）时返回 true
+ *
+ * @details 不变 TSC 以恒定频率递增，不受变频和深度睡眠影响，且在各核之间同步
+ */
+bool Clock::detect_invariant_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+        return false;
+    }
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 把周期差换算为纳秒
+ * @param ticks 周期差
+ * @return 纳秒数
+ */
+int64_t Clock::ticks_to_ns(uint64_t ticks) {
+    unsigned __int128 product = static_cast<unsigned __int128>(ticks) * calibration().mult;
+    return static_cast<int64_t>(product >> MULT_SHIFT);
+}
+
+/**
+ * @brief 提前完成校准
+ */
+void Clock::calibrate() {
+    calibration();
+}
+
+/**
+ * @brief 周期计数器的频率
+ */
+double Clock::ticks_per_second() {
+    return calibration().hz;
+}
+
+/**
+ * @brief 周期计数器的来源
+ */
+const char* Clock::source() {
+#if defined(__x86_64__) || defined(__i386__)
+    return tsc_usable() ? "tsc" : "clock_gettime";
+#elif defined(__aarch64__)
+    return "cntvct";
+#else
+    return "clock_gettime";
+#endif
+}
@@ -0,0 +1,119 @@
+#include "cpu_topology.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+/// @brief NUMA 节点信息所在目录
+static const char* const NODE_DIR = "/sys/devices/system/node";
+
+/**
+ * @brief 构造函数实现
+ */
+CpuTopology::CpuTopology() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus_.push_back(cpu);
+            }
+        }
+    }
+    if (cpus_.empty()) {
+        cpus_.push_back(0);
+    }
+    nodes_.assign(static_cast<size_t>(cpus_.back()) + 1, 0);
+
+    // 每个 node<N> 目录下的 cpulist 列出属于该节点的 CPU
+    DIR* dir = opendir(NODE_DIR);
+    if (!dir) {
+        return;
+    }
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) != 0 || entry->d_name[4] < '0' || entry->d_name[4] > '9') {
+            continue;
+        }
+        int node = atoi(entry->d_name + 4);
+        std::ifstream file(std::string(NODE_DIR) + "/" + entry->d_name + "/cpulist");
+        std::string list;
+        std::getline(file, list);
+        for (int cpu : parse_cpu_list(list)) {
+            if (cpu >= static_cast<int>(nodes_.size())) {
+                nodes_.resize(static_cast<size_t>(cpu) + 1, 0);
+            }
+            nodes_[cpu] = node;
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief 查询 CPU 所属的 NUMA 节点
+ * @param cpu CPU 编号
+ * @return 节点编号
+ */
+int CpuTopology::node_of(int cpu) const {
+    if (cpu < 0 || cpu >= static_cast<int>(nodes_.size())) {
+        return 0;
+    }
+    return nodes_[cpu];
+}
+
+/**
+ * @brief 把调用线程绑定到指定 CPU
+ * @param cpu CPU 编号
+ * @return 是否成功
+ */
+bool CpuTopology::pin_current_thread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief 调用线程当前运行的 CPU
+ * @return CPU 编号或 -1
+ */
+int CpuTopology::current_cpu() {
+    return sched_getcpu();
+}
+
+/**
+ * @brief 解析 CPU 列表
+ * @param list 形如 "0-3,8,10-11" 的字符串
+ * @return CPU 编号
+ */
+std::vector<int> CpuTopology::parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    const char* position = list.c_str();
+    while (*position) {
+        char* end = nullptr;
+        long first = strtol(position, &end, 10);
+        if (end == position) {
+            break;
+        }
+        long last = first;
+        position = end;
+        if (*position == '-') {
+            last = strtol(position + 1, &end, 10);
+            position = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if (*position != ',') {
+            break;
+        }
+        ++position;
+    }
+    return cpus;
+}
@@ -0,0 +1,297 @@
+#include "event_loop.h"
+#include "rcu.h"
+#include "clock.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+/// @brief 单次 epoll_wait 返回的最大事件数
+constexpr int MAX_EVENTS = 256;
+
+/**
+ * @brief 构造函数实现
+ */
+EventLoop::EventLoop()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+    , wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , timer_fd_(-1)
+    , quit_(false)
+    , wakeup_pending_(false)
+    , budget_(nullptr)
+    , busy_ns_(0)
+    , busy_since_ns_(0) {
+    if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+        std::cerr << "[EventLoop] Failed to create epoll/eventfd: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    // eventfd 的上下文为 nullptr，用于区分唤醒事件
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev);
+}
+
+/**
+ * @brief 析构函数实现
+ */
+EventLoop::~EventLoop() {
+    if (timer_fd_ >= 0) {
+        close(timer_fd_);
+    }
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+/**
+ * @brief 注册文件描述符
+ */
+bool EventLoop::add(int fd, uint32_t events, void* context) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = context;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+/**
+ * @brief 修改关注的事件
+ */
+bool EventLoop::modify(int fd, uint32_t events, void* context) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = context;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+/**
+ * @brief 取消注册文件描述符
+ */
+bool EventLoop::remove(int fd) {
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) == 0;
+}
+
+/**
+ * @brief 设置唤醒处理函数
+ */
+void EventLoop::set_wakeup_handler(Task handler) {
+    wakeup_handler_ = std::move(handler);
+}
+
+/**
+ * @brief 设置就绪列表处理函数
+ */
+void EventLoop::set_ready_handler(ReadyHandler handler) {
+    ready_handler_ = std::move(handler);
+}
+
+/**
+ * @brief 设置定时处理函数
+ *
+ * @details timerfd 的上下文为 timer_fd_ 成员的地址，与连接的上下文和 eventfd 的 nullptr 区分
+ */
+bool EventLoop::set_timer_handler(std::chrono::milliseconds interval, Task handler) {
+    if (interval.count() <= 0) {
+        return false;
+    }
+    if (timer_fd_ < 0) {
+        timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timer_fd_ < 0) {
+            std::cerr << "[EventLoop] Failed to create timerfd: " << strerror(errno) << std::endl;
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &timer_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev);
+    }
+
+    itimerspec spec{};
+    spec.it_interval.tv_sec = static_cast<time_t>(interval.count() / 1000);
+    spec.it_interval.tv_nsec = static_cast<long>(interval.count() % 1000) * 1000000;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(timer_fd_, 0, &spec, nullptr);
+    timer_handler_ = std::move(handler);
+    return true;
+}
+
+/**
+ * @brief 设置就绪事件处理函数
+ */
+void EventLoop::set_event_handler(EventHandler handler) {
+    handler_ = std::move(handler);
+}
+
+/**
+ * @brief 运行事件循环
+ *
+ * @details
+ * 每一轮：
+ * 1. epoll_wait 等待就绪事件
+ * 2. 逐个分发给事件处理函数（eventfd 事件只用于唤醒；timerfd 到期时在唤醒处理之后调用定时处理函数）
+ * 3. 执行其他线程投递的任务
+ * 4. 处理就绪列表，仍有剩余工作时下一轮 epoll_wait 不阻塞
+ *
+ * 从 epoll_wait 返回到本轮结束的时间计入忙碌时间。每轮开始时刷新一次 Clock 的缓存时刻，
+ * 本轮的回调通过 Clock::cached_ns() 取用；本轮耗时用周期计数器测量。
+ * 忙轮询模式下自旋阶段也以零超时等待，没有取到事件的空转直接进入下一轮
+ */
+void EventLoop::run() {
+    thread_id_ = std::this_thread::get_id();
+    Clock::calibrate();
+    epoll_event events[MAX_EVENTS];
+    bool ready_pending = false;
+    BusyPoller poller(busy_poll_);
+
+    while (!quit_) {
+        int timeout = (ready_pending || poller.spinning()) ? 0 : -1;
+        int n = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[EventLoop] epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (n == 0 && !ready_pending) {
+            poller.on_idle();
+            continue;
+        }
+        poller.on_work();
+
+        int64_t busy_start = Clock::refresh();
+        uint64_t busy_ticks = Clock::ticks();
+        busy_since_ns_.store(busy_start, std::memory_order_relaxed);
+
+        // 每次唤醒是一个读临界区：回调中读取 RcuCell 只需一次加载，阻塞等待期间不拖延宽限期
+        Rcu::ReadGuard guard;
+
+        bool woken = false;
+        bool timer_expired = false;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == &timer_fd_) {
+                // 读走到期次数，多次到期只调用一次
+                uint64_t expirations;
+                while (read(timer_fd_, &expirations, sizeof(expirations)) > 0) {
+                }
+                timer_expired = true;
+                continue;
+            }
+            if (events[i].data.ptr == nullptr) {
+                // 唤醒事件，清空 eventfd 计数；清除标志之后的 wakeup() 会再次写 eventfd
+                uint64_t value;
+                while (read(wakeup_fd_, &value, sizeof(value)) > 0) {
+                }
+                wakeup_pending_.store(false);
+                woken = true;
+                continue;
+            }
+            if (handler_) {
+                handler_(events[i].data.ptr, events[i].events);
+            }
+        }
+
+        if (woken && wakeup_handler_) {
+            wakeup_handler_();
+        }
+        if (timer_expired && timer_handler_) {
+            timer_handler_();
+        }
+        run_pending_tasks();
+        ready_pending = ready_handler_ && ready_handler_();
+
+        busy_since_ns_.store(0, std::memory_order_relaxed);
+        uint64_t elapsed = static_cast<uint64_t>(Clock::elapsed_ns(busy_ticks));
+        busy_ns_.store(busy_ns_.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+    }
+
+    // 退出前执行剩余任务，保证投递的任务不会丢失
+    run_pending_tasks();
+    Clock::invalidate();
+    thread_id_ = std::thread::id();
+}
+
+/**
+ * @brief 累计的忙碌时间
+ * @return 已结束各轮之和加上正在进行的一轮已经过的时间
+ */
+uint64_t EventLoop::busy_time_ns() const {
+    int64_t since = busy_since_ns_.load(std::memory_order_relaxed);
+    uint64_t busy = busy_ns_.load(std::memory_order_relaxed);
+    if (since != 0) {
+        int64_t running = Clock::now_ns() - since;
+        if (running > 0) {
+            busy += static_cast<uint64_t>(running);
+        }
+    }
+    return busy;
+}
+
+/**
+ * @brief 请求停止事件循环
+ */
+void EventLoop::stop() {
+    quit_ = true;
+    wakeup();
+}
+
+/**
+ * @brief 投递任务到循环线程
+ */
+void EventLoop::queue_in_loop(Task task) {
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        was_empty = pending_tasks_.empty();
+        pending_tasks_.push_back(std::move(task));
+    }
+    if (budget_) {
+        budget_->charge(MemoryBudget::Category::Task, sizeof(Task));
+    }
+    // 队列非空时循环线程必然已被唤醒或正在执行任务
+    if (was_empty) {
+        wakeup();
+    }
+}
+
+/**
+ * @brief 唤醒循环线程
+ * @details 只有标志从 false 变为 true 的调用才写 eventfd
+ */
+void EventLoop::wakeup() {
+    if (wakeup_pending_.exchange(true)) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t n = write(wakeup_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+/**
+ * @brief 执行已投递的任务
+ * @details 先在锁内交换出任务列表，再在锁外执行，避免任务中再次投递时死锁
+ */
+void EventLoop::run_pending_tasks() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks.swap(pending_tasks_);
+    }
+
+    for (Task& task : tasks) {
+        task();
+    }
+
+    if (budget_ && !tasks.empty()) {
+        budget_->release(MemoryBudget::Category::Task, tasks.size() * sizeof(Task));
+    }
+}
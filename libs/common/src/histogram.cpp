@@ -0,0 +1,108 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief 构造函数，所有桶清零
+ */
+Histogram::Histogram() : count_(0), sum_(0), max_(0) {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 把另一个直方图的样本累加到本直方图
+ * @param other 另一个直方图
+ */
+void Histogram::merge(const Histogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+        if (n != 0) {
+            buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    uint64_t value = other.max();
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 清空所有样本
+ *
+ * @note 与 record() 并发时可能留下少量不一致（如计数与桶之和不等），只影响当次统计
+ */
+void Histogram::reset() {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 桶的上界（包含）
+ * @param bucket 桶下标
+ */
+uint64_t Histogram::bucket_upper(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t group = bucket / SUB_BUCKETS;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    uint64_t width = uint64_t(1) << (group - 1);
+    return ((SUB_BUCKETS + sub) << (group - 1)) + (width - 1);
+}
+
+/**
+ * @brief 计算百分位
+ * @param quantile 分位（0~1）
+ * @return 所在桶的上界，不超过最大值
+ *
+ * @details 以桶之和为总数，并发记录时不会越过最后一个非空桶
+ */
+uint64_t Histogram::percentile(double quantile) const {
+    uint64_t counts[BUCKETS];
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    quantile = std::clamp(quantile, 0.0, 1.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper(i), max());
+        }
+    }
+    return max();
+}
+
+/**
+ * @brief 生成摘要
+ */
+Histogram::Summary Histogram::summary() const {
+    Summary summary;
+    summary.count = count();
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean = static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(summary.count);
+    summary.p50 = percentile(0.5);
+    summary.p90 = percentile(0.9);
+    summary.p99 = percentile(0.99);
+    summary.p999 = percentile(0.999);
+    summary.max = max();
+    return summary;
+}
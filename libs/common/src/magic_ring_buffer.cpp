@@ -0,0 +1,217 @@
+#include "magic_ring_buffer.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+/**
+ * @brief 获取系统页大小
+ */
+static size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/**
+ * @brief 构造函数实现
+ * @param capacity 期望容量
+ *
+ * @details
+ * 映射步骤：
+ * 1. memfd_create 创建匿名内存文件并设置大小为 N
+ * 2. 预留 2N 的连续虚拟地址（PROT_NONE）
+ * 3. 用 MAP_FIXED 把同一文件映射到前后两半
+ * 4. 关闭 memfd（映射会保持文件存活）
+ */
+MagicRingBuffer::MagicRingBuffer(size_t capacity)
+    : base_(nullptr)
+    , capacity_(RingBufferPool::class_size(capacity))
+    , mask_(capacity_ - 1)
+    , head_(0)
+    , tail_(0) {
+    int fd = memfd_create("magic_ring_buffer", MFD_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[MagicRingBuffer] memfd_create failed: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(capacity_)) < 0) {
+        std::cerr << "[MagicRingBuffer] ftruncate failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+
+    // 预留连续的 2N 虚拟地址空间
+    void* reserved = mmap(nullptr, capacity_ * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        std::cerr << "[MagicRingBuffer] Failed to reserve address space: " << strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+
+    char* base = static_cast<char*>(reserved);
+    void* first = mmap(base, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void* second = mmap(base + capacity_, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+
+    if (first == MAP_FAILED || second == MAP_FAILED) {
+        std::cerr << "[MagicRingBuffer] Failed to map ring halves: " << strerror(errno) << std::endl;
+        munmap(base, capacity_ * 2);
+        return;
+    }
+
+    base_ = base;
+}
+
+/**
+ * @brief 析构函数实现
+ */
+MagicRingBuffer::~MagicRingBuffer() {
+    if (base_) {
+        munmap(base_, capacity_ * 2);
+    }
+}
+
+/**
+ * @brief 消费数据
+ * @param length 消费的字节数
+ * @details 缓冲区读空时把读写位置归零，让下一次写入从映射起点开始
+ */
+void MagicRingBuffer::consume(size_t length) {
+    head_ += length;
+    if (head_ == tail_) {
+        head_ = tail_ = 0;
+    }
+}
+
+/**
+ * @brief 追加数据
+ * @param data 数据起始地址
+ * @param length 数据长度
+ * @return 是否追加成功
+ */
+bool MagicRingBuffer::append(const char* data, size_t length) {
+    if (length > writable()) {
+        return false;
+    }
+    memcpy(write_ptr(), data, length);
+    commit(length);
+    return true;
+}
+
+/**
+ * @brief 构造函数实现
+ * @param max_cached_per_class 每档最多缓存数量
+ */
+RingBufferPool::RingBufferPool(size_t max_cached_per_class)
+    : max_cached_per_class_(max_cached_per_class)
+    , free_lists_(class_index(MAX_POOLED_SIZE) + 1) {
+}
+
+/**
+ * @brief 析构函数实现
+ */
+RingBufferPool::~RingBufferPool() {
+    for (auto& free_list : free_lists_) {
+        for (MagicRingBuffer* ring : free_list) {
+            delete ring;
+        }
+    }
+}
+
+/**
+ * @brief 计算档位容量
+ * @param size 需要的容量
+ * @return 档位容量
+ */
+size_t RingBufferPool::class_size(size_t size) {
+    size_t result = page_size();
+    while (result < size) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief 计算档位下标
+ * @param class_size 档位容量
+ * @return 下标
+ */
+size_t RingBufferPool::class_index(size_t class_size) {
+    size_t index = 0;
+    for (size_t size = page_size(); size < class_size; size <<= 1) {
+        ++index;
+    }
+    return index;
+}
+
+/**
+ * @brief 获取环形缓冲区
+ * @param size 需要的容量
+ * @return 环形缓冲区指针或 nullptr
+ */
+MagicRingBuffer* RingBufferPool::acquire(size_t size) {
+    size_t capacity = class_size(size);
+
+    if (capacity <= MAX_POOLED_SIZE) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& free_list = free_lists_[class_index(capacity)];
+        if (!free_list.empty()) {
+            MagicRingBuffer* ring = free_list.back();
+            free_list.pop_back();
+            return ring;
+        }
+    }
+
+    MagicRingBuffer* ring = new MagicRingBuffer(capacity);
+    if (!ring->is_valid()) {
+        delete ring;
+        return nullptr;
+    }
+    return ring;
+}
+
+/**
+ * @brief 归还环形缓冲区
+ * @param ring 环形缓冲区指针
+ */
+void RingBufferPool::release(MagicRingBuffer* ring) {
+    if (!ring) {
+        return;
+    }
+
+    ring->clear();
+    if (ring->capacity() <= MAX_POOLED_SIZE) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& free_list = free_lists_[class_index(ring->capacity())];
+        if (free_list.size() < max_cached_per_class_) {
+            free_list.push_back(ring);
+            return;
+        }
+    }
+    delete ring;
+}
+
+/**
+ * @brief 预先创建环形缓冲区
+ * @param size 档位大小
+ * @param count 数量
+ */
+void RingBufferPool::prewarm(size_t size, size_t count) {
+    std::vector<MagicRingBuffer*> rings;
+    for (size_t i = 0; i < count; ++i) {
+        MagicRingBuffer* ring = acquire(size);
+        if (!ring) {
+            break;
+        }
+        // 写一遍触发缺页
+        memset(ring->write_ptr(), 0, ring->capacity());
+        rings.push_back(ring);
+    }
+    for (MagicRingBuffer* ring : rings) {
+        release(ring);
+    }
+}
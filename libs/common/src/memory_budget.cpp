@@ -0,0 +1,48 @@
+#include "memory_budget.h"
+
+/**
+ * @brief 构造函数实现
+ * @param limit 全局上限
+ */
+MemoryBudget::MemoryBudget(size_t limit)
+    : limit_(limit)
+    , total_(0)
+    , peak_(0) {
+    for (auto& used : used_) {
+        used.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 记入用量并更新峰值
+ * @param category 内存类别
+ * @param bytes 字节数
+ */
+void MemoryBudget::charge(Category category, size_t bytes) {
+    used_[static_cast<size_t>(category)].fetch_add(bytes, std::memory_order_relaxed);
+    size_t total = total_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    size_t peak = peak_.load(std::memory_order_relaxed);
+    while (total > peak && !peak_.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 扣除用量
+ * @param category 内存类别
+ * @param bytes 字节数
+ */
+void MemoryBudget::release(Category category, size_t bytes) {
+    used_[static_cast<size_t>(category)].fetch_sub(bytes, std::memory_order_relaxed);
+    total_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 判断再记入 bytes 字节后是否超限
+ * @param bytes 字节数
+ * @return 是否超限
+ */
+bool MemoryBudget::would_exceed(size_t bytes) const {
+    size_t limit = limit_.load(std::memory_order_relaxed);
+    return limit != 0 && used() + bytes > limit;
+}
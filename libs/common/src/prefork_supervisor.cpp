@@ -0,0 +1,412 @@
+#include "prefork_supervisor.h"
+#include "cpu_topology.h"
+
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <thread>
+
+/// @brief 监督循环检查工作进程状态的间隔
+constexpr std::chrono::milliseconds POLL_INTERVAL(10);
+
+/// @brief Worker::wait() 每次睡眠的最长时间，避免错过睡眠前到达的停止信号
+constexpr std::chrono::milliseconds WAIT_SLICE(50);
+
+// 共享内存中的原子变量被多个进程访问，必须是无锁的
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "process-shared counters must be lock-free");
+static_assert(std::atomic<int32_t>::is_always_lock_free, "process-shared pid must be lock-free");
+
+/**
+ * @struct PreforkSupervisor::Slot
+ * @brief 共享内存中每个工作进程的槽位，按缓存行对齐，各进程的写入互不干扰
+ */
+struct alignas(64) PreforkSupervisor::Slot {
+    std::atomic<int32_t> pid{0};                        // 运行中的工作进程号，0 表示没有
+    std::atomic<uint64_t> restarts{0};                  // 崩溃后被重启的次数
+    std::atomic<uint64_t> counters[MAX_COUNTERS] = {};  // 计数器，重启后继续累加
+    std::atomic<uint64_t> gauges[MAX_GAUGES] = {};      // 瞬时值，工作进程结束时清零
+};
+
+/// @brief 工作进程是否收到了停止信号（只在子进程中使用）
+static std::atomic<bool> g_worker_stop(false);
+
+/**
+ * @brief 工作进程的停止信号处理函数
+ */
+static void on_worker_stop_signal(int) {
+    g_worker_stop.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 描述工作进程的退出状态
+ */
+static std::string describe_status(int status) {
+    if (WIFSIGNALED(status)) {
+        return "killed by signal " + std::to_string(WTERMSIG(status));
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+/**
+ * @brief 槽位被重启的次数
+ */
+uint64_t PreforkSupervisor::Worker::restarts() const {
+    return slot_->restarts.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 计数器加上 delta
+ */
+void PreforkSupervisor::Worker::add(size_t counter, uint64_t delta) {
+    slot_->counters[counter].fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 设置瞬时值
+ */
+void PreforkSupervisor::Worker::set(size_t gauge, uint64_t value) {
+    slot_->gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 是否已收到停止请求
+ */
+bool PreforkSupervisor::Worker::stop_requested() const {
+    return g_worker_stop.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 等待一段时间或直到收到停止请求
+ * @details 分片睡眠：停止信号会打断当前的睡眠，分片保证即使信号先于睡眠到达也能及时返回
+ */
+bool PreforkSupervisor::Worker::wait(std::chrono::milliseconds timeout) const {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!stop_requested()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now, WAIT_SLICE));
+    }
+    return false;
+}
+
+/**
+ * @brief 构造函数实现
+ * @param main 工作进程入口函数
+ * @param options 监督者配置
+ */
+PreforkSupervisor::PreforkSupervisor(WorkerMain main, const Options& options)
+    : main_(std::move(main))
+    , options_(options)
+    , worker_count_(options.workers != 0 ? options.workers : CpuTopology().cpus().size())
+    , shared_(nullptr)
+    , shared_size_(sizeof(Slot) * worker_count_)
+    , parent_pid_(0)
+    , stopping_(false)
+    , report_interval_(0)
+    , delays_(worker_count_, options.restart_delay)
+    , restart_at_(worker_count_)
+    , started_at_(worker_count_) {
+    // fork 之前映射的匿名共享内存在父子进程之间共享同一份物理页
+    void* memory = mmap(nullptr, shared_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "[Supervisor] Failed to map shared metrics: " << strerror(errno) << std::endl;
+        return;
+    }
+    shared_ = memory;
+    for (size_t i = 0; i < worker_count_; ++i) {
+        new (slot(i)) Slot();
+    }
+}
+
+/**
+ * @brief 析构函数实现
+ */
+PreforkSupervisor::~PreforkSupervisor() {
+    if (shared_) {
+        munmap(shared_, shared_size_);
+    }
+}
+
+/**
+ * @brief 获取槽位
+ */
+PreforkSupervisor::Slot* PreforkSupervisor::slot(size_t index) const {
+    return static_cast<Slot*>(shared_) + index;
+}
+
+/**
+ * @brief 设置定期汇总报告
+ */
+void PreforkSupervisor::set_report_handler(std::chrono::milliseconds interval, ReportHandler handler) {
+    report_interval_ = interval;
+    report_handler_ = std::move(handler);
+}
+
+/**
+ * @brief fork 工作进程并看护
+ *
+ * @details
+ * 每个轮询间隔：
+ * 1. 回收已退出的工作进程，崩溃的按退避间隔安排重启
+ * 2. 到期的槽位重新 fork（fork 失败时按退避间隔再试）
+ * 3. 到达报告间隔时汇总指标并回调
+ */
+bool PreforkSupervisor::run() {
+    if (!shared_ || worker_count_ == 0) {
+        return false;
+    }
+
+    parent_pid_ = getpid();
+    for (size_t i = 0; i < worker_count_; ++i) {
+        if (!spawn(i)) {
+            stop_workers();
+            return false;
+        }
+    }
+    std::cout << "[Supervisor] Started " << worker_count_ << " workers" << std::endl;
+
+    auto next_report = std::chrono::steady_clock::now() + report_interval_;
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        auto now = std::chrono::steady_clock::now();
+        reap(now);
+
+        bool active = false;
+        for (size_t i = 0; i < worker_count_; ++i) {
+            if (restart_at_[i] != std::chrono::steady_clock::time_point() && now >= restart_at_[i]) {
+                restart_at_[i] = std::chrono::steady_clock::time_point();
+                if (!spawn(i)) {
+                    restart_at_[i] = now + delays_[i];
+                }
+            }
+            active = active || slot(i)->pid.load(std::memory_order_relaxed) != 0
+                     || restart_at_[i] != std::chrono::steady_clock::time_point();
+        }
+        if (!active) {
+            // 全部工作进程都已正常结束
+            break;
+        }
+
+        if (report_handler_ && report_interval_.count() > 0 && now >= next_report) {
+            report_handler_(metrics());
+            next_report = now + report_interval_;
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+
+    stop_workers();
+    std::cout << "[Supervisor] Stopped" << std::endl;
+    return true;
+}
+
+/**
+ * @brief fork 一个工作进程
+ * @param index 工作进程下标
+ * @return 是否成功
+ */
+bool PreforkSupervisor::spawn(size_t index) {
+    // 缓冲中尚未输出的内容会被子进程复制一份，fork 前先刷出
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "[Supervisor] Failed to fork worker " << index << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (pid == 0) {
+        worker_main(index);
+    }
+
+    slot(index)->pid.store(static_cast<int32_t>(pid), std::memory_order_relaxed);
+    started_at_[index] = std::chrono::steady_clock::now();
+    std::cout << "[Supervisor] Worker " << index << " started (pid=" << pid << ")" << std::endl;
+    return true;
+}
+
+/**
+ * @brief 在子进程中运行入口函数并退出
+ * @param index 工作进程下标
+ *
+ * @details 用 _exit() 退出，不运行从父进程继承的静态对象析构和 atexit 回调
+ */
+void PreforkSupervisor::worker_main(size_t index) {
+    // SIGTERM/SIGINT 只设置停止标志，由入口函数自行收尾
+    struct sigaction action{};
+    action.sa_handler = on_worker_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+
+    sigset_t unblocked;
+    sigemptyset(&unblocked);
+    sigprocmask(SIG_SETMASK, &unblocked, nullptr);
+
+    // 监督者意外退出时工作进程也收到 SIGTERM；fork 之后父进程可能已经退出
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (getppid() != parent_pid_) {
+        g_worker_stop.store(true, std::memory_order_relaxed);
+    }
+
+    int code = 0;
+    Worker worker(index, slot(index));
+    try {
+        code = main_ ? main_(worker) : 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[Supervisor] Worker " << index << " threw: " << e.what() << std::endl;
+        code = 1;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(code);
+}
+
+/**
+ * @brief 回收已退出的工作进程
+ * @param now 当前时间
+ *
+ * @details 只等待自己 fork 的进程，不影响调用者的其他子进程。
+ *          崩溃前已稳定运行超过 max_restart_delay 的槽位，退避间隔回到 restart_delay
+ */
+void PreforkSupervisor::reap(std::chrono::steady_clock::time_point now) {
+    for (size_t i = 0; i < worker_count_; ++i) {
+        Slot* s = slot(i);
+        pid_t pid = s->pid.load(std::memory_order_relaxed);
+        if (pid == 0) {
+            continue;
+        }
+
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) != pid) {
+            continue;
+        }
+        s->pid.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint64_t>& gauge : s->gauges) {
+            gauge.store(0, std::memory_order_relaxed);
+        }
+
+        bool crashed = WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+        if (!crashed || stopping_.load(std::memory_order_relaxed)) {
+            std::cout << "[Supervisor] Worker " << i << " (pid=" << pid << ") " << describe_status(status) << std::endl;
+            continue;
+        }
+
+        if (now - started_at_[i] > options_.max_restart_delay) {
+            delays_[i] = options_.restart_delay;
+        }
+        restart_at_[i] = now + delays_[i];
+        s->restarts.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[Supervisor] Worker " << i << " (pid=" << pid << ") " << describe_status(status)
+                  << ", restarting in " << delays_[i].count() << "ms" << std::endl;
+        delays_[i] = std::min(delays_[i] * 2, options_.max_restart_delay);
+    }
+}
+
+/**
+ * @brief 向运行中的工作进程发送 SIGTERM 并等待退出
+ */
+void PreforkSupervisor::stop_workers() {
+    for (size_t i = 0; i < worker_count_; ++i) {
+        pid_t pid = slot(i)->pid.load(std::memory_order_relaxed);
+        if (pid != 0) {
+            kill(pid, SIGTERM);
+        }
+        restart_at_[i] = std::chrono::steady_clock::time_point();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + options_.stop_timeout;
+    while (true) {
+        bool remaining = false;
+        for (size_t i = 0; i < worker_count_; ++i) {
+            Slot* s = slot(i);
+            pid_t pid = s->pid.load(std::memory_order_relaxed);
+            if (pid == 0) {
+                continue;
+            }
+            int status = 0;
+            if (waitpid(pid, &status, WNOHANG) == pid) {
+                s->pid.store(0, std::memory_order_relaxed);
+                for (std::atomic<uint64_t>& gauge : s->gauges) {
+                    gauge.store(0, std::memory_order_relaxed);
+                }
+            } else {
+                remaining = true;
+            }
+        }
+        if (!remaining) {
+            return;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+
+    // 超时仍未退出的工作进程强制结束
+    for (size_t i = 0; i < worker_count_; ++i) {
+        Slot* s = slot(i);
+        pid_t pid = s->pid.load(std::memory_order_relaxed);
+        if (pid == 0) {
+            continue;
+        }
+        std::cerr << "[Supervisor] Worker " << i << " (pid=" << pid << ") did not stop, killing" << std::endl;
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        s->pid.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint64_t>& gauge : s->gauges) {
+            gauge.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief 汇总各工作进程的指标
+ * @return 汇总结果
+ */
+PreforkSupervisor::Metrics PreforkSupervisor::metrics() const {
+    Metrics metrics;
+    if (!shared_) {
+        return metrics;
+    }
+    for (size_t i = 0; i < worker_count_; ++i) {
+        const Slot* s = slot(i);
+        if (s->pid.load(std::memory_order_relaxed) != 0) {
+            ++metrics.running;
+        }
+        metrics.restarts += s->restarts.load(std::memory_order_relaxed);
+        for (size_t c = 0; c < MAX_COUNTERS; ++c) {
+            metrics.counters[c] += s->counters[c].load(std::memory_order_relaxed);
+        }
+        for (size_t g = 0; g < MAX_GAUGES; ++g) {
+            metrics.gauges[g] += s->gauges[g].load(std::memory_order_relaxed);
+        }
+    }
+    return metrics;
+}
+
+/**
+ * @brief 各工作进程的状态
+ * @return 按下标排列的状态
+ */
+std::vector<PreforkSupervisor::WorkerStatus> PreforkSupervisor::workers() const {
+    std::vector<WorkerStatus> statuses(worker_count_);
+    if (!shared_) {
+        return statuses;
+    }
+    for (size_t i = 0; i < worker_count_; ++i) {
+        statuses[i].pid = slot(i)->pid.load(std::memory_order_relaxed);
+        statuses[i].restarts = slot(i)->restarts.load(std::memory_order_relaxed);
+    }
+    return statuses;
+}
@@ -0,0 +1,172 @@
+#include "rcu.h"
+
+#include <thread>
+
+namespace {
+
+/**
+ * @struct ReaderSlot
+ * @brief 一个读者线程的状态，按缓存行对齐避免伪共享
+ */
+struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch{0};     // 进入读临界区时的纪元，0 表示不在临界区
+    std::atomic<bool> in_use{false};    // 是否已被某个线程占用
+    uint32_t depth = 0;                 // 嵌套深度，仅由所属线程访问
+};
+
+/**
+ * @struct ReaderRegistry
+ * @brief 所有读者槽位
+ *
+ * @details 槽位只增不减（线程退出后标记为空闲并复用），写者遍历时无需加锁
+ */
+struct ReaderRegistry {
+    static constexpr size_t MAX_SLOTS = 1024;
+
+    ReaderSlot slots[MAX_SLOTS];
+    std::atomic<size_t> slot_count{0};
+    std::atomic<uint64_t> epoch{1};
+    std::mutex mutex;
+};
+
+ReaderRegistry& registry() {
+    static ReaderRegistry instance;
+    return instance;
+}
+
+/**
+ * @class SlotHandle
+ * @brief 线程私有的槽位句柄，线程退出时归还槽位
+ */
+class SlotHandle {
+public:
+    SlotHandle() : slot_(nullptr) {
+        ReaderRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        size_t count = reg.slot_count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            if (!reg.slots[i].in_use.load(std::memory_order_relaxed)) {
+                slot_ = &reg.slots[i];
+                break;
+            }
+        }
+        if (!slot_ && count < ReaderRegistry::MAX_SLOTS) {
+            slot_ = &reg.slots[count];
+            reg.slot_count.store(count + 1, std::memory_order_release);
+        }
+        if (slot_) {
+            slot_->in_use.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    ~SlotHandle() {
+        if (slot_) {
+            slot_->epoch.store(0, std::memory_order_release);
+            slot_->depth = 0;
+            slot_->in_use.store(false, std::memory_order_release);
+        }
+    }
+
+    ReaderSlot* get() const { return slot_; }
+
+private:
+    ReaderSlot* slot_;
+};
+
+/**
+ * @brief 当前线程的槽位；槽位耗尽时为 nullptr
+ */
+ReaderSlot* local_slot() {
+    thread_local SlotHandle handle;
+    return handle.get();
+}
+
+/// @brief 槽位耗尽时的退路：记录本线程嵌套深度，读临界区退化为全局计数
+std::atomic<uint64_t> overflow_readers{0};
+thread_local uint32_t overflow_depth = 0;
+
+} // namespace
+
+/**
+ * @brief 进入读临界区
+ *
+ * @details 最外层进入时记录全局纪元并执行一次全屏障，保证写者要么看到本线程
+ *          在临界区内，要么本线程看到写者推进纪元之前发布的数据
+ */
+void Rcu::read_lock() {
+    ReaderSlot* slot = local_slot();
+    if (!slot) {
+        if (overflow_depth++ == 0) {
+            overflow_readers.fetch_add(1, std::memory_order_seq_cst);
+        }
+        return;
+    }
+    if (slot->depth++ == 0) {
+        slot->epoch.store(registry().epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+/**
+ * @brief 退出读临界区
+ */
+void Rcu::read_unlock() {
+    ReaderSlot* slot = local_slot();
+    if (!slot) {
+        if (--overflow_depth == 0) {
+            overflow_readers.fetch_sub(1, std::memory_order_release);
+        }
+        return;
+    }
+    if (--slot->depth == 0) {
+        slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief 当前线程是否处于读临界区
+ */
+bool Rcu::in_read_section() {
+    ReaderSlot* slot = local_slot();
+    return slot ? slot->depth > 0 : overflow_depth > 0;
+}
+
+/**
+ * @brief 推进全局纪元
+ * @return 新纪元
+ */
+uint64_t Rcu::advance() {
+    uint64_t epoch = registry().epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch;
+}
+
+/**
+ * @brief 检查宽限期是否已过
+ * @param epoch advance() 返回的纪元
+ * @return 是否已过
+ */
+bool Rcu::grace_passed(uint64_t epoch) {
+    ReaderRegistry& reg = registry();
+    if (overflow_readers.load(std::memory_order_acquire) != 0) {
+        return false;
+    }
+    size_t count = reg.slot_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t reader_epoch = reg.slots[i].epoch.load(std::memory_order_acquire);
+        if (reader_epoch != 0 && reader_epoch < epoch) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 等待宽限期结束
+ */
+void Rcu::synchronize() {
+    uint64_t epoch = advance();
+    while (!grace_passed(epoch)) {
+        std::this_thread::yield();
+    }
+}
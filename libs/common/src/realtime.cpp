@@ -0,0 +1,193 @@
+#include "realtime.h"
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+/// @brief 预写入栈时为调用链之后的帧保留的余量
+constexpr size_t STACK_RESERVE = 16 * 1024;
+
+namespace {
+
+std::once_flag g_lock_once;                         // mlockall 只尝试一次
+std::atomic<bool> g_memory_locked{false};           // mlockall 是否成功
+std::atomic<int> g_memory_error{0};                 // mlockall 失败时的 errno
+std::atomic<size_t> g_realtime_threads{0};          // 切换为 SCHED_FIFO 的线程数
+std::atomic<size_t> g_fallback_threads{0};          // 切换失败的线程数
+std::atomic<int> g_thread_error{0};                 // 最近一次切换失败的 errno
+std::atomic<size_t> g_prefaulted_bytes{0};          // 已预写入的栈字节数
+std::atomic<bool> g_sched_warned{false};            // 是否已打印调度策略的警告
+
+/**
+ * @brief 在 alloca 出的栈空间上逐页写入
+ * @param bytes 字节数
+ *
+ * @details 不能内联：返回后这段栈空间随帧一起释放，但物理页已经就位
+ */
+__attribute__((noinline)) void touch_stack(size_t bytes) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile char* base = static_cast<volatile char*>(alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        base[offset] = 0;
+    }
+    base[bytes - 1] = 0;
+}
+
+}  // namespace
+
+/**
+ * @brief 锁定进程的全部内存
+ * @return 是否已锁定
+ */
+bool Realtime::lock_memory() {
+    std::call_once(g_lock_once, []() {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            g_memory_locked.store(true);
+            return;
+        }
+        g_memory_error.store(errno);
+        std::cerr << "[Realtime] mlockall failed, memory stays pageable: " << strerror(errno)
+                  << " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK)" << std::endl;
+    });
+    return g_memory_locked.load();
+}
+
+/**
+ * @brief 预写入调用线程的栈
+ * @param bytes 期望字节数
+ * @return 实际字节数
+ *
+ * @details 用 pthread_getattr_np 取得栈的范围，按当前栈指针估算剩余空间，
+ *          留出 STACK_RESERVE 之后截断
+ */
+size_t Realtime::prefault_stack(size_t bytes) {
+    if (bytes == 0) {
+        return 0;
+    }
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return 0;
+    }
+    void* stack_addr = nullptr;
+    size_t stack_size = 0;
+    int result = pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        return 0;
+    }
+
+    // 栈向低地址增长，当前帧以下到栈底之间是剩余空间
+    char marker = 0;
+    uintptr_t current = reinterpret_cast<uintptr_t>(&marker);
+    uintptr_t bottom = reinterpret_cast<uintptr_t>(stack_addr);
+    if (current <= bottom + STACK_RESERVE) {
+        return 0;
+    }
+    bytes = std::min(bytes, static_cast<size_t>(current - bottom - STACK_RESERVE));
+
+    touch_stack(bytes);
+    g_prefaulted_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return bytes;
+}
+
+/**
+ * @brief 按配置实时化调用线程
+ * @param options 实时化配置
+ * @param priority SCHED_FIFO 优先级
+ * @return 是否全部成功
+ */
+bool Realtime::configure_current_thread(const RealtimeOptions& options, int priority) {
+    if (!options.enabled) {
+        return true;
+    }
+
+    bool ok = true;
+    if (options.lock_memory && !lock_memory()) {
+        ok = false;
+    }
+
+    if (priority > 0) {
+        sched_param param{};
+        param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+        int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error == 0) {
+            g_realtime_threads.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            g_fallback_threads.fetch_add(1, std::memory_order_relaxed);
+            g_thread_error.store(error, std::memory_order_relaxed);
+            if (!g_sched_warned.exchange(true)) {
+                std::cerr << "[Realtime] SCHED_FIFO unavailable, threads keep normal scheduling: " << strerror(error)
+                          << " (needs CAP_SYS_NICE or RLIMIT_RTPRIO >= " << param.sched_priority << ")" << std::endl;
+            }
+            ok = false;
+        }
+    }
+
+    prefault_stack(options.stack_prefault);
+    return ok;
+}
+
+/**
+ * @brief 生成线程池的线程初始化函数
+ * @param options 实时化配置
+ * @return 初始化函数，未启用时为空
+ */
+std::function<void(size_t)> Realtime::worker_init(const RealtimeOptions& options) {
+    if (!options.enabled) {
+        return nullptr;
+    }
+    return [options](size_t) { configure_current_thread(options, options.worker_priority); };
+}
+
+/**
+ * @brief 获取累计状态
+ */
+RealtimeStatus Realtime::status() {
+    RealtimeStatus status;
+    status.memory_locked = g_memory_locked.load();
+    status.memory_error = g_memory_error.load();
+    status.realtime_threads = g_realtime_threads.load(std::memory_order_relaxed);
+    status.fallback_threads = g_fallback_threads.load(std::memory_order_relaxed);
+    status.thread_error = g_thread_error.load(std::memory_order_relaxed);
+    status.prefaulted_bytes = g_prefaulted_bytes.load(std::memory_order_relaxed);
+    return status;
+}
+
+/**
+ * @brief 生成可读的状态报告
+ */
+std::string Realtime::report() {
+    RealtimeStatus s = status();
+    std::ostringstream out;
+
+    out << "memory: ";
+    if (s.memory_locked) {
+        out << "locked (mlockall)";
+    } else if (s.memory_error != 0) {
+        out << "pageable, mlockall failed: " << strerror(s.memory_error)
+            << " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK)";
+    } else {
+        out << "pageable (not requested)";
+    }
+
+    out << "\nscheduling: " << s.realtime_threads << " thread(s) SCHED_FIFO";
+    if (s.fallback_threads > 0) {
+        out << ", " << s.fallback_threads << " thread(s) fell back to normal scheduling: "
+            << strerror(s.thread_error) << " (needs CAP_SYS_NICE or RLIMIT_RTPRIO)";
+    }
+
+    out << "\nstacks: " << s.prefaulted_bytes / 1024 << " KiB prefaulted";
+    return out.str();
+}
@@ -0,0 +1,111 @@
+#include "recv_size_predictor.h"
+
+/// @brief 大小表长度：16 ~ 496 共 31 档，512 ~ 1MB 共 12 档
+constexpr size_t SIZE_TABLE_LENGTH = 43;
+
+/// @brief 读取填满缓冲区时跳升的档数
+constexpr int INDEX_INCREMENT = 4;
+
+/// @brief 连续读取偏小时下降的档数
+constexpr int INDEX_DECREMENT = 1;
+
+/**
+ * @brief 获取大小表
+ * @return 递增的大小表
+ */
+static const size_t* size_table() {
+    static const size_t* table = [] {
+        static size_t sizes[SIZE_TABLE_LENGTH];
+        size_t i = 0;
+        for (size_t size = 16; size < 512; size += 16) {
+            sizes[i++] = size;
+        }
+        for (size_t size = 512; i < SIZE_TABLE_LENGTH; size <<= 1) {
+            sizes[i++] = size;
+        }
+        return sizes;
+    }();
+    return table;
+}
+
+/**
+ * @brief 在大小表中查找第一个不小于 size 的下标
+ * @param size 目标大小
+ * @return 表下标
+ */
+static uint8_t size_index(size_t size) {
+    const size_t* table = size_table();
+    size_t low = 0;
+    size_t high = SIZE_TABLE_LENGTH - 1;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (table[mid] < size) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return static_cast<uint8_t>(low);
+}
+
+/**
+ * @brief 构造函数实现（默认参数）
+ */
+RecvSizePredictor::RecvSizePredictor()
+    : RecvSizePredictor(DEFAULT_MINIMUM, DEFAULT_INITIAL, DEFAULT_MAXIMUM) {
+}
+
+/**
+ * @brief 构造函数实现
+ * @param minimum 最小接收大小
+ * @param initial 初始接收大小
+ * @param maximum 最大接收大小
+ */
+RecvSizePredictor::RecvSizePredictor(size_t minimum, size_t initial, size_t maximum)
+    : min_index_(size_index(minimum))
+    , max_index_(size_index(maximum))
+    , index_(size_index(initial))
+    , decrease_now_(false) {
+    if (index_ < min_index_) {
+        index_ = min_index_;
+    }
+    if (index_ > max_index_) {
+        index_ = max_index_;
+    }
+}
+
+/**
+ * @brief 获取下一次接收大小
+ */
+size_t RecvSizePredictor::next_size() const {
+    return size_table()[index_];
+}
+
+/**
+ * @brief 记录实际读取量
+ * @param bytes_read 实际读取的字节数
+ *
+ * @details
+ * - 读取量不超过低一档的大小：第一次只做标记，连续第二次才下降
+ * - 读取量达到当前大小：立即跳升 INDEX_INCREMENT 档
+ */
+void RecvSizePredictor::record(size_t bytes_read) {
+    const size_t* table = size_table();
+    int lower = static_cast<int>(index_) - INDEX_DECREMENT;
+    if (lower < min_index_) {
+        lower = min_index_;
+    }
+
+    if (bytes_read <= table[lower]) {
+        if (decrease_now_) {
+            index_ = static_cast<uint8_t>(lower);
+            decrease_now_ = false;
+        } else {
+            decrease_now_ = true;
+        }
+    } else if (bytes_read >= table[index_]) {
+        int upper = index_ + INDEX_INCREMENT;
+        index_ = static_cast<uint8_t>(upper > max_index_ ? max_index_ : upper);
+        decrease_now_ = false;
+    }
+}
@@ -0,0 +1,362 @@
+#include "state_sync.h"
+
+#include <algorithm>
+
+/// @brief 消息类型：完整快照
+constexpr uint8_t TYPE_FULL = 1;
+
+/// @brief 消息类型：增量
+constexpr uint8_t TYPE_DELTA = 2;
+
+/// @brief 消息头大小：类型 + 序号 + 基线序号 + 快照长度
+constexpr size_t HEADER_SIZE = 1 + 8 + 8 + 4;
+
+/// @brief 两个变化区段之间相同字节不超过该数量时合并为一个区段（省去区段头）
+constexpr size_t MERGE_GAP = 4;
+
+/**
+ * @brief 按大端序追加整数
+ */
+template <typename T>
+static void put_be(std::string& out, T value) {
+    for (int shift = static_cast<int>(sizeof(T) * 8) - 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+/**
+ * @brief 按大端序读取整数
+ */
+template <typename T>
+static T get_be(const char* data) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value = static_cast<T>((value << 8) | static_cast<uint8_t>(data[i]));
+    }
+    return value;
+}
+
+/**
+ * @brief 追加 varint（LEB128）
+ */
+static void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief 读取 varint
+ * @param data 读取位置，成功后前移
+ * @param end 数据结尾
+ * @param value 输出的值
+ * @return 是否读取成功
+ */
+static bool get_varint(const char*& data, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*data++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 写消息头
+ */
+static void put_header(std::string& out, uint8_t type, uint64_t sequence, uint64_t baseline, size_t size) {
+    out.push_back(static_cast<char>(type));
+    put_be<uint64_t>(out, sequence);
+    put_be<uint64_t>(out, baseline);
+    put_be<uint32_t>(out, static_cast<uint32_t>(size));
+}
+
+/**
+ * @brief 构造函数实现
+ * @param history 保留的快照份数
+ */
+StateSyncEncoder::StateSyncEncoder(size_t history) : history_(history == 0 ? 1 : history) {
+}
+
+/**
+ * @brief 发布一份新快照
+ * @param snapshot 快照内容
+ * @return 新快照的序号
+ *
+ * @details 历史已满时复用最旧快照的内存
+ */
+uint64_t StateSyncEncoder::publish(std::string_view snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t sequence = snapshots_.empty() ? 1 : snapshots_.back().sequence + 1;
+
+    Snapshot entry{sequence, std::string()};
+    if (snapshots_.size() >= history_) {
+        entry.data = std::move(snapshots_.front().data);
+        snapshots_.pop_front();
+    }
+    entry.data.assign(snapshot.data(), snapshot.size());
+    snapshots_.push_back(std::move(entry));
+    return sequence;
+}
+
+/**
+ * @brief 登记客户端
+ * @param client 客户端标识
+ */
+void StateSyncEncoder::add_client(uint64_t client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_[client] = 0;
+}
+
+/**
+ * @brief 注销客户端
+ * @param client 客户端标识
+ */
+void StateSyncEncoder::remove_client(uint64_t client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.erase(client);
+}
+
+/**
+ * @brief 记录客户端已应用的快照序号
+ * @param client 客户端标识
+ * @param sequence 已应用的序号
+ */
+void StateSyncEncoder::acknowledge(uint64_t client, uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(client);
+    if (it != clients_.end() && sequence > it->second) {
+        it->second = sequence;
+    }
+}
+
+/**
+ * @brief 清除客户端的基线
+ * @param client 客户端标识
+ */
+void StateSyncEncoder::reset_client(uint64_t client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(client);
+    if (it != clients_.end()) {
+        it->second = 0;
+    }
+}
+
+/**
+ * @brief 为单个客户端编码最新快照
+ * @param client 客户端标识
+ * @param out 输出的消息
+ * @return 是否已编码
+ */
+bool StateSyncEncoder::encode(uint64_t client, std::string& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(client);
+    if (it == clients_.end() || snapshots_.empty() || it->second == snapshots_.back().sequence) {
+        return false;
+    }
+    encode_locked(find_locked(it->second) ? it->second : 0, out);
+    return true;
+}
+
+/**
+ * @brief 最新快照的序号
+ */
+uint64_t StateSyncEncoder::sequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshots_.empty() ? 0 : snapshots_.back().sequence;
+}
+
+/**
+ * @brief 按序号查找历史快照
+ * @param sequence 序号
+ * @return 快照指针或 nullptr
+ *
+ * @details 历史中的序号连续，直接按偏移定位
+ */
+const StateSyncEncoder::Snapshot* StateSyncEncoder::find_locked(uint64_t sequence) const {
+    if (sequence == 0 || snapshots_.empty()) {
+        return nullptr;
+    }
+    uint64_t first = snapshots_.front().sequence;
+    if (sequence < first || sequence > snapshots_.back().sequence) {
+        return nullptr;
+    }
+    return &snapshots_[static_cast<size_t>(sequence - first)];
+}
+
+/**
+ * @brief 以 baseline 为基线编码最新快照
+ * @param baseline 基线序号，0 表示完整快照
+ * @param out 输出的消息
+ *
+ * @details
+ * 逐字节比较新快照与基线（基线较短时视为补零），把变化的字节按区段输出为异或值；
+ * 间隔很小的区段合并以减少区段头。增量不比完整快照小时改发完整快照。
+ */
+void StateSyncEncoder::encode_locked(uint64_t baseline, std::string& out) const {
+    const Snapshot& latest = snapshots_.back();
+    const std::string& next = latest.data;
+    size_t length = next.size();
+    out.clear();
+
+    const Snapshot* base = find_locked(baseline);
+    if (base) {
+        const std::string& previous = base->data;
+        auto base_at = [&previous](size_t i) -> char { return i < previous.size() ? previous[i] : 0; };
+
+        put_header(out, TYPE_DELTA, latest.sequence, baseline, length);
+        size_t written = 0;     // 上一个区段的结尾
+        size_t i = 0;
+        while (i < length && out.size() < HEADER_SIZE + length) {
+            if (next[i] == base_at(i)) {
+                ++i;
+                continue;
+            }
+            size_t start = i;
+            size_t last = i;
+            for (++i; i < length && i - last <= MERGE_GAP; ++i) {
+                if (next[i] != base_at(i)) {
+                    last = i;
+                }
+            }
+            size_t end = last + 1;
+            put_varint(out, start - written);
+            put_varint(out, end - start);
+            for (size_t k = start; k < end; ++k) {
+                out.push_back(static_cast<char>(next[k] ^ base_at(k)));
+            }
+            written = end;
+            i = end;
+        }
+        if (out.size() < HEADER_SIZE + length) {
+            return;
+        }
+        out.clear();
+    }
+
+    put_header(out, TYPE_FULL, latest.sequence, 0, length);
+    out.append(next);
+}
+
+/**
+ * @brief 构造函数实现
+ * @param history 保留的快照份数
+ */
+StateSyncDecoder::StateSyncDecoder(size_t history) : history_(history == 0 ? 1 : history) {
+}
+
+/**
+ * @brief 应用一条同步消息
+ * @param data 消息起始地址
+ * @param length 消息长度
+ * @return 应用结果
+ */
+StateSyncDecoder::Result StateSyncDecoder::apply(const char* data, size_t length) {
+    if (length < HEADER_SIZE) {
+        return Result::Malformed;
+    }
+
+    uint8_t type = static_cast<uint8_t>(data[0]);
+    uint64_t sequence = get_be<uint64_t>(data + 1);
+    uint64_t baseline = get_be<uint64_t>(data + 9);
+    size_t size = get_be<uint32_t>(data + 17);
+    const char* payload = data + HEADER_SIZE;
+    const char* end = data + length;
+
+    if (type != TYPE_FULL && type != TYPE_DELTA) {
+        return Result::Malformed;
+    }
+    if (!snapshots_.empty() && sequence <= snapshots_.back().sequence) {
+        return Result::Stale;
+    }
+
+    // 历史已满时复用最旧快照的内存（校验通过之后）
+    Snapshot entry{sequence, std::string()};
+    const Snapshot* base = nullptr;
+    if (type == TYPE_DELTA) {
+        for (const Snapshot& snapshot : snapshots_) {
+            if (snapshot.sequence == baseline) {
+                base = &snapshot;
+                break;
+            }
+        }
+        if (!base) {
+            return Result::MissingBaseline;
+        }
+
+        // 先校验全部区段，避免应用到一半才发现格式错误
+        size_t position = 0;
+        for (const char* cursor = payload; cursor < end; ) {
+            uint64_t skip;
+            uint64_t count;
+            if (!get_varint(cursor, end, skip) || !get_varint(cursor, end, count)
+                || skip > size - position || count > size - position - skip
+                || count > static_cast<size_t>(end - cursor)) {
+                return Result::Malformed;
+            }
+            position += skip + count;
+            cursor += count;
+        }
+
+        // 基线就是最旧的快照时不能复用其内存
+        if (snapshots_.size() >= history_ && base != &snapshots_.front()) {
+            entry.data = std::move(snapshots_.front().data);
+        }
+        entry.data.assign(base->data, 0, std::min(base->data.size(), size));
+        entry.data.resize(size, 0);
+
+        position = 0;
+        while (payload < end) {
+            uint64_t skip;
+            uint64_t count;
+            get_varint(payload, end, skip);
+            get_varint(payload, end, count);
+            position += skip;
+            for (uint64_t k = 0; k < count; ++k) {
+                entry.data[position++] ^= payload[k];
+            }
+            payload += count;
+        }
+    } else {
+        if (static_cast<size_t>(end - payload) != size) {
+            return Result::Malformed;
+        }
+        if (snapshots_.size() >= history_) {
+            entry.data = std::move(snapshots_.front().data);
+        }
+        entry.data.assign(payload, size);
+    }
+
+    if (snapshots_.size() >= history_) {
+        snapshots_.pop_front();
+    }
+    snapshots_.push_back(std::move(entry));
+    return Result::Applied;
+}
+
+/**
+ * @brief 当前快照内容
+ */
+const std::string& StateSyncDecoder::state() const {
+    static const std::string empty;
+    return snapshots_.empty() ? empty : snapshots_.back().data;
+}
+
+/**
+ * @brief 当前快照序号
+ */
+uint64_t StateSyncDecoder::sequence() const {
+    return snapshots_.empty() ? 0 : snapshots_.back().sequence;
+}
+
+/**
+ * @brief 丢弃所有快照
+ */
+void StateSyncDecoder::reset() {
+    snapshots_.clear();
+}
@@ -3,17 +3,22 @@
 /**
  * @brief 构造函数实现
  * @param num_threads 要创建的工作线程数量
+ * @param init 线程初始化函数
  * 
  * @details
- * 创建指定数量的工作线程，每个线程执行以下逻辑：
+ * 创建指定数量的工作线程，每个线程先调用初始化函数，然后执行以下逻辑：
  * 1. 等待条件变量通知
  * 2. 从任务队列获取任务
  * 3. 执行任务
  * 4. 重复上述过程直到线程池关闭
  */
-ThreadPool::ThreadPool(size_t num_threads) : stop_(false) {
+ThreadPool::ThreadPool(size_t num_threads, ThreadInit init) : stop_(false) {
     for (size_t i = 0; i < num_threads; ++i) {
-        workers_.emplace_back([this] {
+        workers_.emplace_back([this, init, i] {
+            if (init) {
+                init(i);
+            }
+            
             while (true) {
                 std::function<void()> task;
                 
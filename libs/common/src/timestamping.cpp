@@ -0,0 +1,110 @@
+#include "timestamping.h"
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+/**
+ * @brief 为 socket 开启软件时间戳
+ * @param fd socket 文件描述符
+ * @param options 时间戳配置
+ * @return 是否成功
+ */
+bool Timestamping::enable(int fd, const TimestampingOptions& options) {
+    unsigned int flags = 0;
+    if (options.rx) {
+        flags |= SOF_TIMESTAMPING_RX_SOFTWARE;
+    }
+    if (options.tx) {
+        flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    }
+    if (flags == 0) {
+        return true;
+    }
+    flags |= SOF_TIMESTAMPING_SOFTWARE;
+    return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+}
+
+/**
+ * @brief 从控制信息中取出接收时间戳
+ * @param msg recvmsg 填充的消息头
+ * @return 内核时间戳（纳秒），没有时为 0
+ *
+ * @details scm_timestamping 的 ts[0] 为软件时间戳，ts[2] 为硬件时间戳
+ */
+int64_t Timestamping::rx_timestamp(const msghdr& msg) {
+    if (msg.msg_controllen == 0) {
+        return 0;
+    }
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping stamps;
+            memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            return static_cast<int64_t>(stamps.ts[0].tv_sec) * 1000000000 + stamps.ts[0].tv_nsec;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 不阻塞地从错误队列读取发送时间戳
+ * @param fd socket 文件描述符
+ * @param out 输出数组
+ * @param max 最多读取的条数
+ * @param more 输出参数，是否取满
+ * @return 读到的时间戳条数
+ *
+ * @details 每条错误队列消息带两项控制信息：SCM_TIMESTAMPING 给出时间戳，
+ *          IP_RECVERR / IPV6_RECVERR 的 sock_extended_err 给出来源、类型和编号
+ */
+size_t Timestamping::read_tx(int fd, TxTimestamp* out, size_t max, bool& more) {
+    max = std::min(max, TX_BATCH);
+    mmsghdr headers[TX_BATCH];
+    alignas(cmsghdr) char control[TX_BATCH][CONTROL_SIZE];
+    for (size_t i = 0; i < max; ++i) {
+        memset(&headers[i], 0, sizeof(headers[i]));
+        headers[i].msg_hdr.msg_control = control[i];
+        headers[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+    }
+
+    int count = recvmmsg(fd, headers, static_cast<unsigned int>(max), MSG_ERRQUEUE | MSG_DONTWAIT, nullptr);
+    more = count == static_cast<int>(max);
+    if (count <= 0) {
+        return 0;
+    }
+
+    size_t found = 0;
+    for (int i = 0; i < count; ++i) {
+        msghdr& msg = headers[i].msg_hdr;
+        int64_t ns = 0;
+        bool matched = false;
+        uint32_t id = 0;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                scm_timestamping stamps;
+                memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+                ns = static_cast<int64_t>(stamps.ts[0].tv_sec) * 1000000000 + stamps.ts[0].tv_nsec;
+            } else if ((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)
+                       || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                sock_extended_err error;
+                memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+                if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING
+                    && error.ee_info == SCM_TSTAMP_SND) {
+                    matched = true;
+                    id = error.ee_data;
+                }
+            }
+        }
+        if (matched && ns != 0) {
+            out[found].id = id;
+            out[found].ns = ns;
+            ++found;
+        }
+    }
+    return found;
+}
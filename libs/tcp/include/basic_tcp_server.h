@@ -0,0 +1,251 @@
+/**
+ * @file basic_tcp_server.h
+ * @brief 静态分发的 TCP 服务器模板的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * BasicTcpServer 在 TcpServerBase 之上按模板参数组合三部分：
+ * - Handler: 处理连接、断开和消息事件的类型
+ * - Codec: 分帧策略（见 codec.h），默认 RawCodec
+ * - Executor: 消息回调的执行位置（见 executor.h），默认 InlineExecutor
+ *
+ * 每次就绪读取只有一次虚调用（TcpServerBase::on_data），之后的分帧与
+ * 逐条消息分发都在模板内完成，Handler 的回调可以被编译器内联，
+ * 不经过 std::function，也不拷贝消息。
+ *
+ * Handler 需要提供 on_message 或 on_batch 之一（on_connect / on_disconnect 可省略）：
+ * @code
+ * void on_message(Server& server, int client_fd, std::string_view message);
+ * void on_batch(Server& server, Span<const TcpMessage> messages);
+ * void on_connect(Server& server, int client_fd, const std::string& client_addr);
+ * void on_disconnect(Server& server, int client_fd);
+ * @endcode
+ *
+ * on_batch 每次就绪读取调用一次，交付本次读到的全部完整消息，便于合并数据库写入、
+ * 加锁或响应刷新；批量回调总是在 I/O 线程中执行，不经过执行器。
+ * 两者都提供时默认逐条分发，派生类可以用 set_batch_dispatch() 切换。
+ *
+ * @example
+ * @code
+ * struct EchoHandler {
+ *     template <typename Server>
+ *     void on_message(Server& server, int fd, std::string_view msg) {
+ *         server.send_to(fd, msg);
+ *     }
+ * };
+ * BasicTcpServer<EchoHandler, LineCodec> server("0.0.0.0", 8080);
+ * server.start();
+ * @endcode
+ */
+
+#ifndef BASIC_TCP_SERVER_H
+#define BASIC_TCP_SERVER_H
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tcp_server_base.h"
+#include "codec.h"
+#include "executor.h"
+#include "span.h"
+
+/**
+ * @struct TcpMessage
+ * @brief 批量回调中的一条消息
+ */
+struct TcpMessage {
+    int client_fd;              ///< 发送消息的客户端文件描述符
+    std::string_view data;      ///< 消息内容，只在回调期间有效
+};
+
+namespace detail {
+
+/// @brief 检测 Handler 是否提供 on_message
+template <typename Handler, typename Server, typename = void>
+struct has_on_message : std::false_type {};
+
+template <typename Handler, typename Server>
+struct has_on_message<Handler, Server, std::void_t<decltype(std::declval<Handler&>().on_message(
+    std::declval<Server&>(), 0, std::declval<std::string_view>()))>> : std::true_type {};
+
+/// @brief 检测 Handler 是否提供 on_batch
+template <typename Handler, typename Server, typename Message, typename = void>
+struct has_on_batch : std::false_type {};
+
+template <typename Handler, typename Server, typename Message>
+struct has_on_batch<Handler, Server, Message, std::void_t<decltype(std::declval<Handler&>().on_batch(
+    std::declval<Server&>(), std::declval<Span<const Message>>()))>> : std::true_type {};
+
+/// @brief 检测 Handler 是否提供 on_connect
+template <typename Handler, typename Server, typename = void>
+struct has_on_connect : std::false_type {};
+
+template <typename Handler, typename Server>
+struct has_on_connect<Handler, Server, std::void_t<decltype(std::declval<Handler&>().on_connect(
+    std::declval<Server&>(), 0, std::declval<const std::string&>()))>> : std::true_type {};
+
+/// @brief 检测 Handler 是否提供 on_disconnect
+template <typename Handler, typename Server, typename = void>
+struct has_on_disconnect : std::false_type {};
+
+template <typename Handler, typename Server>
+struct has_on_disconnect<Handler, Server, std::void_t<decltype(std::declval<Handler&>().on_disconnect(
+    std::declval<Server&>(), 0))>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * @class BasicTcpServer
+ * @brief 以 Handler / Codec / Executor 为模板参数的 TCP 服务器
+ *
+ * @tparam Handler 事件处理类型
+ * @tparam Codec 分帧策略
+ * @tparam Executor 消息回调执行器
+ *
+ * @note on_connect / on_disconnect 总是在 I/O 线程中执行；执行器只调度 on_message，
+ *       因此转交到其他线程时，on_disconnect 可能先于该连接积压的消息执行
+ */
+template <typename Handler, typename Codec = RawCodec, typename Executor = InlineExecutor>
+class BasicTcpServer : public TcpServerBase {
+public:
+    /**
+     * @brief 构造函数，Handler / Codec / Executor 均默认构造
+     * @param ip 服务器绑定的 IP 地址
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小（即事件循环数量），默认为 4
+     */
+    BasicTcpServer(const std::string& ip, uint16_t port, size_t thread_pool_size = 4)
+        : TcpServerBase(ip, port, thread_pool_size) {
+        set_data_end_hook(HAS_BATCH);
+        set_batch_dispatch(BATCH_ONLY);
+    }
+
+    /**
+     * @brief 构造函数
+     * @param ip 服务器绑定的 IP 地址
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小
+     * @param handler 事件处理对象
+     * @param codec 分帧策略对象
+     * @param executor 执行器对象
+     */
+    BasicTcpServer(const std::string& ip, uint16_t port, size_t thread_pool_size,
+                   Handler handler, Codec codec = Codec(), Executor executor = Executor())
+        : TcpServerBase(ip, port, thread_pool_size)
+        , handler_(std::move(handler))
+        , codec_(std::move(codec))
+        , executor_(std::move(executor)) {
+        set_data_end_hook(HAS_BATCH);
+        set_batch_dispatch(BATCH_ONLY);
+    }
+
+    /**
+     * @brief 析构函数
+     * @details 先停止服务器，保证 Handler 析构后不再有回调
+     */
+    ~BasicTcpServer() override {
+        stop();
+    }
+
+    /**
+     * @brief 获取事件处理对象
+     * @note 修改处理对象的状态应在 start() 之前完成，或由 Handler 自行同步
+     */
+    Handler& handler() { return handler_; }
+
+    /**
+     * @brief 获取分帧策略对象
+     * @note 必须在 start() 之前修改
+     */
+    Codec& codec() { return codec_; }
+
+    /**
+     * @brief 获取执行器对象
+     */
+    Executor& executor() { return executor_; }
+
+protected:
+    void on_connect(int client_fd, const std::string& client_addr) override {
+        if constexpr (detail::has_on_connect<Handler, BasicTcpServer>::value) {
+            handler_.on_connect(*this, client_fd, client_addr);
+        } else {
+            (void)client_fd;
+            (void)client_addr;
+        }
+    }
+
+    bool on_data(int client_fd, const char* data, size_t length, size_t& consumed) override {
+        while (consumed < length) {
+            std::string_view message;
+            size_t frame_length = codec_.decode(data + consumed, length - consumed, message);
+            if (frame_length == 0) {
+                break;
+            }
+            if (frame_length == CODEC_ERROR) {
+                return false;
+            }
+            // 本轮消息配额用完，剩余消息留到下一轮
+            if (!acquire_message_quota()) {
+                break;
+            }
+            consumed += frame_length;
+
+            if constexpr (HAS_BATCH) {
+                if (batch_dispatch()) {
+                    pending_batch().push_back(TcpMessage{client_fd, message});
+                    continue;
+                }
+            }
+            if constexpr (HAS_MESSAGE) {
+                executor_.execute(static_cast<uint64_t>(client_fd), message, [this, client_fd](std::string_view m) {
+                    handler_.on_message(*this, client_fd, m);
+                });
+            }
+        }
+        return true;
+    }
+
+    void on_data_end(int client_fd) override {
+        (void)client_fd;
+        if constexpr (HAS_BATCH) {
+            std::vector<TcpMessage>& batch = pending_batch();
+            if (!batch.empty()) {
+                handler_.on_batch(*this, Span<const TcpMessage>(batch.data(), batch.size()));
+                batch.clear();
+            }
+        }
+    }
+
+    void on_disconnect(int client_fd) override {
+        if constexpr (detail::has_on_disconnect<Handler, BasicTcpServer>::value) {
+            handler_.on_disconnect(*this, client_fd);
+        } else {
+            (void)client_fd;
+        }
+    }
+
+private:
+    static constexpr bool HAS_MESSAGE = detail::has_on_message<Handler, BasicTcpServer>::value;
+    static constexpr bool HAS_BATCH = detail::has_on_batch<Handler, BasicTcpServer, TcpMessage>::value;
+    static constexpr bool BATCH_ONLY = HAS_BATCH && !HAS_MESSAGE;
+
+    static_assert(HAS_MESSAGE || HAS_BATCH, "Handler must provide on_message or on_batch");
+
+    /**
+     * @brief 当前 I/O 线程尚未交付的批量消息
+     * @details 每个事件循环线程一个，容量增长到位后不再分配内存
+     */
+    static std::vector<TcpMessage>& pending_batch() {
+        thread_local std::vector<TcpMessage> batch;
+        return batch;
+    }
+
+    Handler handler_;       // 事件处理对象
+    Codec codec_;           // 分帧策略
+    Executor executor_;     // 消息回调执行器
+};
+
+#endif // BASIC_TCP_SERVER_H
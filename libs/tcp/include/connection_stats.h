@@ -0,0 +1,210 @@
+/**
+ * @file connection_stats.h
+ * @brief 连接统计表的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 监控需要定期查看每个连接的收发量、积压和活跃时间。在客户端列表的互斥锁下逐个拷贝
+ * 连接信息会阻塞接受连接和发送，十万级连接时每次要分配十万个字符串。
+ *
+ * ConnectionStatsTable 按 fd 下标保存每个连接的紧凑记录（一条记录占一个缓存行），
+ * 由 I/O 路径在已有的读写位置顺带更新，查询方完全不加锁：
+ * - 每条记录带一个序号（seqlock），写入期间为奇数；读者在序号前后一致时才采用读到的内容，
+ *   因此单条记录总是一致的快照，不会读到一半更新的计数
+ * - 写入方可能是所属事件循环（接收）和持有客户端列表锁的发送线程，写入前以 CAS
+ *   把序号置为奇数，同一连接的两类写入互相等待，只在同一条记录上竞争
+ * - 表按进程的文件描述符上限建立块目录，每 CHUNK_RECORDS 个 fd 一块，块在其中第一个连接
+ *   建立时才分配；开启 RealtimeOptions::lock_memory（mlockall）时锁定的也只是已分配的块
+ *
+ * 遍历按 fd 递增分页，每页返回下一页的起点；不同记录的读取时刻不同，整张表不是同一时刻的快照。
+ */
+
+#ifndef CONNECTION_STATS_H
+#define CONNECTION_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @struct ConnectionStats
+ * @brief 单个连接的统计快照
+ */
+struct ConnectionStats {
+    int fd = -1;                    ///< 客户端文件描述符
+    uint32_t loop_index = 0;        ///< 所属事件循环下标
+    uint32_t ip = 0;                ///< 客户端 IP（网络字节序）
+    uint16_t port = 0;              ///< 客户端端口（主机字节序）
+    int64_t connected_ns = 0;       ///< 建立连接的时刻（单调时钟纳秒，与 Clock::now_ns() 同一时间轴）
+    int64_t last_activity_ns = 0;   ///< 最近一次读到或写出数据的时刻
+    uint64_t bytes_in = 0;          ///< 读到的字节数
+    uint64_t bytes_out = 0;         ///< 写入 socket 的字节数
+    uint64_t messages_in = 0;       ///< 分发的消息数
+    uint64_t messages_out = 0;      ///< 接受发送（直接写出或排队）的消息数
+    uint64_t queued_bytes = 0;      ///< 输出缓冲区中待发送的字节数
+};
+
+/**
+ * @struct ConnectionFilter
+ * @brief 遍历连接时的过滤条件，所有条件同时满足的连接才返回
+ */
+struct ConnectionFilter {
+    int loop_index = -1;                        ///< 只返回该事件循环的连接，-1 表示不限
+    std::chrono::milliseconds idle_for{0};      ///< 最近一次活动距今至少这么久
+    std::chrono::milliseconds connected_for{0}; ///< 建立连接至今至少这么久
+    uint64_t min_queued_bytes = 0;              ///< 待发送字节数至少这么多
+};
+
+/**
+ * @class ConnectionStatsTable
+ * @brief 按 fd 索引、无锁读取的连接统计表
+ *
+ * @note 写入方需保证同一 fd 的 open() 先于其他写入、close() 在 fd 关闭之前，
+ *       fd 被复用时记录由新连接的 open() 重置
+ */
+class ConnectionStatsTable {
+public:
+    ConnectionStatsTable() = default;
+    ~ConnectionStatsTable();
+
+    ConnectionStatsTable(const ConnectionStatsTable&) = delete;
+    ConnectionStatsTable& operator=(const ConnectionStatsTable&) = delete;
+
+    /// @brief 每个记录块的记录数（64KB）
+    static constexpr size_t CHUNK_RECORDS = 1024;
+
+    /**
+     * @brief 创建记录块目录
+     * @param capacity fd 上限，记录数
+     * @return true 成功，false 容量为 0（之后所有操作都不生效）
+     *
+     * @details 只能调用一次；记录块保留到析构，读者不会访问到已释放的内存
+     */
+    bool init(size_t capacity);
+
+    /**
+     * @brief 开始记录一个新连接，清零计数
+     * @param fd 客户端文件描述符
+     * @param ip 客户端 IP（网络字节序）
+     * @param port 客户端端口（主机字节序）
+     * @param loop_index 所属事件循环下标
+     * @param now_ns 当前时刻
+     */
+    void open(int fd, uint32_t ip, uint16_t port, uint32_t loop_index, int64_t now_ns);
+
+    /**
+     * @brief 连接关闭，之后遍历不再返回该记录
+     * @param fd 客户端文件描述符
+     */
+    void close(int fd);
+
+    /**
+     * @brief 连接迁移到其他事件循环
+     * @param fd 客户端文件描述符
+     * @param loop_index 新的事件循环下标
+     */
+    void set_loop(int fd, uint32_t loop_index);
+
+    /**
+     * @brief 记录读取
+     * @param fd 客户端文件描述符
+     * @param bytes 读到的字节数，非 0 时更新最近活动时刻
+     * @param messages 分发的消息数
+     * @param now_ns 当前时刻
+     */
+    void record_input(int fd, uint64_t bytes, uint64_t messages, int64_t now_ns);
+
+    /**
+     * @brief 记录发送
+     * @param fd 客户端文件描述符
+     * @param bytes 写入 socket 的字节数，非 0 时更新最近活动时刻
+     * @param messages 接受发送的消息数
+     * @param queued_bytes 当前待发送的字节数
+     * @param now_ns 当前时刻
+     */
+    void record_output(int fd, uint64_t bytes, uint64_t messages, uint64_t queued_bytes, int64_t now_ns);
+
+    /**
+     * @brief 读取单个连接的统计
+     * @param fd 客户端文件描述符
+     * @param stats 输出参数
+     * @return true 连接存在，false 不存在
+     */
+    bool read(int fd, ConnectionStats& stats) const;
+
+    /**
+     * @brief 分页遍历连接
+     * @param cursor 本页的起始 fd，第一页为 0
+     * @param limit 本页最多返回的连接数
+     * @param filter 过滤条件
+     * @param now_ns 当前时刻，用于 idle_for / connected_for
+     * @param out 输出参数，先清空再按 fd 递增追加
+     * @return 下一页的起始 fd，-1 表示已遍历完
+     */
+    int scan(int cursor, size_t limit, const ConnectionFilter& filter, int64_t now_ns,
+             std::vector<ConnectionStats>& out) const;
+
+    /**
+     * @brief 当前记录中的连接数
+     */
+    size_t open_count() const { return open_count_.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @struct Record
+     * @brief 一条连接记录，字段都是原子变量，读者在写入期间读到的值由序号判定作废
+     */
+    struct alignas(64) Record {
+        std::atomic<uint32_t> sequence;         // 序号，奇数表示正在写入
+        std::atomic<uint32_t> ip;               // 客户端 IP
+        std::atomic<uint16_t> port;             // 客户端端口
+        std::atomic<uint16_t> loop_index;       // 所属事件循环下标
+        std::atomic<uint32_t> queued_bytes;     // 待发送字节数（超过 4GB 时饱和）
+        std::atomic<int64_t> connected_ns;      // 建立连接的时刻，0 表示空闲记录
+        std::atomic<int64_t> last_activity_ns;  // 最近一次活动的时刻
+        std::atomic<uint64_t> bytes_in;         // 读到的字节数
+        std::atomic<uint64_t> bytes_out;        // 写出的字节数
+        std::atomic<uint64_t> messages_in;      // 分发的消息数
+        std::atomic<uint64_t> messages_out;     // 接受发送的消息数
+    };
+    static_assert(sizeof(Record) == 64, "Record must fit one cache line");
+
+    /**
+     * @brief 查找 fd 的记录，越界或所在块尚未分配时为 nullptr
+     */
+    Record* find(int fd) const;
+
+    /**
+     * @brief 查找 fd 的记录，所在块尚未分配时分配，越界或分配失败时为 nullptr
+     */
+    Record* find_or_allocate(int fd);
+
+    /**
+     * @brief 开始写入：把序号置为奇数
+     * @return 写入前的（偶数）序号
+     */
+    static uint32_t begin_write(Record& record);
+
+    /**
+     * @brief 结束写入：序号加二回到偶数
+     */
+    static void end_write(Record& record, uint32_t sequence);
+
+    /**
+     * @brief 读取一条记录的一致快照
+     * @return true 记录在用，false 空闲
+     */
+    bool load(const Record& record, int fd, ConnectionStats& stats) const;
+
+    std::unique_ptr<std::atomic<Record*>[]> chunks_; // 记录块目录，块分配后指针不变
+    size_t chunk_count_ = 0;                    // 目录项数
+    size_t capacity_ = 0;                       // 记录数（fd 上限）
+    std::atomic<int> high_water_{-1};           // 出现过的最大 fd，遍历的上界
+    std::atomic<size_t> open_count_{0};         // 在用的记录数
+};
+
+#endif // CONNECTION_STATS_H
@@ -31,6 +31,14 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "magic_ring_buffer.h"
+#include "recv_size_predictor.h"
+#include "rcu.h"
+#include "busy_poll.h"
+#include "realtime.h"
+#include "tcp_info.h"
 
 /**
  * @class TcpClient
@@ -39,8 +47,9 @@
  * @details
  * 该类封装了 TCP 客户端的基本功能：
  * - 连接到指定的服务器地址和端口
- * - 发送字符串消息
- * - 在后台线程接收消息
+ * - 发送字符串消息；紧急消息（心跳、取消等）先于等待中的普通消息获得 socket
+ * - 在后台线程接收消息，接收缓冲区大小随实际消息大小自适应调整
+ * - 可选的分帧函数：数据读入双重映射的环形缓冲区，分帧函数总是看到连续的数据
  * - 通过回调通知消息接收和连接状态变化
  */
 class TcpClient {
@@ -56,6 +65,22 @@ public:
      * @param connected true 表示已连接，false 表示已断开
      */
     using ConnectionCallback = std::function<void(bool connected)>;
+
+    /**
+     * @brief 分帧函数类型
+     * @param data 尚未处理的数据起始地址
+     * @param length 尚未处理的数据长度
+     * @return 第一个完整消息的字节数；数据不足一个完整消息时返回 0
+     */
+    using FrameSplitter = std::function<size_t(const char* data, size_t length)>;
+
+    /**
+     * @brief 发送消息的优先级
+     */
+    enum class Priority {
+        Urgent,     ///< 紧急消息，当前消息写完后先于所有等待中的普通消息发送
+        Normal      ///< 普通消息，按获得 socket 的先后发送
+    };
     
     /**
      * @brief 构造函数
@@ -103,23 +128,85 @@ public:
     /**
      * @brief 发送消息到服务器
      * @param message 要发送的消息内容
+     * @param priority 消息优先级
      * @return true 发送成功，false 发送失败或未连接
+     *
+     * @details
+     * 每条消息是一帧，总是完整写出，不会与其他线程的消息交错。多个线程同时发送时，
+     * 紧急消息在正在写出的消息结束后（帧边界）立即获得 socket，排在所有等待中的普通消息之前。
      * 
      * @note 该函数是线程安全的
      */
-    bool send(const std::string& message);
+    bool send(const std::string& message, Priority priority = Priority::Normal);
     
     /**
      * @brief 设置消息接收回调
      * @param callback 接收到消息时调用的回调函数
+     *
+     * @note 可以在运行中随时调用（包括在回调内部），旧回调在宽限期后释放
      */
     void set_message_callback(MessageCallback callback);
     
     /**
      * @brief 设置连接状态变化回调
      * @param callback 连接状态变化时调用的回调函数
+     *
+     * @note 可以在运行中随时调用，旧回调在宽限期后释放
      */
     void set_connection_callback(ConnectionCallback callback);
+
+    /**
+     * @brief 设置分帧函数
+     * @param splitter 分帧函数，未设置时每次读到的数据作为一条消息
+     *
+     * @details 必须在 connect() 之前调用。半包数据暂存在输入环形缓冲区中
+     */
+    void set_frame_splitter(FrameSplitter splitter);
+
+    /**
+     * @brief 设置接收线程的忙轮询模式
+     * @param options 忙轮询配置
+     *
+     * @details 必须在 connect() 之前调用。启用后接收线程以 MSG_DONTWAIT 读取自旋，
+     *          连续空转超过 idle_timeout 后退回 select 等待，收到数据后重新自旋。
+     *          SO_BUSY_POLL / SO_PREFER_BUSY_POLL 被内核拒绝时打印警告并只保留自旋
+     */
+    void set_busy_poll(const BusyPollOptions& options) { busy_poll_ = options; }
+
+    /**
+     * @brief 设置接收线程的实时化配置
+     * @param options 实时化配置
+     *
+     * @details 必须在 connect() 之前调用。接收线程启动时以 io_priority 切换为 SCHED_FIFO、
+     *          预写入栈，lock_memory 为 true 时对整个进程 mlockall。
+     *          权限不足时退化为普通调度并打印一次警告，结果见 Realtime::report()
+     */
+    void set_realtime(const RealtimeOptions& options) { realtime_ = options; }
+
+    /**
+     * @brief 设置 TCP_INFO 采样
+     * @param options 采样配置（max_per_tick 不使用）
+     *
+     * @details 必须在 connect() 之前调用。接收线程每隔 interval 采样一次连接的 TCP_INFO，
+     *          空闲时 select 的超时缩短到 interval，保证没有数据时也按时采样
+     */
+    void set_tcp_info_sampling(const TcpInfoOptions& options);
+
+    /**
+     * @brief 获取最近一次的 TCP_INFO 采样
+     * @return 最近一次采样，sampled_ns 为 0 表示尚未采样
+     *
+     * @note 该函数是线程安全的
+     */
+    TcpInfoSample tcp_info() const;
+
+    /**
+     * @brief 获取 TCP_INFO 采样的汇总分布
+     * @return 各项指标摘要，未启用时各项为空
+     *
+     * @note 该函数是线程安全的
+     */
+    TcpInfoStats tcp_info_stats() const;
     
     /**
      * @brief 获取当前连接状态
@@ -133,14 +220,54 @@ private:
      * @details 持续从 socket 接收数据，直到连接断开
      */
     void receive_loop();
+
+    /**
+     * @brief 从输入环形缓冲区中切分完整消息并触发回调
+     * @return 已处理的字节数
+     */
+    size_t dispatch_frames();
+
+    /**
+     * @brief 触发连接状态回调
+     * @param connected 当前是否已连接
+     */
+    void notify_connection(bool connected);
+
+    /**
+     * @brief 保证输入环形缓冲区至少有 length 字节可写，必要时换用更大的档位
+     * @param length 需要的可写字节数
+     * @return true 成功，false 映射失败
+     */
+    bool reserve_input(size_t length);
+
+    /**
+     * @brief 距上次采样超过 interval 时采样一次 TCP_INFO
+     * @param now_ns 当前时刻（单调时钟纳秒）
+     */
+    void sample_tcp_info(int64_t now_ns);
     
     int socket_fd_;                         // socket 文件描述符
     std::atomic<bool> connected_;           // 连接状态标志
     std::thread receive_thread_;            // 接收消息的线程
-    std::mutex send_mutex_;                 // 发送操作的互斥锁
+    std::mutex send_mutex_;                 // 发送状态的互斥锁
+    std::condition_variable send_cv_;       // 等待 socket 空闲的条件变量
+    bool sending_;                          // 是否有线程正在写 socket，受 send_mutex_ 保护
+    uint32_t urgent_waiting_;               // 等待中的紧急消息数，受 send_mutex_ 保护
+    
+    RingBufferPool ring_pool_;              // 输入环形缓冲区池
+    MagicRingBuffer* input_;                // 输入环形缓冲区，仅由接收线程访问
+    RecvSizePredictor predictor_;           // 接收大小预测器
+    std::string message_;                   // 复用的消息字符串，仅由接收线程访问
     
-    MessageCallback message_callback_;      // 消息接收回调
-    ConnectionCallback connection_callback_;// 连接状态回调
+    RcuCell<MessageCallback> message_callback_;         // 消息接收回调（可在运行中替换）
+    RcuCell<ConnectionCallback> connection_callback_;   // 连接状态回调（可在运行中替换）
+    FrameSplitter frame_splitter_;          // 分帧函数
+    BusyPollOptions busy_poll_;             // 接收线程的忙轮询配置
+    RealtimeOptions realtime_;              // 接收线程的实时化配置
+    TcpInfoOptions tcp_info_options_;       // TCP_INFO 采样配置
+    TcpInfoSample tcp_info_;                // 最近一次 TCP_INFO 采样，受 tcp_info_mutex_ 保护
+    mutable std::mutex tcp_info_mutex_;     // 最近一次采样的互斥锁
+    std::unique_ptr<TcpInfoHistograms> tcp_info_histograms_; // TCP_INFO 直方图，启用采样时创建
 };
 
 #endif // TCP_CLIENT_H
@@ -0,0 +1,132 @@
+/**
+ * @file tcp_info.h
+ * @brief TCP_INFO 采样的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 客户端延迟变差时，需要区分原因是往返时间变长、发生了重传，还是拥塞窗口在收缩。
+ * 内核为每个 TCP 连接维护这些指标，通过 getsockopt(TCP_INFO) 读取。
+ * 本文件提供单次采样和汇总直方图：
+ * - TcpInfoSampler::sample() 读取一次并换算为 TcpInfoSample，重传数按与上一次采样的差值计
+ * - TcpInfoHistograms 记录各连接的采样，汇总为各项指标的分布
+ *
+ * 采样是一次系统调用，服务器按 TcpInfoOptions 限速：每个连接两次采样之间至少间隔 interval，
+ * 每个事件循环每次定时处理最多采样 max_per_tick 个连接。
+ */
+
+#ifndef TCP_INFO_H
+#define TCP_INFO_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "histogram.h"
+
+/**
+ * @struct TcpInfoOptions
+ * @brief TCP_INFO 采样配置
+ */
+struct TcpInfoOptions {
+    bool enabled = false;                           ///< 是否启用
+    std::chrono::milliseconds interval{1000};       ///< 每个连接两次采样的最小间隔
+    size_t max_per_tick = 256;                      ///< 每个事件循环每次定时处理最多采样的连接数
+};
+
+/**
+ * @struct TcpInfoSample
+ * @brief 一次 TCP_INFO 采样
+ */
+struct TcpInfoSample {
+    int64_t sampled_ns = 0;         ///< 采样时刻（单调时钟纳秒），0 表示尚未采样
+    uint32_t rtt_us = 0;            ///< 平滑往返时间（微秒）
+    uint32_t rttvar_us = 0;         ///< 往返时间的平均偏差（微秒）
+    uint32_t cwnd = 0;              ///< 拥塞窗口（报文段）
+    uint32_t total_retrans = 0;     ///< 连接建立以来重传的报文段数
+    uint32_t retransmits = 0;       ///< 与上一次采样相比新增的重传报文段数
+    uint32_t unacked = 0;           ///< 已发送未确认的报文段数
+    uint64_t unacked_bytes = 0;     ///< 已发送未确认的字节数（按报文段数乘以 MSS 估算）
+    uint64_t delivery_rate = 0;     ///< 最近的交付速率（字节/秒），内核不支持时为 0
+};
+
+/**
+ * @struct TcpInfoStats
+ * @brief 各项指标分布的摘要
+ */
+struct TcpInfoStats {
+    Histogram::Summary rtt_us;          ///< 往返时间（微秒）
+    Histogram::Summary rttvar_us;       ///< 往返时间偏差（微秒）
+    Histogram::Summary cwnd;            ///< 拥塞窗口（报文段）
+    Histogram::Summary retransmits;     ///< 每个采样间隔新增的重传报文段数
+    Histogram::Summary delivery_rate;   ///< 交付速率（字节/秒）
+    Histogram::Summary unacked_bytes;   ///< 已发送未确认的字节数
+};
+
+/**
+ * @struct TcpInfoHistograms
+ * @brief 各项指标的直方图
+ */
+struct TcpInfoHistograms {
+    Histogram rtt_us;
+    Histogram rttvar_us;
+    Histogram cwnd;
+    Histogram retransmits;
+    Histogram delivery_rate;
+    Histogram unacked_bytes;
+
+    /**
+     * @brief 记录一次采样
+     */
+    void record(const TcpInfoSample& sample) {
+        rtt_us.record(sample.rtt_us);
+        rttvar_us.record(sample.rttvar_us);
+        cwnd.record(sample.cwnd);
+        retransmits.record(sample.retransmits);
+        delivery_rate.record(sample.delivery_rate);
+        unacked_bytes.record(sample.unacked_bytes);
+    }
+
+    /**
+     * @brief 把另一组直方图累加进来
+     */
+    void merge(const TcpInfoHistograms& other) {
+        rtt_us.merge(other.rtt_us);
+        rttvar_us.merge(other.rttvar_us);
+        cwnd.merge(other.cwnd);
+        retransmits.merge(other.retransmits);
+        delivery_rate.merge(other.delivery_rate);
+        unacked_bytes.merge(other.unacked_bytes);
+    }
+
+    /**
+     * @brief 生成摘要
+     */
+    TcpInfoStats stats() const {
+        TcpInfoStats stats;
+        stats.rtt_us = rtt_us.summary();
+        stats.rttvar_us = rttvar_us.summary();
+        stats.cwnd = cwnd.summary();
+        stats.retransmits = retransmits.summary();
+        stats.delivery_rate = delivery_rate.summary();
+        stats.unacked_bytes = unacked_bytes.summary();
+        return stats;
+    }
+};
+
+/**
+ * @class TcpInfoSampler
+ * @brief TCP_INFO 采样的静态工具函数
+ */
+class TcpInfoSampler {
+public:
+    /**
+     * @brief 采样一次
+     * @param fd TCP socket 文件描述符
+     * @param sample 输入上一次的采样（用于计算新增重传），输出本次采样
+     * @param now_ns 采样时刻（单调时钟纳秒）
+     * @return true 成功，false getsockopt 失败（sample 不变）
+     */
+    static bool sample(int fd, TcpInfoSample& sample, int64_t now_ns);
+};
+
+#endif // TCP_INFO_H
@@ -3,16 +3,22 @@
  * @brief TCP 服务器类的头文件
  * @author CSQL
  * @date 2025-12-14
- * 
+ *
  * @details
  * 提供多客户端 TCP 服务器功能，支持：
  * - 监听指定端口并接受客户端连接
- * - 使用线程池处理多个客户端
- * - 向单个客户端或所有客户端发送消息
- * - 通过回调处理连接、断开和消息事件
- * 
+ * - 使用多个 epoll 事件循环（运行在线程池中）处理大量客户端
+ * - 向单个客户端或所有客户端发送消息（非阻塞，未发完的数据排队发送）
+ * - 通过回调处理连接、断开和消息事件，也可以按每次就绪读取批量接收消息
+ * - 可选的分帧函数，把字节流切分为完整的消息
+ * - 缓冲内存记账：全局预算与单连接上限，超限时按策略暂停读取、
+ *   丢弃低优先级输出或断开占用最多的连接
+ *
+ * TcpServer 是 BasicTcpServer 基于 std::function 回调的实例化，回调可以在运行时设置。
+ * 对延迟敏感的场景可以直接使用 BasicTcpServer，让消息处理在编译期绑定并内联。
+ *
  * @note 该类不可拷贝
- * 
+ *
  * @example
  * @code
  * TcpServer server("0.0.0.0", 8080);
@@ -27,24 +33,18 @@
 #define TCP_SERVER_H
 
 #include <string>
+#include <string_view>
 #include <functional>
-#include <atomic>
-#include <unordered_map>
-#include <mutex>
-#include <memory>
-#include "thread_pool.h"
+#include "basic_tcp_server.h"
+#include "rcu.h"
 
 /**
- * @class TcpServer
- * @brief TCP 服务器类，支持多客户端并发连接
- * 
- * @details
- * 该类实现了一个基于线程池的 TCP 服务器：
- * - 主线程负责接受新连接
- * - 线程池中的工作线程负责处理客户端消息
- * - 使用回调机制通知上层应用各种事件
+ * @class TcpCallbackHandler
+ * @brief 把 BasicTcpServer 的事件转发给 std::function 回调
+ *
+ * @details 回调保存在 RcuCell 中，服务器运行期间可以无锁地随时替换
  */
-class TcpServer {
+class TcpCallbackHandler {
 public:
     /**
      * @brief 消息接收回调函数类型
@@ -52,144 +52,143 @@ public:
      * @param message 接收到的消息内容
      */
     using MessageCallback = std::function<void(int client_fd, const std::string& message)>;
-    
+
     /**
      * @brief 客户端连接回调函数类型
      * @param client_fd 新连接的客户端文件描述符
      * @param client_addr 客户端地址（格式：IP:Port）
      */
     using ConnectionCallback = std::function<void(int client_fd, const std::string& client_addr)>;
-    
+
     /**
      * @brief 客户端断开连接回调函数类型
      * @param client_fd 断开连接的客户端文件描述符
      */
     using DisconnectCallback = std::function<void(int client_fd)>;
-    
+
+    /**
+     * @brief 批量消息回调函数类型
+     * @param messages 一次就绪读取切分出的全部消息，只在回调期间有效
+     */
+    using BatchCallback = std::function<void(Span<const TcpMessage> messages)>;
+
+    RcuCell<MessageCallback> message_callback;          ///< 消息接收回调
+    RcuCell<BatchCallback> batch_callback;              ///< 批量消息回调
+    RcuCell<ConnectionCallback> connection_callback;    ///< 连接回调
+    RcuCell<DisconnectCallback> disconnect_callback;    ///< 断开连接回调
+
+    template <typename Server>
+    void on_message(Server&, int client_fd, std::string_view message) {
+        // 事件循环线程中已处于读临界区，这里只是嵌套计数
+        Rcu::ReadGuard guard;
+        const MessageCallback* callback = message_callback.load();
+        if (!callback || !*callback) {
+            return;
+        }
+        // 每个事件循环线程复用一个字符串，稳态下不分配内存
+        thread_local std::string buffer;
+        buffer.assign(message.data(), message.size());
+        (*callback)(client_fd, buffer);
+    }
+
+    template <typename Server>
+    void on_batch(Server& server, Span<const TcpMessage> messages) {
+        Rcu::ReadGuard guard;
+        const BatchCallback* callback = batch_callback.load();
+        if (callback && *callback) {
+            (*callback)(messages);
+            return;
+        }
+        // 批量回调刚被清除时，已切分的消息逐条交给消息接收回调
+        for (const TcpMessage& message : messages) {
+            on_message(server, message.client_fd, message.data);
+        }
+    }
+
+    template <typename Server>
+    void on_connect(Server&, int client_fd, const std::string& client_addr) {
+        Rcu::ReadGuard guard;
+        const ConnectionCallback* callback = connection_callback.load();
+        if (callback && *callback) {
+            (*callback)(client_fd, client_addr);
+        }
+    }
+
+    template <typename Server>
+    void on_disconnect(Server&, int client_fd) {
+        Rcu::ReadGuard guard;
+        const DisconnectCallback* callback = disconnect_callback.load();
+        if (callback && *callback) {
+            (*callback)(client_fd);
+        }
+    }
+};
+
+/**
+ * @class TcpServer
+ * @brief TCP 服务器类，支持多客户端并发连接
+ *
+ * @details
+ * 该类实现了一个基于事件循环的 TCP 服务器：
+ * - 接受线程负责接受新连接，并轮流分配给各个事件循环
+ * - 每个事件循环占用线程池中的一个线程，负责其名下所有连接的读写
+ * - 使用回调机制通知上层应用各种事件（回调在事件循环线程中执行）
+ */
+class TcpServer : public BasicTcpServer<TcpCallbackHandler, SplitterCodec> {
+public:
+    using MessageCallback = TcpCallbackHandler::MessageCallback;
+    using ConnectionCallback = TcpCallbackHandler::ConnectionCallback;
+    using DisconnectCallback = TcpCallbackHandler::DisconnectCallback;
+    using BatchCallback = TcpCallbackHandler::BatchCallback;
+    using FrameSplitter = SplitterCodec::Splitter;
+
     /**
      * @brief 构造函数
      * @param ip 服务器绑定的 IP 地址（如 "0.0.0.0" 表示所有接口）
      * @param port 服务器监听的端口号
-     * @param thread_pool_size 线程池大小，默认为 4
+     * @param thread_pool_size 线程池大小（即事件循环数量），默认为 4
      */
     TcpServer(const std::string& ip, uint16_t port, size_t thread_pool_size = 4);
-    
-    /**
-     * @brief 析构函数
-     * @details 自动停止服务器并释放资源
-     */
-    ~TcpServer();
-    
-    /// @brief 禁止拷贝构造
-    TcpServer(const TcpServer&) = delete;
-    /// @brief 禁止拷贝赋值
-    TcpServer& operator=(const TcpServer&) = delete;
-    
-    /**
-     * @brief 启动服务器
-     * @return true 启动成功，false 启动失败
-     * 
-     * @details
-     * 启动流程：
-     * 1. 创建 socket
-     * 2. 绑定地址和端口
-     * 3. 开始监听
-     * 4. 启动接受连接的线程
-     */
-    bool start();
-    
-    /**
-     * @brief 停止服务器
-     * 
-     * @details
-     * 停止流程：
-     * 1. 关闭服务器 socket
-     * 2. 等待接受线程结束
-     * 3. 关闭所有客户端连接
-     */
-    void stop();
-    
-    /**
-     * @brief 向指定客户端发送消息
-     * @param client_fd 目标客户端的文件描述符
-     * @param message 要发送的消息内容
-     * @return true 发送成功，false 发送失败或客户端不存在
-     * 
-     * @note 该函数是线程安全的
-     */
-    bool send_to(int client_fd, const std::string& message);
-    
-    /**
-     * @brief 向所有已连接的客户端广播消息
-     * @param message 要广播的消息内容
-     * 
-     * @note 该函数是线程安全的
-     */
-    void broadcast(const std::string& message);
-    
+
     /**
      * @brief 设置消息接收回调
      * @param callback 接收到客户端消息时调用的回调函数
+     *
+     * @note 可以在运行中随时调用（包括在回调内部），旧回调在宽限期后释放
      */
     void set_message_callback(MessageCallback callback);
-    
+
+    /**
+     * @brief 设置批量消息回调
+     * @param callback 每次就绪读取调用一次，交付本次读到的全部消息；为空时恢复逐条回调
+     *
+     * @details 可以在运行中随时调用；设置后不再调用消息接收回调
+     */
+    void set_batch_callback(BatchCallback callback);
+
     /**
      * @brief 设置客户端连接回调
      * @param callback 有新客户端连接时调用的回调函数
+     *
+     * @note 可以在运行中随时调用（包括在回调内部），旧回调在宽限期后释放
      */
     void set_connection_callback(ConnectionCallback callback);
-    
+
     /**
      * @brief 设置客户端断开连接回调
      * @param callback 客户端断开连接时调用的回调函数
+     *
+     * @note 可以在运行中随时调用（包括在回调内部），旧回调在宽限期后释放
      */
     void set_disconnect_callback(DisconnectCallback callback);
-    
-    /**
-     * @brief 获取服务器运行状态
-     * @return true 正在运行，false 已停止
-     */
-    bool is_running() const { return running_; }
-    
-    /**
-     * @brief 获取所有已连接客户端的信息
-     * @return 客户端映射表的副本（fd -> 地址字符串）
-     */
-    std::unordered_map<int, std::string> get_clients() const;
-    
-private:
-    /**
-     * @brief 接受客户端连接的循环（在独立线程中运行）
-     */
-    void accept_loop();
-    
-    /**
-     * @brief 处理单个客户端的消息（在线程池中运行）
-     * @param client_fd 客户端文件描述符
-     * @param client_addr 客户端地址字符串
-     */
-    void handle_client(int client_fd, const std::string& client_addr);
-    
+
     /**
-     * @brief 关闭指定客户端连接
-     * @param client_fd 要关闭的客户端文件描述符
+     * @brief 设置分帧函数
+     * @param splitter 分帧函数，未设置时每次读到的数据作为一条消息
+     *
+     * @details 必须在 start() 之前调用。半包数据会暂存在连接的输入缓冲区中
      */
-    void close_client(int client_fd);
-    
-    std::string ip_;                                    // 服务器绑定的 IP 地址
-    uint16_t port_;                                     // 服务器监听的端口
-    int server_fd_;                                     // 服务器 socket 文件描述符
-    std::atomic<bool> running_;                         // 服务器运行状态标志
-    
-    std::unique_ptr<ThreadPool> thread_pool_;           // 线程池指针
-    std::thread accept_thread_;                         // 接受连接的线程
-    
-    std::unordered_map<int, std::string> clients_;      // 客户端映射表（fd -> 地址）
-    mutable std::mutex clients_mutex_;                  // 客户端列表互斥锁
-    
-    MessageCallback message_callback_;                  // 消息接收回调
-    ConnectionCallback connection_callback_;            // 连接回调
-    DisconnectCallback disconnect_callback_;            // 断开连接回调
+    void set_frame_splitter(FrameSplitter splitter);
 };
 
 #endif // TCP_SERVER_H
@@ -0,0 +1,1289 @@
+/**
+ * @file tcp_server_base.h
+ * @brief TCP 服务器公共部分（非模板）的头文件
+ * @author CSQL
+ * @date 2025-12-14
+ *
+ * @details
+ * 提供多客户端 TCP 服务器中与消息类型无关的部分：
+ * - 监听指定端口并接受客户端连接
+ * - 使用多个 epoll 事件循环（运行在线程池中）处理大量客户端
+ * - 向单个客户端或所有客户端发送消息（非阻塞，未发完的数据排队发送）；
+ *   紧急消息（心跳、取消等）不排在积压的普通数据之后，在下一个帧边界插队发送；
+ *   消息可以带过期时间，写出前已过期的消息直接丢弃，不再占用带宽
+ * - 按键合并的广播：跟不上的连接对每个键只保留最新值，积压写完后一次补发
+ * - 其他线程（如线程池中的业务线程）发给某个连接的消息投递到该连接所属事件循环的
+ *   无锁队列，只在队列由空变为非空时唤醒一次，由事件循环合并成一次 writev 写出
+ * - 连接缓冲区管理与内存记账：全局预算与单连接上限，超限时按策略暂停读取、
+ *   丢弃低优先级输出或断开占用最多的连接
+ * - 新连接可以按内核处理其收包的 CPU（SO_INCOMING_CPU）分配给绑定在该 CPU 或
+ *   同一 NUMA 节点上的事件循环，数据不必在 CPU 缓存之间搬运
+ * - 连接可以在事件循环之间在线迁移（连同半包和待发送数据），可选的再均衡线程
+ *   按各事件循环的利用率把繁忙循环上的连接迁往空闲循环，不丢失也不打乱字节
+ * - 每个连接每轮的读写字节数和消息数有配额，用完后排到事件循环的就绪列表末尾，
+ *   大流量连接不会独占一轮，轻量连接的延迟保持有界
+ * - 可选 SO_REUSEPORT，配合 PreforkSupervisor 以多个工作进程各自监听同一端口
+ * - 可选内核收发时间戳（SO_TIMESTAMPING）：区分内核排队与用户态处理的延迟
+ * - 可选 TCP_INFO 定时采样：各连接的 RTT、重传、拥塞窗口等，及其汇总分布
+ * - 无锁的连接统计：按 fd 分页遍历各连接的收发量、积压与活跃时间，不阻塞接受连接和发送
+ *
+ * 读到的数据通过受保护的虚函数交给派生类：每次就绪读取只有一次虚调用，
+ * 分帧和逐条消息的分发由模板 BasicTcpServer 完成，可以被编译器内联。
+ *
+ * @note 该类不可拷贝，不能直接实例化；应使用 BasicTcpServer 或 TcpServer
+ */
+
+#ifndef TCP_SERVER_BASE_H
+#define TCP_SERVER_BASE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <functional>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <future>
+#include <sys/uio.h>
+#include "thread_pool.h"
+#include "buffer_arena.h"
+#include "event_loop.h"
+#include "recv_size_predictor.h"
+#include "magic_ring_buffer.h"
+#include "memory_budget.h"
+#include "mpsc_queue.h"
+#include "busy_poll.h"
+#include "realtime.h"
+#include "clock.h"
+#include "timestamping.h"
+#include "tcp_info.h"
+#include "connection_stats.h"
+
+/**
+ * @class TcpServerBase
+ * @brief TCP 服务器的非模板公共部分，支持多客户端并发连接
+ *
+ * @details
+ * 该类实现了一个基于事件循环的 TCP 服务器：
+ * - 接受线程负责接受新连接，按放置策略（轮询或按收包 CPU）分配给各个事件循环；
+ *   之后可以迁移到其他事件循环
+ * - 每个事件循环占用线程池中的一个线程，负责其名下所有连接的读写
+ * - 连接、断开和数据事件通过受保护的虚函数通知派生类（在事件循环线程中执行）
+ * - 发送只由连接所属的事件循环写 socket；其他线程的 send_to() 经 MPSC 队列交接
+ */
+class TcpServerBase {
+public:
+    /**
+     * @brief 发送消息的优先级
+     */
+    enum class Priority {
+        Urgent,     ///< 紧急消息，在连接积压的普通数据的下一个帧边界插队发送，不会被丢弃
+        Normal,     ///< 普通消息，不会因内存超限被丢弃
+        Low         ///< 低优先级消息，OverflowPolicy::DropLowPriority 下超限时丢弃
+    };
+
+    /**
+     * @brief 超出内存上限时的处理策略
+     */
+    enum class OverflowPolicy {
+        PauseReads,         ///< 暂停读取：单连接输出超限时暂停该连接，全局超限时暂停所有连接，回落后恢复
+        DropLowPriority,    ///< 丢弃会导致超限的低优先级输出（普通消息照常排队）
+        DisconnectLargest   ///< 断开超限的连接；全局超限时断开持有缓冲最多的连接
+    };
+
+    /**
+     * @brief 内存上限配置
+     */
+    struct MemoryLimits {
+        size_t global_bytes = 0;                            ///< 全局预算（输入+输出+排队任务），0 表示不限制
+        size_t connection_input_bytes = 16 * 1024 * 1024;   ///< 单连接半包上限，超过即断开
+        size_t connection_output_bytes = 0;                 ///< 单连接待发送数据上限，0 表示不限制
+        OverflowPolicy policy = OverflowPolicy::PauseReads; ///< 超限处理策略
+    };
+
+    /**
+     * @brief 内存用量指标
+     */
+    struct MemoryStats {
+        size_t input_bytes = 0;             ///< 输入缓冲区容量之和
+        size_t output_bytes = 0;            ///< 输出缓冲区容量之和
+        size_t task_bytes = 0;              ///< 排队中任务的估算大小
+        size_t total_bytes = 0;             ///< 以上三项之和
+        size_t peak_bytes = 0;              ///< total_bytes 的历史峰值
+        size_t limit_bytes = 0;             ///< 全局预算，0 表示不限制
+        size_t paused_connections = 0;      ///< 当前暂停读取的连接数
+        uint64_t dropped_messages = 0;      ///< 因超限丢弃的消息数
+        uint64_t dropped_bytes = 0;         ///< 因超限丢弃的字节数
+        uint64_t overflow_disconnects = 0;  ///< 因超限断开的连接数
+        uint64_t expired_messages = 0;      ///< 写出前已过期而丢弃的消息数
+        uint64_t expired_bytes = 0;         ///< 写出前已过期而丢弃的字节数
+        uint64_t conflated_updates = 0;     ///< 合并广播中被更新值取代、未发给慢连接的更新数
+    };
+
+    /**
+     * @brief 连接缓冲区的内存模式
+     */
+    enum class BufferMode {
+        Eager,  ///< 每个连接建立时即持有输入/输出缓冲块，直到断开
+        Lazy    ///< 空闲连接不持有缓冲区，仅在有半包或待发送数据时借用，清空后立即归还
+    };
+
+    /**
+     * @brief 新连接分配给事件循环的策略
+     */
+    enum class Placement {
+        RoundRobin,     ///< 轮流分配，事件循环线程不绑核
+        IncomingCpu     ///< 事件循环线程各绑定一个 CPU，连接分配给绑定在其收包 CPU（或同一 NUMA 节点最近 CPU）上的循环
+    };
+
+    /**
+     * @brief 放置策略的命中统计
+     */
+    struct PlacementStats {
+        uint64_t same_cpu = 0;          ///< 分配到绑定在收包 CPU 上的事件循环的连接数
+        uint64_t same_node = 0;         ///< 分配到同一 NUMA 节点上其他 CPU 的连接数
+        uint64_t fallback = 0;          ///< 无法取得收包 CPU 或没有同节点的循环、退回轮询的连接数
+    };
+
+    /**
+     * @brief 按利用率自动迁移连接的配置
+     */
+    struct RebalanceOptions {
+        bool enabled = false;                                   ///< 是否启动再均衡线程
+        std::chrono::milliseconds interval{500};                ///< 采样利用率的间隔，每个间隔最多迁移一个连接
+        double imbalance = 0.2;                                 ///< 最忙与最闲循环的利用率之差达到该值时迁移
+        double min_utilization = 0.5;                           ///< 最忙循环的利用率低于该值时不迁移
+    };
+
+    /**
+     * @brief 每个连接在一轮事件循环中的读写配额，0 表示不限制
+     *
+     * @details 配额用完的连接排到所属事件循环的就绪列表末尾，在其他连接和新的就绪事件
+     *          都处理过一次之后继续读写
+     */
+    struct FairnessBudget {
+        size_t read_bytes = 256 * 1024;     ///< 每轮最多读取的字节数
+        size_t read_messages = 0;           ///< 每轮最多分发的消息数（按 BasicTcpServer 切出的消息计）
+        size_t write_bytes = 256 * 1024;    ///< 每轮最多写出的字节数
+        size_t write_messages = 0;          ///< 每轮最多写完的普通消息数（紧急消息不计）
+    };
+
+    /**
+     * @brief 单个事件循环的负载指标
+     */
+    struct LoopStats {
+        int cpu = -1;                   ///< 绑定的 CPU，未绑定时为 -1
+        size_t connections = 0;         ///< 当前分配到该循环的连接数
+        uint64_t busy_ns = 0;           ///< 累计忙碌时间（纳秒）
+        double utilization = 0;         ///< 再均衡线程最近一次采样的利用率（0~1），未启用时为 0
+    };
+
+    /**
+     * @brief 消息过期时间点，默认值表示永不过期
+     */
+    using Expiry = std::chrono::steady_clock::time_point;
+
+    /**
+     * @brief 构造函数
+     * @param ip 服务器绑定的 IP 地址（如 "0.0.0.0" 表示所有接口）
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小（即事件循环数量），默认为 4
+     */
+    TcpServerBase(const std::string& ip, uint16_t port, size_t thread_pool_size = 4);
+
+    /**
+     * @brief 析构函数
+     * @details 派生类必须在自己的析构函数中调用 stop()，保证回调不会在派生部分析构后触发
+     */
+    virtual ~TcpServerBase();
+
+    /// @brief 禁止拷贝构造
+    TcpServerBase(const TcpServerBase&) = delete;
+    /// @brief 禁止拷贝赋值
+    TcpServerBase& operator=(const TcpServerBase&) = delete;
+
+    /**
+     * @brief 启动服务器
+     * @return true 启动成功，false 启动失败
+     *
+     * @details
+     * 启动流程：
+     * 1. 创建 socket
+     * 2. 绑定地址和端口
+     * 3. 开始监听
+     * 4. 在线程池中启动事件循环
+     * 5. 启动接受连接的线程
+     */
+    bool start();
+
+    /**
+     * @brief 停止服务器
+     *
+     * @details
+     * 停止流程：
+     * 1. 关闭服务器 socket
+     * 2. 等待接受线程结束
+     * 3. 停止所有事件循环
+     * 4. 关闭所有客户端连接
+     */
+    void stop();
+
+    /**
+     * @brief 向指定客户端发送消息
+     * @param client_fd 目标客户端的文件描述符
+     * @param message 要发送的消息内容
+     * @param priority 消息优先级，决定发送顺序以及内存超限时能否被丢弃
+     * @param expiry 过期时间点，默认永不过期
+     * @return true 已发送、已加入发送队列或已投递给所属事件循环，
+     *         false 发送失败、客户端不存在、已过期或因内存超限被拒绝
+     *
+     * @details
+     * 在连接所属的事件循环线程中调用时直接发送；在其他线程中调用时拷贝消息并投递到
+     * 所属事件循环的无锁队列，不加锁也不写 socket。事件循环被唤醒后一次取走队列中的
+     * 全部消息，同一连接相邻的消息合并为一次 writev。同一线程发给同一连接的同一优先级
+     * 消息保持顺序，连接在事件循环之间迁移时也是如此。
+     *
+     * 每次调用是一帧。普通与低优先级消息按帧排队；Priority::Urgent 的消息进入独立的
+     * 紧急队列，只要当前正在写出的普通帧写完（socket 中不会出现半帧）就先于其余积压帧发送。
+     * 需要更细的抢占粒度时，应在协议层把大响应拆成多帧发送，每个帧边界都是抢占点。
+     *
+     * 带过期时间的消息在每次写出前检查：到期仍未开始写出的整条消息被丢弃并计入该连接的
+     * expired_messages()，已写出一部分的消息总是写完。紧急消息不排在积压数据之后，不检查过期。
+     *
+     * @note 该函数是线程安全的，不会阻塞：socket 发送缓冲区满时剩余数据排队，
+     *       由事件循环在可写时继续发送。投递后连接才断开时消息被静默丢弃
+     */
+    bool send_to(int client_fd, std::string_view message, Priority priority = Priority::Normal,
+                 Expiry expiry = Expiry());
+
+    /**
+     * @brief 向所有已连接的客户端广播消息
+     * @param message 要广播的消息内容
+     * @param priority 消息优先级，决定内存超限时能否被丢弃
+     * @param expiry 过期时间点，默认永不过期；慢连接上到期仍未写出的副本被丢弃
+     *
+     * @details 每个连接的副本与 send_to() 走同一条路径：只有连接所属的事件循环线程直接写出，
+     *          其他线程调用时副本投递到所属事件循环的队列，与同一线程此前 send_to() 的消息保持顺序
+     *
+     * @note 该函数是线程安全的
+     */
+    void broadcast(std::string_view message, Priority priority = Priority::Normal, Expiry expiry = Expiry());
+
+    /**
+     * @brief 按键合并地广播最新值
+     * @param key 消息键（如行情代码的哈希），同一键的新值取代旧值
+     * @param message 该键的最新值
+     *
+     * @details
+     * 跟得上的连接（没有积压输出）立即收到消息（与 broadcast() 一样由所属事件循环写出）；有积压的连接只记下该键待发送，
+     * 不拷贝消息。积压写完后，按键首次待发送的顺序补发每个键此刻的最新值，
+     * 中间被取代的更新不再发送。因此慢连接额外占用的内存只与键的数量有关，
+     * 一旦网络恢复立即追上最新状态。
+     *
+     * 各键的最新值由所有连接共享，只在服务器中保存一份。补发的值排在该连接
+     * 积压期间用 send_to()/broadcast() 发出的消息之后。
+     *
+     * @note 该函数是线程安全的。键的数量应当有界，服务器会一直保留每个键的最新值
+     */
+    void broadcast_conflated(uint64_t key, std::string_view message);
+
+    /**
+     * @brief 获取连接上因过期被丢弃的消息数
+     * @param client_fd 客户端文件描述符
+     * @return 丢弃的消息数，客户端不存在时返回 0
+     *
+     * @note 该函数是线程安全的
+     */
+    uint64_t expired_messages(int client_fd) const;
+
+    /**
+     * @brief 设置连接缓冲区的内存模式
+     * @param mode 内存模式，默认为 BufferMode::Eager
+     *
+     * @details
+     * 必须在 start() 之前调用。BufferMode::Lazy 下空闲连接不持有任何缓冲区：
+     * 数据先读入事件循环线程共享的临时缓冲区，只有出现半包或待发送数据时
+     * 连接才从缓冲池借用缓冲块，数据处理完后立即归还。适合海量空闲长连接。
+     *
+     * @note 输入缓冲区是双重映射的环形缓冲区，每个占用两个内存映射；
+     *       Eager 模式下连接数很大时需相应调高 vm.max_map_count
+     */
+    void set_buffer_mode(BufferMode mode);
+
+    /**
+     * @brief 设置接收缓冲区所用内存区域的配置
+     * @param options 内存区域配置（大页、预缺页、mlock 等）
+     *
+     * @details
+     * 必须在 start() 之前调用。start() 会按该配置映射内存区域并预先切分
+     * 缓冲块，避免服务器上线后的第一批请求触发缺页和 TLB 未命中。
+     * size 为 0 时按事件循环数量自动计算。
+     */
+    void set_buffer_arena_options(const BufferArena::Options& options);
+
+    /**
+     * @brief 设置内存上限与超限处理策略
+     * @param limits 内存上限配置
+     *
+     * @details
+     * 必须在 start() 之前调用。库持有的输入缓冲区、输出缓冲区和投递到
+     * 事件循环的任务都计入全局预算：
+     * - PauseReads 在用量回落到预算的 3/4 以下（单连接为上限的 1/2）后恢复读取
+     * - 已部分写入 socket 的消息总是完整排队，否则会破坏字节流
+     */
+    void set_memory_limits(const MemoryLimits& limits);
+
+    /**
+     * @brief 获取内存用量指标
+     * @return 当前各项指标的快照
+     *
+     * @note 该函数是线程安全的
+     */
+    MemoryStats memory_stats() const;
+
+    /**
+     * @brief 把连接迁移到另一个事件循环
+     * @param client_fd 客户端文件描述符
+     * @param loop_index 目标事件循环下标
+     * @return true 已开始迁移，false 服务器未运行、下标越界、客户端不存在、
+     *         已在目标循环或正在迁移
+     *
+     * @details
+     * 迁移是异步的：原事件循环注销 fd 后停止读写，等其他线程已经投递给它的消息都写入
+     * 连接的缓冲区，再由目标事件循环注册 fd 并接管。期间投递给该连接的消息暂存在目标
+     * 事件循环中，接管后按投递顺序发送；半包、待发送数据和暂停状态随连接一起转移，
+     * socket 中未读的数据由目标事件循环继续读取。
+     *
+     * 迁移完成后该连接的 on_data()/on_disconnect() 在目标事件循环的线程中调用。
+     *
+     * @note 该函数是线程安全的
+     */
+    bool migrate(int client_fd, size_t loop_index);
+
+    /**
+     * @brief 设置新连接的放置策略
+     * @param placement 放置策略，默认为 Placement::RoundRobin
+     *
+     * @details
+     * 必须在 start() 之前调用。Placement::IncomingCpu 下 start() 把各事件循环线程
+     * 均匀地绑定到本进程允许运行的 CPU 上，接受连接时用 SO_INCOMING_CPU 读取内核
+     * 最近处理该连接收包的 CPU：有循环绑定在该 CPU 上时分配给它，否则分配给同一
+     * NUMA 节点上编号最近的 CPU 上的循环，都没有时退回轮询。
+     *
+     * 该策略要求网卡的 RSS/RPS 把流分散到这些 CPU 上；事件循环数量不少于 CPU 数量时效果最好。
+     * 再均衡迁移的连接不再位于其收包 CPU 上。
+     */
+    void set_placement(Placement placement);
+
+    /**
+     * @brief 设置是否开启 SO_REUSEPORT
+     * @param enabled 是否允许多个监听 socket（通常位于不同进程）绑定同一地址和端口，默认为 false
+     *
+     * @details 必须在 start() 之前调用。配合 PreforkSupervisor 使用时，每个工作进程各自
+     *          监听，由内核按四元组哈希把新连接分配给它们，进程之间不共享 accept 队列
+     */
+    void set_reuse_port(bool enabled) { reuse_port_ = enabled; }
+
+    /**
+     * @brief 获取放置策略的命中统计
+     *
+     * @note 该函数是线程安全的
+     */
+    PlacementStats placement_stats() const;
+
+    /**
+     * @brief 设置按利用率自动迁移连接的配置
+     * @param options 再均衡配置
+     *
+     * @details
+     * 必须在 start() 之前调用。启用后再均衡线程每个间隔采样一次各事件循环的利用率，
+     * 最忙与最闲循环相差超过阈值时，从最忙的循环中选出近期读写量最大、
+     * 且迁走后不会让两边的负载反转的连接迁往最闲的循环。
+     * 单个连接独占一个循环时不会被迁移（迁走只会转移热点）。
+     */
+    void set_rebalance_options(const RebalanceOptions& options);
+
+    /**
+     * @brief 获取各事件循环的负载指标
+     * @return 按事件循环下标排列的指标
+     *
+     * @note 该函数是线程安全的
+     */
+    std::vector<LoopStats> loop_stats() const;
+
+    /**
+     * @brief 获取已完成的连接迁移次数
+     */
+    uint64_t migrated_connections() const { return migrated_connections_; }
+
+    /**
+     * @brief 设置每个连接每轮的读写配额
+     * @param budget 读写配额
+     *
+     * @details
+     * 必须在 start() 之前调用。边缘触发下连接本应一直读写到 EAGAIN，
+     * 配额用完时改为记入就绪列表：事件循环不再阻塞等待，先处理新的就绪事件、
+     * 发送请求和任务，再依次继续就绪列表中的连接。
+     */
+    void set_fairness_budget(const FairnessBudget& budget);
+
+    /**
+     * @brief 获取因读写配额用完而让出的次数
+     */
+    uint64_t deferred_turns() const { return deferred_turns_; }
+
+    /**
+     * @brief 设置事件循环的忙轮询模式
+     * @param options 忙轮询配置
+     *
+     * @details
+     * 必须在 start() 之前调用。启用后各事件循环以零超时调用 epoll_wait 自旋，
+     * 连续空转超过 idle_timeout 后才阻塞等待；自旋的空转不计入 loop_stats() 的忙碌时间。
+     * 设置了 SO_BUSY_POLL / SO_PREFER_BUSY_POLL 时应用到每个接受的连接，
+     * 内核拒绝时（如超过 net.core.busy_read 而没有 CAP_NET_ADMIN）打印一次警告并只保留自旋。
+     *
+     * 每个事件循环会占满一个 CPU，通常配合 Placement::IncomingCpu 把循环绑定到收包 CPU 上。
+     */
+    void set_busy_poll(const BusyPollOptions& options) { busy_poll_ = options; }
+
+    /**
+     * @brief 设置事件循环线程的实时化配置
+     * @param options 实时化配置
+     *
+     * @details 必须在 start() 之前调用。每个事件循环线程启动时以 io_priority 切换为 SCHED_FIFO、
+     *          预写入栈，lock_memory 为 true 时首个线程对整个进程 mlockall。
+     *          权限不足时退化为普通调度并打印一次警告，结果见 Realtime::report()
+     */
+    void set_realtime(const RealtimeOptions& options) { realtime_ = options; }
+
+    /**
+     * @brief 设置内核收发时间戳
+     * @param options 时间戳配置
+     *
+     * @details
+     * 必须在 start() 之前调用。每个接受的连接在任何数据收发之前开启 SO_TIMESTAMPING：
+     * - 接收时间戳：每次读取取出本次最后一个数据包的内核收包时间，记录 rx_queue
+     *   （收包到读取返回）与 rx_dispatch（读取返回到本次数据分发完毕），
+     *   并在 on_data() 期间通过 rx_timestamp_ns() 提供
+     * - 发送时间戳：每次写入 socket 记下最后一个字节的偏移和时刻，事件循环在 EPOLLERR 时
+     *   读取错误队列，按偏移对应后记录 tx_queue。同一数据包中合并的多次写入只有最后一次有时间戳
+     *
+     * 各事件循环分别记录，wire_latency() 汇总。内核不支持时打印一次警告，该连接不带时间戳。
+     */
+    void set_timestamping(const TimestampingOptions& options) { timestamping_ = options; }
+
+    /**
+     * @brief 获取内核时间戳测得的延迟
+     * @return 各事件循环汇总的三段延迟摘要（纳秒），未开启时各项为空
+     *
+     * @note 该函数是线程安全的
+     */
+    WireLatencyStats wire_latency() const;
+
+    /**
+     * @brief 本次读取的内核接收时间戳
+     * @return CLOCK_REALTIME 纳秒，未开启或内核没有提供时为 0
+     *
+     * @details 在 on_data() 及其分发的回调中有效（事件循环线程）
+     */
+    static int64_t rx_timestamp_ns() { return current_rx_timestamp_; }
+
+    /**
+     * @brief 设置 TCP_INFO 采样
+     * @param options 采样配置
+     *
+     * @details
+     * 必须在 start() 之前调用。每个事件循环以 interval 的四分之一（至少 10 毫秒）为周期，
+     * 按轮转顺序挑出距上次采样已超过 interval 的连接，一次加锁收集、锁外逐个 getsockopt、
+     * 再一次加锁写回，每次最多 max_per_tick 个。连接很多时实际间隔由该上限决定。
+     * 结果写入连接的最近一次采样（tcp_info()），并记入各事件循环的直方图（tcp_info_stats()）。
+     */
+    void set_tcp_info_sampling(const TcpInfoOptions& options) { tcp_info_options_ = options; }
+
+    /**
+     * @brief 获取连接最近一次的 TCP_INFO 采样
+     * @param client_fd 客户端文件描述符
+     * @param sample 输出参数，最近一次采样
+     * @return true 已有采样，false 未启用、客户端不存在或尚未采样
+     *
+     * @note 该函数是线程安全的
+     */
+    bool tcp_info(int client_fd, TcpInfoSample& sample) const;
+
+    /**
+     * @brief 获取所有连接 TCP_INFO 采样的汇总分布
+     * @return 各事件循环汇总的各项指标摘要，未启用时各项为空
+     *
+     * @note 该函数是线程安全的
+     */
+    TcpInfoStats tcp_info_stats() const;
+
+    /**
+     * @brief 获取服务器运行状态
+     * @return true 正在运行，false 已停止
+     */
+    bool is_running() const { return running_; }
+
+    /**
+     * @brief 获取所有已连接客户端的信息
+     * @return 客户端映射表的副本（fd -> 地址字符串）
+     *
+     * @note 在 clients_mutex_ 下为每个连接分配一个字符串，连接很多时会阻塞接受连接和发送；
+     *       定期监控应使用 scan_connections() / connection_count()
+     */
+    std::unordered_map<int, std::string> get_clients() const;
+
+    /**
+     * @brief 获取单个连接的统计
+     * @param client_fd 客户端文件描述符
+     * @param stats 输出参数，连接的统计快照
+     * @return true 连接存在，false 不存在
+     *
+     * @note 不加锁，可以在任意线程（包括回调中）调用
+     */
+    bool connection_stats(int client_fd, ConnectionStats& stats) const { return connection_stats_.read(client_fd, stats); }
+
+    /**
+     * @brief 分页遍历连接的统计
+     * @param cursor 本页的起始位置，第一页为 0，之后为上一页的返回值
+     * @param limit 本页最多返回的连接数
+     * @param filter 过滤条件
+     * @param out 输出参数，按 fd 递增的统计快照（先清空，容量复用）
+     * @return 下一页的起始位置，-1 表示已遍历完
+     *
+     * @details
+     * 每条记录是一致的快照（序号校验），不同记录的读取时刻不同。遍历不加锁，
+     * 不影响接受连接与发送；复用 out 时除首次扩容外不分配内存。
+     * @code
+     * std::vector<ConnectionStats> page;
+     * ConnectionFilter stalled;
+     * stalled.min_queued_bytes = 1 << 20;
+     * for (int cursor = 0; cursor >= 0;) {
+     *     cursor = server.scan_connections(cursor, 1024, stalled, page);
+     *     for (const ConnectionStats& c : page) { ... }
+     * }
+     * @endcode
+     */
+    int scan_connections(int cursor, size_t limit, const ConnectionFilter& filter,
+                         std::vector<ConnectionStats>& out) const {
+        return connection_stats_.scan(cursor, limit, filter, Clock::now_ns(), out);
+    }
+
+    /**
+     * @brief 获取当前连接数（不加锁）
+     */
+    size_t connection_count() const { return connection_stats_.open_count(); }
+
+    /**
+     * @brief 获取连接当前持有的缓冲区总字节数
+     * @return 所有连接输入/输出缓冲区容量之和
+     */
+    size_t buffer_bytes_in_use() const {
+        return budget_.used(MemoryBudget::Category::Input) + budget_.used(MemoryBudget::Category::Output);
+    }
+
+protected:
+    /**
+     * @brief 新连接建立（在接受线程中调用，先于该连接的任何数据事件）
+     * @param client_fd 客户端文件描述符
+     * @param client_addr 客户端地址（格式：IP:Port）
+     */
+    virtual void on_connect(int client_fd, const std::string& client_addr) = 0;
+
+    /**
+     * @brief 连接上读到数据（在事件循环线程中调用）
+     * @param client_fd 客户端文件描述符
+     * @param data 尚未处理的数据起始地址（总是连续的）
+     * @param length 尚未处理的数据长度
+     * @param consumed 输出参数，已处理的字节数，剩余部分作为半包保留
+     * @return true 继续，false 数据非法，关闭连接
+     */
+    virtual bool on_data(int client_fd, const char* data, size_t length, size_t& consumed) = 0;
+
+    /**
+     * @brief 连接已断开（在事件循环线程或 stop() 的调用线程中调用）
+     * @param client_fd 客户端文件描述符
+     */
+    virtual void on_disconnect(int client_fd) = 0;
+
+    /**
+     * @brief 一批数据已全部交给 on_data()（仅在 set_data_end_hook(true) 后调用）
+     * @param client_fd 客户端文件描述符
+     *
+     * @details 在此之后 on_data() 收到的数据指针可能失效。每次就绪读取至少调用一次，
+     *          在输入缓冲区被追加、换档或归还之前也会调用
+     */
+    virtual void on_data_end(int client_fd) { (void)client_fd; }
+
+    /**
+     * @brief 是否调用 on_data_end()（派生类在构造时设置）
+     * @param enabled 是否在每批数据之后调用 on_data_end()
+     */
+    void set_data_end_hook(bool enabled) { data_end_hook_ = enabled; }
+
+    /**
+     * @brief 启用或关闭批量分发（运行中也可以切换）
+     * @param enabled 是否把消息攒成一批交付，供派生类在 on_data() 中查询
+     */
+    void set_batch_dispatch(bool enabled) { batch_dispatch_.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * @brief 是否启用批量分发
+     */
+    bool batch_dispatch() const { return batch_dispatch_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 申请交付一条消息的配额（派生类在 on_data() 中每切出一条完整消息调用一次）
+     * @return true 可以交付，false 本轮消息配额已用完，应停止切分、不计入 consumed
+     *
+     * @details 剩余的完整消息留在输入缓冲区中，下一轮先于新读取的数据交付
+     */
+    static bool acquire_message_quota() {
+        if (message_quota_ == 0) {
+            return false;
+        }
+        --message_quota_;
+        return true;
+    }
+
+private:
+    /**
+     * @struct Buffer
+     * @brief 连接的输出缓冲区，[begin, end) 为有效数据
+     *
+     * @details 普通输出按帧排队，每帧前有一个不会发出的 4 字节长度头，用来定位帧边界，
+     *          长度头最高位置位时其后还有 8 字节的过期时间（纳秒）；紧急输出不分帧，总是整体写完
+     */
+    struct Buffer {
+        char* data = nullptr;       // 缓冲区地址，nullptr 表示未持有
+        uint32_t capacity = 0;      // 缓冲区容量
+        uint32_t begin = 0;         // 有效数据起始偏移
+        uint32_t end = 0;           // 有效数据结束偏移
+        uint32_t frame_left = 0;    // 正在写出的帧剩余字节数（长度头已跳过），0 表示位于帧边界
+
+        size_t size() const { return end - begin; }
+
+        /**
+         * @brief 从 begin 起收集最多 max_frames 帧的数据（跳过长度头）
+         * @param expired_messages 累加位于开头、已过期而丢弃的帧数
+         * @param expired_bytes 累加丢弃的字节数
+         * @return 填充的 iovec 数量
+         *
+         * @details 开头的过期帧直接丢弃；遇到后面的过期帧时停止收集，留给下一次写入丢弃
+         */
+        size_t gather_frames(iovec* iov, size_t max_frames, uint64_t& expired_messages, uint64_t& expired_bytes);
+
+        /**
+         * @brief 消费已写出的 length 字节帧数据
+         */
+        void consume_frames(size_t length);
+    };
+
+    /**
+     * @struct ConflatedKeys
+     * @brief 连接积压期间待补发的合并广播键
+     */
+    struct ConflatedKeys {
+        std::vector<uint32_t> order;        // 待补发的键下标，按首次待发送的顺序
+        std::vector<uint8_t> pending;       // 按键下标标记是否已在 order 中
+    };
+
+    /**
+     * @struct TxStamps
+     * @brief 连接上等待内核发送时间戳的写入记录，开启发送时间戳时创建
+     *
+     * @details 内核的编号是每次写入最后一个字节的偏移（从开启时间戳时起算），
+     *          记录按偏移递增，满时丢弃最旧的一条
+     */
+    struct TxStamps {
+        static constexpr uint32_t CAPACITY = 64;
+
+        struct Entry {
+            uint32_t last_byte;     // 该次写入最后一个字节的偏移
+            int64_t sent_ns;        // 写入调用前的时刻（CLOCK_REALTIME 纳秒）
+        };
+
+        Entry entries[CAPACITY];    // 环形记录
+        uint32_t offset = 0;        // 已写入 socket 的字节数
+        uint32_t head = 0;          // 最旧记录的序号
+        uint32_t tail = 0;          // 下一条记录的序号
+    };
+
+    /**
+     * @struct Connection
+     * @brief 单个客户端连接的状态，保持紧凑以支撑海量连接
+     */
+    struct Connection {
+        int fd = -1;                // 客户端文件描述符
+        uint32_t loop_index = 0;    // 所属事件循环下标
+        uint32_t generation = 0;    // 连接代号，fd 被复用时区分新旧连接
+        uint32_t ip = 0;            // 客户端 IP（网络字节序）
+        uint16_t port = 0;          // 客户端端口（主机字节序）
+        RecvSizePredictor predictor;// 接收大小预测器
+        MagicRingBuffer* input = nullptr; // 输入环形缓冲区（半包），仅由所属事件循环访问
+        Buffer output;              // 输出缓冲区（待发送的普通帧），受 clients_mutex_ 保护
+        Buffer urgent;              // 紧急输出缓冲区，受 clients_mutex_ 保护
+        std::atomic<uint32_t> input_bytes{0};   // 输入缓冲区容量，供其他线程查找最大连接
+        std::atomic<uint8_t> pause_reasons{0};  // 暂停读取的原因（位掩码），0 表示正常读取
+        bool closing = false;       // 已因超限被关闭，等待事件循环回收，受 clients_mutex_ 保护
+        bool registered = false;    // 已注册到事件循环（连接回调已返回），受 clients_mutex_ 保护
+        bool migrating = false;     // 正在迁移，目标事件循环尚未接管，受 clients_mutex_ 保护
+        uint64_t activity = 0;      // 上次挑选迁移连接以来读写的字节数，仅由所属事件循环访问
+        uint8_t ready = 0;          // 因配额用完而在就绪列表中等待的读写方向（位掩码），仅由所属事件循环访问
+        uint64_t expired = 0;       // 因过期丢弃的消息数，受 clients_mutex_ 保护
+        std::unique_ptr<ConflatedKeys> conflated; // 积压期间待补发的合并键，首次积压时创建，受 clients_mutex_ 保护
+        std::unique_ptr<TxStamps> tx_stamps; // 等待发送时间戳的写入，接受连接时按需创建，之后指针不变，内容受 clients_mutex_ 保护
+        std::unique_ptr<TcpInfoSample> tcp_info; // 最近一次 TCP_INFO 采样，启用采样时创建，受 clients_mutex_ 保护
+        uint32_t member_index = 0;  // 在所属事件循环成员列表中的下标，受 clients_mutex_ 保护
+    };
+
+    /**
+     * @struct SendRequest
+     * @brief 其他线程投递给事件循环的发送请求，消息内容紧跟在结构体之后
+     */
+    struct SendRequest {
+        SendRequest* next;          // 队列链接
+        int fd;                     // 目标客户端
+        uint32_t generation;        // 投递时连接的代号，与连接当前代号不同时丢弃
+        Priority priority;          // 消息优先级
+        uint32_t length;            // 消息长度
+        int64_t expiry_ns;          // 过期时间（纳秒），0 表示永不过期
+
+        char* payload() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    /**
+     * @struct TcpInfoJob
+     * @brief 一次 TCP_INFO 采样任务，锁外只使用其中的 fd 与采样副本
+     */
+    struct TcpInfoJob {
+        Connection* conn;           // 挑选时的连接，写回前按 fd 重新确认
+        int fd;                     // 连接的文件描述符
+        TcpInfoSample sample;       // 上一次采样的副本，输出本次采样
+    };
+
+    /**
+     * @struct IoLoop
+     * @brief 事件循环及其线程私有的临时读缓冲区
+     */
+    struct IoLoop {
+        std::unique_ptr<EventLoop> loop;    // 事件循环
+        int cpu = -1;                       // 绑定的 CPU，-1 表示不绑核
+        char* scratch = nullptr;            // 线程共享的临时读缓冲区
+        std::vector<int> paused_fds;        // 因全局超限暂停读取的连接，仅由循环线程访问
+        std::unique_ptr<MpscQueue<SendRequest>> send_queue; // 其他线程投递的发送请求
+        std::vector<SendRequest*> held_sends; // 发给迁入中连接的请求，接管后发送，仅由循环线程访问
+        std::vector<Connection*> ready;     // 配额用完、等待下一轮继续读写的连接，仅由循环线程访问
+        std::vector<Connection*> ready_turn; // 本轮正在处理的就绪列表，仅由循环线程访问
+        std::unique_ptr<WireLatency> latency; // 本循环记录的延迟直方图，开启时间戳时创建
+        std::vector<Connection*> members;   // 已注册到本循环的连接，受 clients_mutex_ 保护
+        size_t sample_cursor = 0;           // TCP_INFO 采样的轮转位置，仅由循环线程访问
+        std::vector<TcpInfoJob> sampling;  // 本次采样的连接，复用容量，仅由循环线程访问
+        std::unique_ptr<TcpInfoHistograms> tcp_info; // 本循环记录的 TCP_INFO 直方图，启用采样时创建
+    };
+
+    /**
+     * @brief 接受客户端连接的循环（在独立线程中运行）
+     */
+    void accept_loop();
+
+    /**
+     * @brief 为新连接选择事件循环（在接受线程中运行）
+     * @param client_fd 客户端文件描述符
+     * @return 事件循环下标
+     */
+    uint32_t select_loop(int client_fd);
+
+    /**
+     * @brief 按放置策略计算各事件循环绑定的 CPU 和 CPU -> 事件循环表
+     * @param loop_count 事件循环数量
+     */
+    void plan_placement(size_t loop_count);
+
+    /**
+     * @brief 处理连接上的就绪事件（在事件循环线程中运行）
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @param events epoll 事件掩码
+     */
+    void handle_event(IoLoop& io, Connection* conn, uint32_t events);
+
+    /**
+     * @brief 读取连接上的所有可读数据并分发消息
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @return true 连接仍然有效，false 连接需要关闭
+     */
+    bool handle_read(IoLoop& io, Connection* conn);
+
+    /**
+     * @brief 读到 EAGAIN 或配额用完为止，handle_read() 的主体
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @param read_left 输入剩余的字节配额，输出读取后剩余的配额
+     * @return true 连接仍然有效，false 连接需要关闭
+     */
+    bool read_available(IoLoop& io, Connection* conn, size_t& read_left);
+
+    /**
+     * @brief 调用 on_data()，数据非法时记录日志
+     * @param conn 客户端连接
+     * @param data 数据起始地址
+     * @param length 数据长度
+     * @param consumed 输出参数，已处理的字节数
+     * @return true 继续，false 连接需要关闭
+     */
+    bool dispatch(Connection* conn, const char* data, size_t length, size_t& consumed);
+
+    /**
+     * @brief 按需调用 on_data_end()
+     * @param conn 客户端连接
+     */
+    void end_dispatch(Connection* conn) {
+        if (data_end_hook_) {
+            on_data_end(conn->fd);
+        }
+    }
+
+    /**
+     * @brief 继续发送连接输出缓冲区中的数据
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @return true 连接仍然有效，false 连接需要关闭
+     */
+    bool handle_write(IoLoop& io, Connection* conn);
+
+    /**
+     * @brief 记下一次写入，等待内核的发送时间戳
+     * @param conn 客户端连接（调用方持有 clients_mutex_）
+     * @param bytes 写入的字节数，不大于 0 时忽略
+     * @param sent_ns 写入调用前的时刻，由 send_started() 取得
+     */
+    static void note_sent(Connection& conn, ssize_t bytes, int64_t sent_ns);
+
+    /**
+     * @brief 写入调用前的时刻，连接未开启发送时间戳时为 0（不读时钟）
+     */
+    static int64_t send_started(const Connection& conn) {
+        return conn.tx_stamps ? Timestamping::realtime_ns() : 0;
+    }
+
+    /**
+     * @brief 读取错误队列中的发送时间戳并记录 tx_queue（在事件循环线程中运行）
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @return 是否读到了发送时间戳（读到时本次 EPOLLERR 由时间戳引起）
+     */
+    bool drain_tx_timestamps(IoLoop& io, Connection* conn);
+
+    /**
+     * @brief 把连接加入事件循环的成员列表（调用方持有 clients_mutex_）
+     */
+    static void add_member(IoLoop& io, Connection& conn);
+
+    /**
+     * @brief 把发送量和当前积压记入连接统计（调用方持有 clients_mutex_）
+     * @param conn 客户端连接
+     * @param bytes 写入 socket 的字节数
+     * @param messages 接受发送的消息数
+     */
+    void publish_output(const Connection& conn, uint64_t bytes, uint64_t messages) {
+        connection_stats_.record_output(conn.fd, bytes, messages, conn.output.size() + conn.urgent.size(),
+                                        Clock::cached_ns());
+    }
+
+    /**
+     * @brief 把连接移出事件循环的成员列表（调用方持有 clients_mutex_）
+     */
+    static void remove_member(IoLoop& io, Connection& conn);
+
+    /**
+     * @brief 采样本循环中到期连接的 TCP_INFO（在事件循环线程中由定时处理函数调用）
+     * @param io 所属事件循环
+     */
+    void sample_tcp_info(IoLoop& io);
+
+    /**
+     * @brief 把配额用完的连接记入就绪列表（在事件循环线程中运行）
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @param direction 等待继续的读写方向
+     */
+    void defer_ready(IoLoop& io, Connection* conn, uint8_t direction);
+
+    /**
+     * @brief 把连接移出就绪列表，用于关闭或迁出（在事件循环线程中运行）
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     */
+    void unlink_ready(IoLoop& io, Connection* conn);
+
+    /**
+     * @brief 继续读写上一轮让出的连接（事件循环的就绪列表处理函数）
+     * @param io 所属事件循环
+     * @return true 仍有连接在就绪列表中
+     */
+    bool run_ready(IoLoop& io);
+
+    /**
+     * @brief 在持有 clients_mutex_ 的情况下发送数据，发不完的部分排队
+     * @param conn 客户端连接
+     * @param data 数据起始地址
+     * @param length 数据长度
+     * @param priority 消息优先级
+     * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+     * @return true 已发送或已排队，false 发送失败或已过期
+     */
+    bool send_locked(Connection& conn, const char* data, size_t length, Priority priority, int64_t expiry_ns);
+
+    /**
+     * @brief 查询连接所属的事件循环（无锁）
+     * @param client_fd 客户端文件描述符
+     * @param generation 输出参数，登记时连接的代号
+     * @return 事件循环下标加一（迁移中带 OWNER_MIGRATING 标志），0 表示未知（未注册或超出登记表范围）
+     */
+    uint32_t owner_of(int client_fd, uint32_t& generation) const;
+
+    /**
+     * @brief 不在所属事件循环线程中（或连接正在迁移）时把消息投递给所属事件循环，需处于 RCU 读临界区
+     * @param client_fd 目标客户端
+     * @param message 消息内容
+     * @param priority 消息优先级
+     * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+     * @param accepted 输出参数，已投递时为 enqueue_send() 的结果
+     * @return true 已交给所属事件循环，false 所属未知或就在所属线程中，由调用方加锁直接发送
+     */
+    bool hand_off_send(int client_fd, std::string_view message, Priority priority, int64_t expiry_ns,
+                       bool& accepted);
+
+    /**
+     * @brief 登记或清除连接所属的事件循环
+     * @param client_fd 客户端文件描述符
+     * @param owner 事件循环下标加一，0 表示清除
+     * @param generation 连接代号，清除时为 0
+     */
+    void set_owner(int client_fd, uint32_t owner, uint32_t generation);
+
+    /**
+     * @brief 拷贝消息并投递到事件循环的发送队列，必要时唤醒事件循环
+     * @param io 目标事件循环
+     * @param client_fd 目标客户端
+     * @param generation 查询所属时得到的连接代号
+     * @param message 消息内容
+     * @param priority 消息优先级
+     * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+     * @return true 已投递，false 因内存超限被丢弃
+     */
+    bool enqueue_send(IoLoop& io, int client_fd, uint32_t generation, std::string_view message, Priority priority,
+                      int64_t expiry_ns);
+
+    /**
+     * @brief 取走并发送队列中的全部请求（事件循环的唤醒处理函数）
+     * @param io 所属事件循环
+     */
+    void drain_sends(IoLoop& io);
+
+    /**
+     * @brief 在持有 clients_mutex_ 的情况下发送一串请求并释放（迁入中连接的请求暂存不释放）
+     * @param io 当前事件循环
+     * @param request 按投递顺序链接的请求
+     * @return 已释放的请求字节数
+     */
+    size_t send_requests_locked(IoLoop& io, SendRequest* request);
+
+    /**
+     * @brief 在持有 clients_mutex_ 的情况下用一次 writev 发送同一连接的多条消息
+     * @param conn 客户端连接
+     * @param batch 按投递顺序排列的发送请求（都是普通消息，或者是单条紧急消息）
+     * @param batch_count 请求数量
+     */
+    void send_batch_locked(Connection& conn, SendRequest* const* batch, size_t batch_count);
+
+    /**
+     * @brief 丢弃事件循环队列中尚未发送的请求（事件循环已退出时调用）
+     * @param io 事件循环
+     */
+    void discard_sends(IoLoop& io);
+
+    /**
+     * @brief 在原事件循环中开始迁移指定连接（在原事件循环线程中运行）
+     * @param source 原事件循环下标
+     * @param client_fd 客户端文件描述符
+     * @param target 目标事件循环下标
+     */
+    void start_migration(size_t source, int client_fd, size_t target);
+
+    /**
+     * @brief 从事件循环中挑选一个连接迁往目标循环（在原事件循环线程中运行）
+     * @param source 原事件循环下标
+     * @param target 目标事件循环下标
+     * @param source_load 原事件循环的利用率
+     * @param movable_load 可以迁走的利用率上限
+     */
+    void shed_connection(size_t source, size_t target, double source_load, double movable_load);
+
+    /**
+     * @brief 注销连接并把所有权交给目标事件循环（需持有 clients_mutex_，在原事件循环线程中运行）
+     * @param source 原事件循环下标
+     * @param conn 客户端连接
+     * @param target 目标事件循环下标
+     */
+    void begin_migration_locked(size_t source, Connection& conn, size_t target);
+
+    /**
+     * @brief 等待投递给原事件循环的消息都已入队并发送，再通知目标事件循环接管
+     * @param source 原事件循环下标
+     * @param client_fd 客户端文件描述符
+     * @param target 目标事件循环下标
+     * @param epoch 更改所属事件循环之后推进的 RCU 纪元
+     */
+    void finish_migration(size_t source, int client_fd, size_t target, uint64_t epoch);
+
+    /**
+     * @brief 目标事件循环接管连接（在目标事件循环线程中运行）
+     * @param target 目标事件循环下标
+     * @param client_fd 客户端文件描述符
+     */
+    void adopt_connection(size_t target, int client_fd);
+
+    /**
+     * @brief 再均衡线程：按间隔采样各事件循环的利用率并触发迁移
+     */
+    void rebalance_loop();
+
+    /**
+     * @brief 在持有 clients_mutex_ 的情况下检查待排队的输出是否超限并执行策略
+     * @param conn 客户端连接
+     * @param length 将要排队的字节数
+     * @param priority 消息优先级
+     * @param droppable 消息是否尚未写出任何字节（可以整条丢弃）
+     * @return true 允许排队，false 拒绝（消息被丢弃或连接被断开）
+     */
+    bool admit_output(Connection& conn, size_t length, Priority priority, bool droppable);
+
+    /**
+     * @brief 读取前检查全局预算，超限时执行策略（在事件循环线程中运行）
+     * @param io 所属事件循环
+     * @param conn 客户端连接
+     * @return true 可以继续读取，false 已暂停读取
+     */
+    bool check_input_budget(IoLoop& io, Connection* conn);
+
+    /**
+     * @brief 计算连接当前应关注的 epoll 事件（需持有 clients_mutex_）
+     */
+    uint32_t interest_events(const Connection& conn) const;
+
+    /**
+     * @brief 按连接当前状态更新 epoll 关注的事件（需持有 clients_mutex_），未注册或迁移中的连接不操作
+     */
+    void update_interest(Connection& conn);
+
+    /**
+     * @brief 暂停读取连接（需持有 clients_mutex_）
+     * @param conn 客户端连接
+     * @param reason 暂停原因
+     */
+    void pause_reads(Connection& conn, uint8_t reason);
+
+    /**
+     * @brief 撤销一个暂停原因，没有剩余原因时恢复读取（需持有 clients_mutex_）
+     * @param conn 客户端连接
+     * @param reason 暂停原因
+     */
+    void resume_reads(Connection& conn, uint8_t reason);
+
+    /**
+     * @brief 恢复本事件循环中因全局超限暂停的连接（在事件循环线程中运行）
+     * @param io 所属事件循环
+     */
+    void resume_global_reads(IoLoop& io);
+
+    /**
+     * @brief 缓冲区归还后检查是否可以恢复全局暂停的读取
+     */
+    void on_memory_released();
+
+    /**
+     * @brief 查找持有缓冲最多的连接（需持有 clients_mutex_）
+     * @return 连接指针，没有可断开的连接时返回 nullptr
+     */
+    Connection* largest_connection_locked();
+
+    /**
+     * @brief 因内存超限断开连接（需持有 clients_mutex_）
+     * @param conn 客户端连接
+     *
+     * @details 立即丢弃待发送数据并 shutdown socket，由事件循环读到 EOF 后回收连接
+     */
+    void disconnect_locked(Connection& conn);
+
+    /**
+     * @brief 关闭指定客户端连接（在事件循环线程中运行）
+     * @param io 所属事件循环
+     * @param conn 要关闭的客户端连接
+     */
+    void close_client(IoLoop& io, Connection* conn);
+
+    /**
+     * @brief 为连接借用输入环形缓冲区
+     * @param conn 客户端连接
+     * @param size 需要的容量
+     * @return true 借用成功，false 映射失败
+     */
+    bool acquire_input(Connection* conn, size_t size);
+
+    /**
+     * @brief 向连接的输入环形缓冲区追加数据，必要时借用或换用更大的环形缓冲区
+     * @param conn 客户端连接
+     * @param data 数据起始地址
+     * @param length 数据长度
+     * @return true 追加成功，false 映射失败
+     */
+    bool append_input(Connection* conn, const char* data, size_t length);
+
+    /**
+     * @brief 归还连接的输入环形缓冲区（Eager 模式下只在 force 为 true 时归还）
+     * @param conn 客户端连接
+     * @param force 是否强制归还
+     */
+    void release_input(Connection* conn, bool force);
+
+    /**
+     * @brief 向缓冲区追加数据，必要时借用或扩容缓冲块
+     * @param buffer 目标缓冲区
+     * @param data 数据起始地址
+     * @param length 数据长度
+     */
+    void append_buffer(Buffer& buffer, const char* data, size_t length);
+
+    /**
+     * @brief 向缓冲区追加一帧（长度头加数据）
+     * @param buffer 目标缓冲区
+     * @param data 帧数据起始地址
+     * @param length 帧数据长度
+     * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+     */
+    void append_frame(Buffer& buffer, const char* data, size_t length, int64_t expiry_ns);
+
+    /**
+     * @brief 把消息剩余部分排入连接对应优先级的输出缓冲区
+     * @param conn 客户端连接
+     * @param data 数据起始地址
+     * @param length 数据长度
+     * @param priority 消息优先级
+     * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+     * @param partial 消息是否已写出一部分（剩余部分是正在写出的帧）
+     */
+    void queue_output(Connection& conn, const char* data, size_t length, Priority priority, int64_t expiry_ns,
+                      bool partial);
+
+    /**
+     * @brief 把积压期间待补发的合并键的最新值排入输出缓冲区（需持有 clients_mutex_）
+     * @param conn 客户端连接
+     * @return true 排入了数据，false 没有待补发的键
+     */
+    bool flush_conflated(Connection& conn);
+
+    /**
+     * @brief 消息是否已过期，过期时计入连接和全局的丢弃计数（需持有 clients_mutex_）
+     * @param conn 客户端连接
+     * @param length 消息长度
+     * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+     * @param now_ns 当前时间（纳秒），0 表示尚未读取，首次需要时读取并回填
+     * @return true 已过期（已计数），false 未过期
+     */
+    bool drop_if_expired(Connection& conn, size_t length, int64_t expiry_ns, int64_t& now_ns);
+
+    /**
+     * @brief 连接是否可以不经排队直接写出该优先级的消息（需持有 clients_mutex_），迁移中总是排队
+     */
+    static bool can_write_directly(const Connection& conn, Priority priority);
+
+    /**
+     * @brief 保证缓冲区尾部至少有 length 字节空闲空间
+     * @param buffer 目标缓冲区
+     * @param length 需要的空闲字节数
+     *
+     * @details 未持有缓冲区时按 length 所属档位从分档缓冲池借用
+     */
+    void reserve_buffer(Buffer& buffer, size_t length);
+
+    /**
+     * @brief 归还缓冲区（Eager 模式下只清空不归还，除非 force 为 true）
+     * @param buffer 目标缓冲区
+     * @param force 是否强制归还
+     */
+    void release_buffer(Buffer& buffer, bool force);
+
+    std::string ip_;                                    // 服务器绑定的 IP 地址
+    uint16_t port_;                                     // 服务器监听的端口
+    int server_fd_;                                     // 服务器 socket 文件描述符
+    std::atomic<bool> running_;                         // 服务器运行状态标志
+    bool data_end_hook_;                                // 是否调用 on_data_end()
+    std::atomic<bool> batch_dispatch_;                  // 是否启用批量分发
+
+    BufferArena::Options arena_options_;                // 内存区域配置
+    std::unique_ptr<BufferArena> arena_;                // 缓冲区的内存区域
+    std::unique_ptr<SizeClassPool> buffer_pool_;        // 连接缓冲块池（按大小分档）
+    std::unique_ptr<BufferPool> scratch_pool_;          // 事件循环临时读缓冲区池
+    std::unique_ptr<RingBufferPool> ring_pool_;         // 输入环形缓冲区池
+    BufferMode buffer_mode_;                            // 连接缓冲区内存模式
+
+    MemoryLimits limits_;                               // 内存上限配置
+    MemoryBudget budget_;                               // 缓冲内存记账
+    std::atomic<bool> global_paused_;                   // 是否有连接因全局超限暂停读取
+    std::atomic<size_t> paused_connections_;            // 暂停读取的连接数
+    std::atomic<uint64_t> dropped_messages_;            // 因超限丢弃的消息数
+    std::atomic<uint64_t> dropped_bytes_;               // 因超限丢弃的字节数
+    std::atomic<uint64_t> overflow_disconnects_;        // 因超限断开的连接数
+    std::atomic<uint64_t> expired_messages_;            // 因过期丢弃的消息数
+    std::atomic<uint64_t> expired_bytes_;               // 因过期丢弃的字节数
+    std::atomic<uint64_t> conflated_updates_;           // 合并广播中被取代的更新数
+
+    std::unique_ptr<ThreadPool> thread_pool_;           // 线程池指针（运行事件循环）
+    std::vector<IoLoop> loops_;                         // 事件循环列表
+    std::vector<std::future<void>> loop_futures_;       // 事件循环任务的 future
+    size_t next_loop_;                                  // 轮询分配的下一个事件循环
+    Placement placement_;                               // 新连接的放置策略
+    bool reuse_port_;                                   // 是否开启 SO_REUSEPORT
+    std::vector<int> loop_cpus_;                        // 各事件循环绑定的 CPU
+    std::vector<int32_t> cpu_loops_;                    // CPU 编号 -> 事件循环下标，-1 表示退回轮询
+    std::atomic<uint64_t> placed_same_cpu_;             // 分配到收包 CPU 上的连接数
+    std::atomic<uint64_t> placed_same_node_;            // 分配到同节点其他 CPU 上的连接数
+    std::atomic<uint64_t> placed_fallback_;             // 退回轮询的连接数
+    std::thread accept_thread_;                         // 接受连接的线程
+
+    RebalanceOptions rebalance_options_;                // 再均衡配置
+    std::thread rebalance_thread_;                      // 再均衡线程
+    mutable std::mutex rebalance_mutex_;                // 再均衡线程的等待与利用率互斥锁
+    std::condition_variable rebalance_cv_;              // 停止时唤醒再均衡线程
+    std::vector<double> utilization_;                   // 各事件循环最近一次采样的利用率，受 rebalance_mutex_ 保护
+    std::atomic<uint64_t> migrated_connections_;        // 已完成的迁移次数
+    FairnessBudget fairness_;                           // 每个连接每轮的读写配额
+    std::atomic<uint64_t> deferred_turns_;              // 因配额用完而让出的次数
+    BusyPollOptions busy_poll_;                         // 事件循环的忙轮询配置
+    bool socket_busy_poll_;                             // 是否为接受的连接设置内核忙轮询选项
+    RealtimeOptions realtime_;                          // 事件循环线程的实时化配置
+    TimestampingOptions timestamping_;                  // 内核时间戳配置
+    TcpInfoOptions tcp_info_options_;                   // TCP_INFO 采样配置
+    std::atomic<bool> timestamping_warned_;             // 是否已打印时间戳不可用的警告
+    inline static thread_local int64_t current_rx_timestamp_ = 0; // 本次读取的内核接收时间戳
+    inline static thread_local size_t message_quota_ = SIZE_MAX; // 当前读取轮次剩余的消息配额
+
+    std::unordered_map<int, Connection> clients_;       // 客户端映射表（fd -> 连接状态）
+    mutable std::mutex clients_mutex_;                  // 客户端列表互斥锁
+    std::unordered_map<uint64_t, uint32_t> conflation_index_; // 合并键 -> 下标，受 clients_mutex_ 保护
+    std::vector<std::string> conflation_values_;        // 各合并键的最新值，受 clients_mutex_ 保护
+    std::unique_ptr<std::atomic<uint64_t>[]> owners_;   // fd -> 连接代号（高 32 位）与所属事件循环下标加一（低 32 位），无锁查询
+    size_t owner_capacity_;                             // 登记表大小
+    uint32_t next_generation_;                          // 下一个连接代号（跳过 0），受 clients_mutex_ 保护
+    ConnectionStatsTable connection_stats_;             // 按 fd 索引的连接统计（无锁读取）
+};
+
+#endif // TCP_SERVER_BASE_H
@@ -0,0 +1,293 @@
+#include "connection_stats.h"
+#include "busy_poll.h"
+
+#include <algorithm>
+#include <climits>
+#include <new>
+
+/**
+ * @brief 析构函数，释放已分配的记录块
+ */
+ConnectionStatsTable::~ConnectionStatsTable() {
+    for (size_t i = 0; i < chunk_count_; ++i) {
+        delete[] chunks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 创建记录块目录
+ * @param capacity 记录数
+ * @return 是否成功
+ *
+ * @details 只分配块指针目录（每 CHUNK_RECORDS 个 fd 一个指针），记录块在该范围内
+ *          第一次 open() 时分配，开启 mlockall 时也只锁定用到的块
+ */
+bool ConnectionStatsTable::init(size_t capacity) {
+    if (chunks_ || capacity == 0) {
+        return chunks_ != nullptr;
+    }
+    capacity = std::min<size_t>(capacity, INT_MAX);
+    chunk_count_ = (capacity + CHUNK_RECORDS - 1) / CHUNK_RECORDS;
+    chunks_ = std::make_unique<std::atomic<Record*>[]>(chunk_count_);
+    capacity_ = capacity;
+    return true;
+}
+
+/**
+ * @brief 查找 fd 的记录
+ * @param fd 客户端文件描述符
+ * @return 记录，越界或所在块尚未分配时为 nullptr
+ */
+ConnectionStatsTable::Record* ConnectionStatsTable::find(int fd) const {
+    if (fd < 0 || static_cast<size_t>(fd) >= capacity_) {
+        return nullptr;
+    }
+    Record* chunk = chunks_[static_cast<size_t>(fd) / CHUNK_RECORDS].load(std::memory_order_acquire);
+    return chunk ? chunk + static_cast<size_t>(fd) % CHUNK_RECORDS : nullptr;
+}
+
+/**
+ * @brief 查找 fd 的记录，所在块尚未分配时分配并清零
+ * @param fd 客户端文件描述符
+ * @return 记录，越界或分配失败时为 nullptr
+ */
+ConnectionStatsTable::Record* ConnectionStatsTable::find_or_allocate(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= capacity_) {
+        return nullptr;
+    }
+    std::atomic<Record*>& slot = chunks_[static_cast<size_t>(fd) / CHUNK_RECORDS];
+    Record* chunk = slot.load(std::memory_order_acquire);
+    if (!chunk) {
+        Record* created = new (std::nothrow) Record[CHUNK_RECORDS]();
+        if (!created) {
+            return nullptr;
+        }
+        if (slot.compare_exchange_strong(chunk, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            chunk = created;
+        } else {
+            delete[] created;
+        }
+    }
+    return chunk + static_cast<size_t>(fd) % CHUNK_RECORDS;
+}
+
+/**
+ * @brief 开始写入：把序号置为奇数
+ * @param record 连接记录
+ * @return 写入前的（偶数）序号
+ *
+ * @details 另一个写入方正在写同一条记录时自旋等待，写入只有几次存储，等待很短
+ */
+uint32_t ConnectionStatsTable::begin_write(Record& record) {
+    std::atomic<uint32_t>& sequence = record.sequence;
+    uint32_t current = sequence.load(std::memory_order_relaxed);
+    while ((current & 1) != 0
+           || !sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+        BusyPoller::relax();
+        current = sequence.load(std::memory_order_relaxed);
+    }
+    // 之后的字段写入不会排到序号变为奇数之前
+    std::atomic_thread_fence(std::memory_order_release);
+    return current;
+}
+
+/**
+ * @brief 结束写入
+ * @param record 连接记录
+ * @param sequence begin_write() 返回的序号
+ */
+void ConnectionStatsTable::end_write(Record& record, uint32_t sequence) {
+    record.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * @brief 开始记录一个新连接
+ */
+void ConnectionStatsTable::open(int fd, uint32_t ip, uint16_t port, uint32_t loop_index, int64_t now_ns) {
+    Record* found = find_or_allocate(fd);
+    if (!found) {
+        return;
+    }
+    Record& record = *found;
+    uint32_t sequence = begin_write(record);
+    bool was_open = record.connected_ns.load(std::memory_order_relaxed) != 0;
+    record.ip.store(ip, std::memory_order_relaxed);
+    record.port.store(port, std::memory_order_relaxed);
+    record.loop_index.store(static_cast<uint16_t>(loop_index), std::memory_order_relaxed);
+    record.queued_bytes.store(0, std::memory_order_relaxed);
+    record.connected_ns.store(now_ns, std::memory_order_relaxed);
+    record.last_activity_ns.store(now_ns, std::memory_order_relaxed);
+    record.bytes_in.store(0, std::memory_order_relaxed);
+    record.bytes_out.store(0, std::memory_order_relaxed);
+    record.messages_in.store(0, std::memory_order_relaxed);
+    record.messages_out.store(0, std::memory_order_relaxed);
+    end_write(record, sequence);
+
+    if (!was_open) {
+        open_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    int high = high_water_.load(std::memory_order_relaxed);
+    while (fd > high && !high_water_.compare_exchange_weak(high, fd, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 连接关闭
+ */
+void ConnectionStatsTable::close(int fd) {
+    Record* record = find(fd);
+    if (!record) {
+        return;
+    }
+    uint32_t sequence = begin_write(*record);
+    bool was_open = record->connected_ns.load(std::memory_order_relaxed) != 0;
+    record->connected_ns.store(0, std::memory_order_relaxed);
+    end_write(*record, sequence);
+    if (was_open) {
+        open_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 连接迁移到其他事件循环
+ */
+void ConnectionStatsTable::set_loop(int fd, uint32_t loop_index) {
+    Record* record = find(fd);
+    if (!record) {
+        return;
+    }
+    uint32_t sequence = begin_write(*record);
+    record->loop_index.store(static_cast<uint16_t>(loop_index), std::memory_order_relaxed);
+    end_write(*record, sequence);
+}
+
+/**
+ * @brief 记录读取
+ *
+ * @details 计数只有写入方修改，且写入方互斥，读取后加回即可，不需要原子加法
+ */
+void ConnectionStatsTable::record_input(int fd, uint64_t bytes, uint64_t messages, int64_t now_ns) {
+    Record* found = find(fd);
+    if (!found) {
+        return;
+    }
+    Record& record = *found;
+    uint32_t sequence = begin_write(record);
+    record.bytes_in.store(record.bytes_in.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    record.messages_in.store(record.messages_in.load(std::memory_order_relaxed) + messages,
+                             std::memory_order_relaxed);
+    if (bytes != 0) {
+        record.last_activity_ns.store(now_ns, std::memory_order_relaxed);
+    }
+    end_write(record, sequence);
+}
+
+/**
+ * @brief 记录发送
+ */
+void ConnectionStatsTable::record_output(int fd, uint64_t bytes, uint64_t messages, uint64_t queued_bytes,
+                                         int64_t now_ns) {
+    Record* found = find(fd);
+    if (!found) {
+        return;
+    }
+    Record& record = *found;
+    uint32_t sequence = begin_write(record);
+    record.bytes_out.store(record.bytes_out.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    record.messages_out.store(record.messages_out.load(std::memory_order_relaxed) + messages,
+                              std::memory_order_relaxed);
+    record.queued_bytes.store(static_cast<uint32_t>(std::min<uint64_t>(queued_bytes, UINT32_MAX)),
+                              std::memory_order_relaxed);
+    if (bytes != 0) {
+        record.last_activity_ns.store(now_ns, std::memory_order_relaxed);
+    }
+    end_write(record, sequence);
+}
+
+/**
+ * @brief 读取一条记录的一致快照
+ * @param record 连接记录
+ * @param fd 客户端文件描述符
+ * @param stats 输出参数
+ * @return 记录是否在用
+ *
+ * @details 序号为奇数或前后不一致时重读；空闲记录只读序号和连接时刻
+ */
+bool ConnectionStatsTable::load(const Record& record, int fd, ConnectionStats& stats) const {
+    while (true) {
+        uint32_t before = record.sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            BusyPoller::relax();
+            continue;
+        }
+        stats.connected_ns = record.connected_ns.load(std::memory_order_relaxed);
+        if (stats.connected_ns != 0) {
+            stats.fd = fd;
+            stats.loop_index = record.loop_index.load(std::memory_order_relaxed);
+            stats.ip = record.ip.load(std::memory_order_relaxed);
+            stats.port = record.port.load(std::memory_order_relaxed);
+            stats.last_activity_ns = record.last_activity_ns.load(std::memory_order_relaxed);
+            stats.bytes_in = record.bytes_in.load(std::memory_order_relaxed);
+            stats.bytes_out = record.bytes_out.load(std::memory_order_relaxed);
+            stats.messages_in = record.messages_in.load(std::memory_order_relaxed);
+            stats.messages_out = record.messages_out.load(std::memory_order_relaxed);
+            stats.queued_bytes = record.queued_bytes.load(std::memory_order_relaxed);
+        }
+        // 上面的读取不会排到序号复查之后
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) == before) {
+            return stats.connected_ns != 0;
+        }
+    }
+}
+
+/**
+ * @brief 读取单个连接的统计
+ */
+bool ConnectionStatsTable::read(int fd, ConnectionStats& stats) const {
+    const Record* record = find(fd);
+    return record && load(*record, fd, stats);
+}
+
+/**
+ * @brief 分页遍历连接
+ *
+ * @details 只扫描到出现过的最大 fd，跳过尚未分配的记录块；本页取满时返回最后一个连接的下一个 fd。
+ *          记录中的时刻可能晚于 now_ns（视为距今 0），不设时长条件的遍历不会漏掉刚活动或刚建立的连接
+ */
+int ConnectionStatsTable::scan(int cursor, size_t limit, const ConnectionFilter& filter, int64_t now_ns,
+                               std::vector<ConnectionStats>& out) const {
+    out.clear();
+    if (!chunks_ || cursor < 0) {
+        return -1;
+    }
+    int64_t idle_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(filter.idle_for).count();
+    int64_t age_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(filter.connected_for).count();
+    int high = high_water_.load(std::memory_order_relaxed);
+
+    ConnectionStats stats;
+    for (int fd = cursor; fd <= high; ++fd) {
+        if (out.size() >= limit) {
+            return fd;
+        }
+        const Record* record = find(fd);
+        if (!record) {
+            // 整个块尚未分配，跳到下一块
+            fd = static_cast<int>((static_cast<size_t>(fd) / CHUNK_RECORDS + 1) * CHUNK_RECORDS) - 1;
+            continue;
+        }
+        if (!load(*record, fd, stats)) {
+            continue;
+        }
+        // 遍历期间事件循环仍在更新记录，时刻可能晚于 now_ns；时长条件为 0 时不参与过滤
+        if ((filter.loop_index >= 0 && stats.loop_index != static_cast<uint32_t>(filter.loop_index))
+            || (idle_ns > 0 && now_ns - stats.last_activity_ns < idle_ns)
+            || (age_ns > 0 && now_ns - stats.connected_ns < age_ns)
+            || stats.queued_bytes < filter.min_queued_bytes) {
+            continue;
+        }
+        out.push_back(stats);
+    }
+    return -1;
+}
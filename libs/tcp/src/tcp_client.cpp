@@ -1,10 +1,12 @@
 #include "tcp_client.h"
+#include "clock.h"
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <cstring>
@@ -13,10 +15,16 @@
 /// @brief 接收缓冲区大小
 constexpr int BUFFER_SIZE = 4096;
 
+/// @brief 单条消息（半包累积）的最大长度
+constexpr size_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
 /**
  * @brief 构造函数实现
+ * @details 每个档位最多缓存一个环形缓冲区，换档后再换回来时无需重新映射
  */
-TcpClient::TcpClient() : socket_fd_(-1), connected_(false) {}
+TcpClient::TcpClient()
+    : socket_fd_(-1), connected_(false), sending_(false), urgent_waiting_(0), ring_pool_(1), input_(nullptr) {
+}
 
 /**
  * @brief 析构函数实现
@@ -65,13 +73,21 @@ bool TcpClient::connect(const std::string& ip, uint16_t port) {
         return false;
     }
 
+    if (!BusyPoller::apply_socket_options(socket_fd_, busy_poll_)) {
+        std::cerr << "[TcpClient] Kernel busy polling unavailable, spinning only: " << strerror(errno) << std::endl;
+    }
+
+    {
+        // 新连接的重传计数从 0 起算
+        std::lock_guard<std::mutex> lock(tcp_info_mutex_);
+        tcp_info_ = TcpInfoSample();
+    }
+
     connected_ = true;
     std::cout << "[TcpClient] Connected to " << ip << ":" << port << std::endl;
 
     // 触发连接回调
-    if (connection_callback_) {
-        connection_callback_(true);
-    }
+    notify_connection(true);
 
     // 启动接收线程
     receive_thread_ = std::thread(&TcpClient::receive_loop, this);
@@ -105,32 +121,60 @@ void TcpClient::disconnect() {
     std::cout << "[TcpClient] Disconnected" << std::endl;
 
     // 触发连接回调
-    if (connection_callback_) {
-        connection_callback_(false);
-    }
+    notify_connection(false);
 }
 
 /**
  * @brief 发送消息到服务器
  * @param message 要发送的消息
+ * @param priority 消息优先级
  * @return 发送是否成功
+ *
+ * @details
+ * 写 socket 时不持有互斥锁，只用它排队：普通消息要等到没有线程在写、也没有紧急消息
+ * 在等待时才能开始，紧急消息只需等当前消息写完
  */
-bool TcpClient::send(const std::string& message) {
+bool TcpClient::send(const std::string& message, Priority priority) {
     // 检查连接状态
     if (!connected_) {
         return false;
     }
 
-    // 加锁保证线程安全
-    std::lock_guard<std::mutex> lock(send_mutex_);
-    ssize_t bytes_sent = ::send(socket_fd_, message.c_str(), message.size(), 0);
+    // 排队获得 socket
+    {
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        if (priority == Priority::Urgent) {
+            ++urgent_waiting_;
+            send_cv_.wait(lock, [this]() { return !sending_; });
+            --urgent_waiting_;
+        } else {
+            send_cv_.wait(lock, [this]() { return !sending_ && urgent_waiting_ == 0; });
+        }
+        sending_ = true;
+    }
 
-    if (bytes_sent < 0) {
-        std::cerr << "[TcpClient] Send failed: " << strerror(errno) << std::endl;
-        return false;
+    // 阻塞 socket 上被信号打断时可能只写出一部分，继续写完整帧
+    bool ok = true;
+    size_t sent = 0;
+    while (sent < message.size()) {
+        ssize_t bytes_sent = ::send(socket_fd_, message.data() + sent, message.size() - sent, 0);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[TcpClient] Send failed: " << strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        sent += static_cast<size_t>(bytes_sent);
     }
 
-    return bytes_sent == static_cast<ssize_t>(message.size());
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        sending_ = false;
+    }
+    send_cv_.notify_all();
+    return ok;
 }
 
 /**
@@ -173,52 +217,232 @@ void TcpClient::receive_loop() {
     }
 
 #else  // 使用 select 实现
-    while (connected_) {
-        fd_set read_fds;
-        FD_ZERO(&read_fds);
-        FD_SET(socket_fd_, &read_fds);
+    // 数据直接读入输入环形缓冲区的可写区域，容量随预测大小换档
+    if (!reserve_input(predictor_.next_size())) {
+        return;
+    }
 
-        struct timeval timeout;
-        timeout.tv_sec  = 1;
-        timeout.tv_usec = 0;
+    Realtime::configure_io_thread(realtime_);
+    BusyPoller poller(busy_poll_);
 
-        int ret = select(socket_fd_ + 1, &read_fds, NULL, NULL, &timeout);
-        if (ret < 0) {
-            std::cerr << "[TcpClient] Select failed: " << strerror(errno) << std::endl;
-            return;
+    while (connected_) {
+        // 忙轮询的自旋阶段直接尝试读取，否则先用 select 等待可读
+        if (!poller.spinning()) {
+            fd_set read_fds;
+            FD_ZERO(&read_fds);
+            FD_SET(socket_fd_, &read_fds);
+
+            struct timeval timeout;
+            timeout.tv_sec  = 1;
+            timeout.tv_usec = 0;
+            if (tcp_info_options_.enabled && tcp_info_options_.interval < std::chrono::seconds(1)) {
+                timeout.tv_sec = 0;
+                timeout.tv_usec = std::chrono::duration_cast<std::chrono::microseconds>(tcp_info_options_.interval).count();
+            }
+
+            int ret = select(socket_fd_ + 1, &read_fds, NULL, NULL, &timeout);
+            if (ret < 0) {
+                std::cerr << "[TcpClient] Select failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            if (tcp_info_options_.enabled) {
+                Clock::refresh();
+                sample_tcp_info(Clock::cached_ns());
+            }
+            if (!FD_ISSET(socket_fd_, &read_fds)) {
+                continue;
+            }
         }
 
-if (FD_ISSET(socket_fd_, &read_fds)) {
-            char buffer[BUFFER_SIZE];
-            memset(buffer, 0, sizeof(buffer));
-            ssize_t bytes_read = recv(socket_fd_, buffer, sizeof(buffer) - 1, 0);
-
-            if (bytes_read <= 0) {
-                if (bytes_read == 0) {
-                    std::cout << "[TcpClient] Server closed connection" << std::endl;
-                } else {
-                    std::cerr << "[TcpClient] Recv error: " << strerror(errno) << std::endl;
-                }
-                return;
+        iovec iov;
+        iov.iov_base = input_->write_ptr();
+        iov.iov_len = input_->writable();
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t bytes_read = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
+
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            poller.on_idle();
+            continue;
+        }
+        if (bytes_read <= 0) {
+            if (bytes_read == 0) {
+                std::cout << "[TcpClient] Server closed connection" << std::endl;
+            } else {
+                std::cerr << "[TcpClient] Recv error: " << strerror(errno) << std::endl;
             }
+            break;
+        }
+        poller.on_work();
+        Clock::refresh();
+        if (tcp_info_options_.enabled) {
+            sample_tcp_info(Clock::cached_ns());
+        }
 
-            std::string message(buffer, bytes_read);
-            std::cout << "[TcpClient] Received: " << message << std::endl;
+        input_->commit(static_cast<size_t>(bytes_read));
+        input_->consume(dispatch_frames());
 
-            if (message_callback_) {
-                message_callback_(message);
-            }
+        if (input_->size() > MAX_FRAME_SIZE) {
+            std::cerr << "[TcpClient] Frame too large" << std::endl;
+            break;
+        }
+
+        // 读满则快速增大，持续偏小则缓慢缩小；半包较大时换用更大的档位
+        predictor_.record(static_cast<size_t>(bytes_read));
+        if (!reserve_input(predictor_.next_size())) {
+            break;
         }
     }
 
+    ring_pool_.release(input_);
+    input_ = nullptr;
+    Clock::invalidate();
+
 #endif
     // 如果是服务器端断开连接，更新本地状态
     if (connected_) {
         connected_ = false;
-        if (connection_callback_) {
-            connection_callback_(false);
+        notify_connection(false);
+    }
+}
+
+/**
+ * @brief 距上次采样超过 interval 时采样一次 TCP_INFO
+ * @param now_ns 当前时刻
+ *
+ * @details getsockopt 在锁外进行，只在写回时短暂持锁
+ */
+void TcpClient::sample_tcp_info(int64_t now_ns) {
+    int64_t interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tcp_info_options_.interval).count();
+    TcpInfoSample sample;
+    {
+        std::lock_guard<std::mutex> lock(tcp_info_mutex_);
+        if (tcp_info_.sampled_ns != 0 && now_ns - tcp_info_.sampled_ns < interval_ns) {
+            return;
         }
+        sample = tcp_info_;
     }
+    if (!TcpInfoSampler::sample(socket_fd_, sample, now_ns)) {
+        return;
+    }
+    tcp_info_histograms_->record(sample);
+    std::lock_guard<std::mutex> lock(tcp_info_mutex_);
+    tcp_info_ = sample;
+}
+
+/**
+ * @brief 设置 TCP_INFO 采样
+ * @param options 采样配置
+ */
+void TcpClient::set_tcp_info_sampling(const TcpInfoOptions& options) {
+    tcp_info_options_ = options;
+    if (options.enabled && !tcp_info_histograms_) {
+        tcp_info_histograms_ = std::make_unique<TcpInfoHistograms>();
+    }
+}
+
+/**
+ * @brief 获取最近一次的 TCP_INFO 采样
+ */
+TcpInfoSample TcpClient::tcp_info() const {
+    std::lock_guard<std::mutex> lock(tcp_info_mutex_);
+    return tcp_info_;
+}
+
+/**
+ * @brief 获取 TCP_INFO 采样的汇总分布
+ */
+TcpInfoStats TcpClient::tcp_info_stats() const {
+    if (!tcp_info_histograms_) {
+        return TcpInfoStats();
+    }
+    return tcp_info_histograms_->stats();
+}
+
+/**
+ * @brief 触发连接状态回调
+ * @param connected 当前是否已连接
+ */
+void TcpClient::notify_connection(bool connected) {
+    Rcu::ReadGuard guard;
+    const ConnectionCallback* callback = connection_callback_.load();
+    if (callback && *callback) {
+        (*callback)(connected);
+    }
+}
+
+/**
+ * @brief 从输入环形缓冲区中切分完整消息并触发回调
+ * @return 已处理的字节数
+ *
+ * @details 消息拷贝到复用的字符串中，容量增长到位后不再分配内存
+ */
+size_t TcpClient::dispatch_frames() {
+    const char* data = input_->read_ptr();
+    size_t length = input_->size();
+
+    // 每次读取只进入一次读临界区，逐条消息只是一次加载
+    Rcu::ReadGuard guard;
+    const MessageCallback* callback = message_callback_.load();
+
+    // 未设置分帧函数时，整段数据作为一条消息
+    if (!frame_splitter_) {
+        message_.assign(data, length);
+        if (callback && *callback) {
+            (*callback)(message_);
+        }
+        return length;
+    }
+
+    size_t consumed = 0;
+    while (consumed < length) {
+        size_t frame_length = frame_splitter_(data + consumed, length - consumed);
+        if (frame_length == 0 || frame_length > length - consumed) {
+            break;
+        }
+
+        message_.assign(data + consumed, frame_length);
+        if (callback && *callback) {
+            (*callback)(message_);
+        }
+        consumed += frame_length;
+    }
+    return consumed;
+}
+
+/**
+ * @brief 保证输入环形缓冲区的可写空间
+ * @param length 需要的可写字节数
+ * @return 是否成功
+ *
+ * @details
+ * 缓冲区为空时直接换成预测档位；有半包且空间不足时换用能容纳
+ * 半包与新数据的档位，只拷贝一次半包
+ */
+bool TcpClient::reserve_input(size_t length) {
+    size_t wanted = RingBufferPool::class_size(length);
+
+    if (input_ && input_->size() == 0 && input_->capacity() == wanted) {
+        return true;
+    }
+    if (input_ && input_->size() > 0 && input_->writable() >= length) {
+        return true;
+    }
+
+    size_t pending = input_ ? input_->size() : 0;
+    MagicRingBuffer* ring = ring_pool_.acquire(pending + length);
+    if (!ring) {
+        std::cerr << "[TcpClient] Failed to allocate input buffer" << std::endl;
+        return false;
+    }
+
+    if (input_) {
+        ring->append(input_->read_ptr(), pending);
+        ring_pool_.release(input_);
+    }
+    input_ = ring;
+    return true;
 }
 
 /**
@@ -226,7 +450,7 @@ if (FD_ISSET(socket_fd_, &read_fds)) {
  * @param callback 回调函数
  */
 void TcpClient::set_message_callback(MessageCallback callback) {
-    message_callback_ = std::move(callback);
+    message_callback_.store(std::move(callback));
 }
 
 /**
@@ -234,5 +458,13 @@ void TcpClient::set_message_callback(MessageCallback callback) {
  * @param callback 回调函数
  */
 void TcpClient::set_connection_callback(ConnectionCallback callback) {
-    connection_callback_ = std::move(callback);
+    connection_callback_.store(std::move(callback));
+}
+
+/**
+ * @brief 设置分帧函数
+ * @param splitter 分帧函数
+ */
+void TcpClient::set_frame_splitter(FrameSplitter splitter) {
+    frame_splitter_ = std::move(splitter);
 }
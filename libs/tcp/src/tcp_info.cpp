@@ -0,0 +1,41 @@
+#include "tcp_info.h"
+
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+
+/**
+ * @brief 采样一次
+ * @param fd TCP socket 文件描述符
+ * @param sample 上一次的采样，输出本次采样
+ * @param now_ns 采样时刻
+ * @return 是否成功
+ *
+ * @details 使用内核头文件中的 tcp_info（glibc 的定义缺少 tcpi_delivery_rate 等新字段）；
+ *          旧内核返回的结构较短，没有覆盖到的字段保持为 0
+ */
+bool TcpInfoSampler::sample(int fd, TcpInfoSample& sample, int64_t now_ns) {
+    tcp_info info{};
+    socklen_t length = sizeof(info);
+    if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &length) != 0) {
+        return false;
+    }
+
+    uint32_t previous_retrans = sample.total_retrans;
+    bool first = sample.sampled_ns == 0;
+
+    sample.sampled_ns = now_ns;
+    sample.rtt_us = info.tcpi_rtt;
+    sample.rttvar_us = info.tcpi_rttvar;
+    sample.cwnd = info.tcpi_snd_cwnd;
+    sample.total_retrans = info.tcpi_total_retrans;
+    sample.retransmits = first ? info.tcpi_total_retrans : info.tcpi_total_retrans - previous_retrans;
+    sample.unacked = info.tcpi_unacked;
+    sample.unacked_bytes = static_cast<uint64_t>(info.tcpi_unacked) * info.tcpi_snd_mss;
+    sample.delivery_rate = length >= offsetof(tcp_info, tcpi_delivery_rate) + sizeof(info.tcpi_delivery_rate)
+                               ? info.tcpi_delivery_rate
+                               : 0;
+    return true;
+}
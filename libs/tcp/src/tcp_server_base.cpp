@@ -0,0 +1,2592 @@
+#include "tcp_server_base.h"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include "rcu.h"
+#include "cpu_topology.h"
+#include "clock.h"
+
+/// @brief 每个事件循环的临时读缓冲区大小
+constexpr int SCRATCH_SIZE = 65536;
+
+/// @brief 自动计算区域大小时为连接缓冲块预留的字节数
+constexpr size_t DEFAULT_POOL_BYTES = 4 * 1024 * 1024;
+
+/// @brief 启动时预先创建的输入环形缓冲区数量
+constexpr size_t DEFAULT_PREWARM_RINGS = 64;
+
+/// @brief 暂停原因：单连接待发送数据超限
+constexpr uint8_t PAUSE_OUTPUT = 1;
+
+/// @brief 暂停原因：全局预算超限
+constexpr uint8_t PAUSE_GLOBAL = 2;
+
+/// @brief 就绪列表中等待继续读取
+constexpr uint8_t READY_READ = 1;
+
+/// @brief 就绪列表中等待继续写出
+constexpr uint8_t READY_WRITE = 2;
+
+/// @brief 一次 writev 合并的最大消息数
+constexpr size_t MAX_SEND_BATCH = 64;
+
+/// @brief fd -> 事件循环登记表的最大项数，超出范围的 fd 退回加锁发送
+constexpr size_t MAX_OWNER_ENTRIES = 4 * 1024 * 1024;
+
+/// @brief 登记表中表示连接正在迁移的标志位，其余位为目标事件循环下标加一
+constexpr uint32_t OWNER_MIGRATING = 0x80000000u;
+
+/// @brief 普通输出每帧前的长度头大小
+constexpr size_t FRAME_HEADER_SIZE = sizeof(uint32_t);
+
+/// @brief 长度头中表示其后带有过期时间的标志位
+constexpr uint32_t FRAME_EXPIRY_FLAG = 0x80000000u;
+
+/// @brief 过期时间字段大小
+constexpr size_t FRAME_EXPIRY_SIZE = sizeof(int64_t);
+
+/// @brief 最大等待连接队列长度
+constexpr int MAX_PENDING_CONNECTIONS = SOMAXCONN;
+
+/// @brief 连接默认关注的事件（边缘触发）
+constexpr uint32_t READ_EVENTS = EPOLLIN | EPOLLRDHUP | EPOLLET;
+
+/// @brief 有待发送数据时关注的事件
+constexpr uint32_t WRITE_EVENTS = READ_EVENTS | EPOLLOUT;
+
+/// @brief 暂停读取时关注的事件（只关心对端关闭）
+constexpr uint32_t PAUSED_EVENTS = EPOLLRDHUP | EPOLLET;
+
+/**
+ * @brief 把网络字节序 IP 和端口格式化为 "IP:Port"
+ */
+static std::string format_address(uint32_t ip, uint16_t port) {
+    in_addr addr{};
+    addr.s_addr = ip;
+    char ip_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr, ip_str, sizeof(ip_str));
+    return std::string(ip_str) + ":" + std::to_string(port);
+}
+
+/**
+ * @brief 把过期时间点转换为纳秒，默认值转换为 0（永不过期）
+ */
+static int64_t expiry_to_ns(TcpServerBase::Expiry expiry) {
+    if (expiry == TcpServerBase::Expiry()) {
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(expiry.time_since_epoch()).count();
+}
+
+/**
+ * @brief 构造函数实现
+ * @param ip 服务器绑定的 IP 地址
+ * @param port 服务器监听的端口
+ * @param thread_pool_size 线程池大小
+ */
+TcpServerBase::TcpServerBase(const std::string& ip, uint16_t port, size_t thread_pool_size)
+    : ip_(ip)
+    , port_(port)
+    , server_fd_(-1)
+    , running_(false)
+    , data_end_hook_(false)
+    , batch_dispatch_(false)
+    , buffer_mode_(BufferMode::Eager)
+    , global_paused_(false)
+    , paused_connections_(0)
+    , dropped_messages_(0)
+    , dropped_bytes_(0)
+    , overflow_disconnects_(0)
+    , expired_messages_(0)
+    , expired_bytes_(0)
+    , conflated_updates_(0)
+    , thread_pool_(std::make_unique<ThreadPool>(thread_pool_size))
+    , next_loop_(0)
+    , placement_(Placement::RoundRobin)
+    , reuse_port_(false)
+    , placed_same_cpu_(0)
+    , placed_same_node_(0)
+    , placed_fallback_(0)
+    , migrated_connections_(0)
+    , deferred_turns_(0)
+    , socket_busy_poll_(false)
+    , timestamping_warned_(false)
+    , owner_capacity_(0)
+    , next_generation_(1) {
+    // 区域大小默认按事件循环数量自动计算
+    arena_options_.size = 0;
+}
+
+/**
+ * @brief 析构函数实现
+ * @details 派生类必须已在自己的析构函数中调用 stop()
+ */
+TcpServerBase::~TcpServerBase() {
+    // stop() 之后才投递的请求不会再有事件循环处理
+    for (IoLoop& io : loops_) {
+        discard_sends(io);
+    }
+}
+
+/**
+ * @brief 启动服务器
+ * @return 启动是否成功
+ */
+bool TcpServerBase::start() {
+    // 检查是否已在运行
+    if (running_) {
+        return false;
+    }
+
+    // 创建 socket
+    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd_ < 0) {
+        std::cerr << "[TcpServer] Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 设置地址复用选项，避免 TIME_WAIT 状态导致绑定失败
+    int opt = 1;
+    if (setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        std::cerr << "[TcpServer] Failed to set socket options: " << strerror(errno) << std::endl;
+        close(server_fd_);
+        return false;
+    }
+
+    // 多个进程各自监听同一端口，由内核分配新连接
+    if (reuse_port_ && setsockopt(server_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        std::cerr << "[TcpServer] Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+        close(server_fd_);
+        return false;
+    }
+
+    // 先在监听 socket 上试探内核忙轮询选项，被拒绝时只警告一次，接受的连接不再设置
+    socket_busy_poll_ = busy_poll_.enabled && (busy_poll_.socket_busy_poll_us > 0 || busy_poll_.prefer_busy_poll);
+    if (socket_busy_poll_ && !BusyPoller::apply_socket_options(server_fd_, busy_poll_)) {
+        std::cerr << "[TcpServer] Kernel busy polling unavailable, spinning only: " << strerror(errno) << std::endl;
+        socket_busy_poll_ = false;
+    }
+
+    // 设置服务器地址结构
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port_);
+
+    // 转换 IP 地址
+    if (inet_pton(AF_INET, ip_.c_str(), &server_addr.sin_addr) <= 0) {
+        std::cerr << "[TcpServer] Invalid IP address: " << ip_ << std::endl;
+        close(server_fd_);
+        return false;
+    }
+
+    // 绑定地址
+    if (bind(server_fd_, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) < 0) {
+        std::cerr << "[TcpServer] Failed to bind: " << strerror(errno) << std::endl;
+        close(server_fd_);
+        return false;
+    }
+
+    // 开始监听
+    if (listen(server_fd_, MAX_PENDING_CONNECTIONS) < 0) {
+        std::cerr << "[TcpServer] Failed to listen: " << strerror(errno) << std::endl;
+        close(server_fd_);
+        return false;
+    }
+
+    size_t loop_count = thread_pool_->size();
+
+    // 首次启动时映射缓冲区并完成预缺页
+    if (!arena_) {
+        BufferArena::Options options = arena_options_;
+        if (options.size == 0) {
+            options.size = SCRATCH_SIZE * loop_count + DEFAULT_POOL_BYTES;
+        }
+        arena_ = std::make_unique<BufferArena>(options);
+        scratch_pool_ = std::make_unique<BufferPool>(*arena_, SCRATCH_SIZE, loop_count);
+        size_t remaining = arena_->capacity() - arena_->used();
+        buffer_pool_ = std::make_unique<SizeClassPool>(*arena_, remaining / SizeClassPool::CLASS_COUNT);
+
+        // 预先创建并预缺页一批初始档位的输入环形缓冲区
+        ring_pool_ = std::make_unique<RingBufferPool>();
+        ring_pool_->prewarm(RecvSizePredictor::DEFAULT_INITIAL, DEFAULT_PREWARM_RINGS);
+
+        // fd 不会超过进程的文件描述符上限，登记表按上限分配
+        rlimit limit{};
+        size_t entries = 65536;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+            entries = static_cast<size_t>(limit.rlim_cur);
+        }
+        owner_capacity_ = std::min(entries, MAX_OWNER_ENTRIES);
+        owners_ = std::make_unique<std::atomic<uint64_t>[]>(owner_capacity_);
+        connection_stats_.init(owner_capacity_);
+    }
+
+    running_ = true;
+
+    // 上一次运行留下的事件循环在这里销毁，stop() 期间仍在投递的线程不会访问已释放的对象
+    for (IoLoop& io : loops_) {
+        discard_sends(io);
+    }
+    loops_.clear();
+
+    // 在线程池中启动事件循环
+    plan_placement(loop_count);
+    loops_.resize(loop_count);
+    for (size_t i = 0; i < loop_count; ++i) {
+        loops_[i].loop = std::make_unique<EventLoop>();
+        loops_[i].cpu = loop_cpus_.empty() ? -1 : loop_cpus_[i];
+        loops_[i].scratch = scratch_pool_->acquire();
+        loops_[i].send_queue = std::make_unique<MpscQueue<SendRequest>>();
+        loops_[i].loop->set_memory_budget(&budget_);
+        loops_[i].loop->set_event_handler([this, i](void* context, uint32_t events) {
+            this->handle_event(loops_[i], static_cast<Connection*>(context), events);
+        });
+        loops_[i].loop->set_wakeup_handler([this, i]() { drain_sends(loops_[i]); });
+        loops_[i].loop->set_ready_handler([this, i]() { return run_ready(loops_[i]); });
+        loops_[i].loop->set_busy_poll(busy_poll_);
+        if (timestamping_.rx || timestamping_.tx) {
+            loops_[i].latency = std::make_unique<WireLatency>();
+        }
+        if (tcp_info_options_.enabled) {
+            loops_[i].tcp_info = std::make_unique<TcpInfoHistograms>();
+            std::chrono::milliseconds tick = std::max(tcp_info_options_.interval / 4, std::chrono::milliseconds(10));
+            loops_[i].loop->set_timer_handler(tick, [this, i]() { sample_tcp_info(loops_[i]); });
+        }
+    }
+    for (IoLoop& io : loops_) {
+        EventLoop* loop = io.loop.get();
+        int cpu = io.cpu;
+        loop_futures_.push_back(thread_pool_->submit([this, loop, cpu]() {
+            if (cpu >= 0 && !CpuTopology::pin_current_thread(cpu)) {
+                std::cerr << "[TcpServer] Failed to pin event loop to CPU " << cpu << std::endl;
+            }
+            Realtime::configure_io_thread(realtime_);
+            loop->run();
+        }));
+    }
+
+    // 启动接受连接的线程
+    accept_thread_ = std::thread(&TcpServerBase::accept_loop, this);
+
+    {
+        std::lock_guard<std::mutex> lock(rebalance_mutex_);
+        utilization_.assign(loop_count, 0.0);
+    }
+    if (rebalance_options_.enabled && loop_count > 1) {
+        rebalance_thread_ = std::thread(&TcpServerBase::rebalance_loop, this);
+    }
+
+    std::cout << "[TcpServer] Server started on " << ip_ << ":" << port_ << std::endl;
+    return true;
+}
+
+/**
+ * @brief 停止服务器
+ */
+void TcpServerBase::stop() {
+    // 检查是否在运行
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    global_paused_ = false;
+
+    // 关闭服务器 socket，使 accept() 退出阻塞
+    if (server_fd_ >= 0) {
+        shutdown(server_fd_, SHUT_RDWR);
+        close(server_fd_);
+        server_fd_ = -1;
+    }
+
+    // 等待接受线程结束
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+
+    // 等待再均衡线程结束
+    {
+        std::lock_guard<std::mutex> lock(rebalance_mutex_);
+    }
+    rebalance_cv_.notify_all();
+    if (rebalance_thread_.joinable()) {
+        rebalance_thread_.join();
+    }
+
+    // 停止所有事件循环并等待其退出
+    for (IoLoop& io : loops_) {
+        io.loop->stop();
+    }
+    for (std::future<void>& future : loop_futures_) {
+        future.wait();
+    }
+
+    // 关闭所有客户端连接
+    std::vector<int> closed_fds;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        for (auto& [fd, conn] : clients_) {
+            set_owner(fd, 0, 0);
+            connection_stats_.close(fd);
+            release_input(&conn, true);
+            release_buffer(conn.output, true);
+            release_buffer(conn.urgent, true);
+            shutdown(fd, SHUT_RDWR);
+            close(fd);
+            closed_fds.push_back(fd);
+        }
+        clients_.clear();
+        paused_connections_ = 0;
+    }
+
+    // 触发断开连接回调
+    for (int fd : closed_fds) {
+        on_disconnect(fd);
+    }
+
+    // 事件循环对象保留到下一次 start() 或析构，只归还临时缓冲区和未发送的请求
+    for (IoLoop& io : loops_) {
+        discard_sends(io);
+        io.ready.clear();
+        io.ready_turn.clear();
+        io.members.clear();
+        scratch_pool_->release(io.scratch);
+        io.scratch = nullptr;
+    }
+    loop_futures_.clear();
+
+    std::cout << "[TcpServer] Server stopped" << std::endl;
+}
+
+/**
+ * @brief 接受客户端连接的循环
+ *
+ * @details
+ * 在独立线程中持续运行，接受新的客户端连接。
+ * 每个新连接被设为非阻塞，并按放置策略分配给一个事件循环。
+ */
+void TcpServerBase::accept_loop() {
+    while (running_) {
+        sockaddr_in client_addr{};
+        socklen_t addr_len = sizeof(client_addr);
+
+        // 接受新连接（直接设为非阻塞）
+        int client_fd = accept4(server_fd_, reinterpret_cast<sockaddr*>(&client_addr), &addr_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (client_fd < 0) {
+            if (running_) {
+                std::cerr << "[TcpServer] Accept failed: " << strerror(errno) << std::endl;
+            }
+            continue;
+        }
+
+        if (socket_busy_poll_) {
+            BusyPoller::apply_socket_options(client_fd, busy_poll_);
+        }
+
+        // 必须先于任何收发开启，发送时间戳的编号才从该连接的第一个字节起算
+        bool stamped = false;
+        if (timestamping_.rx || timestamping_.tx) {
+            stamped = Timestamping::enable(client_fd, timestamping_);
+            if (!stamped && !timestamping_warned_.exchange(true)) {
+                std::cerr << "[TcpServer] SO_TIMESTAMPING unavailable, connections are not timestamped: "
+                          << strerror(errno) << std::endl;
+            }
+        }
+
+        uint32_t loop_index = select_loop(client_fd);
+
+        // 添加到客户端列表
+        Connection* conn = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            conn = &clients_.try_emplace(client_fd).first->second;
+            conn->fd = client_fd;
+            conn->loop_index = loop_index;
+            conn->generation = next_generation_++;
+            if (next_generation_ == 0) {
+                next_generation_ = 1;
+            }
+            conn->ip = client_addr.sin_addr.s_addr;
+            conn->port = ntohs(client_addr.sin_port);
+            if (stamped && timestamping_.tx) {
+                conn->tx_stamps = std::make_unique<TxStamps>();
+            }
+            if (tcp_info_options_.enabled) {
+                conn->tcp_info = std::make_unique<TcpInfoSample>();
+            }
+            connection_stats_.open(client_fd, conn->ip, conn->port, loop_index, Clock::now_ns());
+
+            // Eager 模式下连接一建立就持有缓冲块
+            if (buffer_mode_ == BufferMode::Eager) {
+                acquire_input(conn, conn->predictor.next_size());
+                reserve_buffer(conn->output, SizeClassPool::MIN_CLASS_SIZE);
+            }
+        }
+
+        std::string client_addr_str = format_address(conn->ip, conn->port);
+        std::cout << "[TcpServer] Client connected: " << client_addr_str << " (fd=" << client_fd << ")" << std::endl;
+
+        // 触发连接回调（先于任何消息回调）
+        on_connect(client_fd, client_addr_str);
+
+        // 注册到事件循环；连接回调中排队的数据需要同时关注可写事件。
+        // 注册之后其他线程的发送才交给事件循环，登记与迁移都在锁内进行
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            loops_[loop_index].loop->add(client_fd, interest_events(*conn), conn);
+            set_owner(client_fd, loop_index + 1, conn->generation);
+            conn->registered = true;
+            add_member(loops_[loop_index], *conn);
+        }
+    }
+}
+
+/**
+ * @brief 为新连接选择事件循环
+ * @param client_fd 客户端文件描述符
+ * @return 事件循环下标
+ */
+uint32_t TcpServerBase::select_loop(int client_fd) {
+    if (placement_ == Placement::IncomingCpu) {
+        int cpu = -1;
+        socklen_t length = sizeof(cpu);
+        if (getsockopt(client_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &length) == 0
+            && cpu >= 0 && static_cast<size_t>(cpu) < cpu_loops_.size() && cpu_loops_[cpu] >= 0) {
+            uint32_t loop_index = static_cast<uint32_t>(cpu_loops_[cpu]);
+            if (loops_[loop_index].cpu == cpu) {
+                ++placed_same_cpu_;
+            } else {
+                ++placed_same_node_;
+            }
+            return loop_index;
+        }
+        ++placed_fallback_;
+    }
+    return static_cast<uint32_t>(next_loop_++ % loops_.size());
+}
+
+/**
+ * @brief 计算各事件循环绑定的 CPU 和 CPU -> 事件循环表
+ * @param loop_count 事件循环数量
+ *
+ * @details
+ * 事件循环均匀分布在允许运行的 CPU 上（CPU 编号通常按节点连续，因此也均匀分布在各节点上）。
+ * 每个 CPU 对应绑定在它上面的循环；没有时对应同一节点上编号最近的 CPU 上的循环，
+ * 相邻编号的核心通常共享更多的缓存层级。
+ */
+void TcpServerBase::plan_placement(size_t loop_count) {
+    loop_cpus_.clear();
+    cpu_loops_.clear();
+    if (placement_ != Placement::IncomingCpu) {
+        return;
+    }
+
+    CpuTopology topology;
+    const std::vector<int>& cpus = topology.cpus();
+    for (size_t i = 0; i < loop_count; ++i) {
+        size_t slot = loop_count <= cpus.size() ? i * cpus.size() / loop_count : i % cpus.size();
+        loop_cpus_.push_back(cpus[slot]);
+    }
+
+    cpu_loops_.assign(static_cast<size_t>(topology.cpu_limit()), -1);
+    for (int cpu = 0; cpu < topology.cpu_limit(); ++cpu) {
+        int best = -1;
+        int best_distance = 0;
+        for (size_t i = 0; i < loop_count; ++i) {
+            int loop_cpu = loop_cpus_[i];
+            if (topology.node_of(loop_cpu) != topology.node_of(cpu)) {
+                continue;
+            }
+            int distance = loop_cpu > cpu ? loop_cpu - cpu : cpu - loop_cpu;
+            if (best < 0 || distance < best_distance) {
+                best = static_cast<int>(i);
+                best_distance = distance;
+            }
+        }
+        cpu_loops_[cpu] = best;
+    }
+}
+
+/**
+ * @brief 处理连接上的就绪事件
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ * @param events epoll 事件掩码
+ */
+void TcpServerBase::handle_event(IoLoop& io, Connection* conn, uint32_t events) {
+    // 发送时间戳通过错误队列到达并触发 EPOLLERR，读走后只有 socket 没有待处理错误时才不当作连接错误。
+    // SO_ERROR 读取即清除，之后的读取看不到该错误，因此有错误时在这里直接关闭
+    if ((events & EPOLLERR) && conn->tx_stamps && drain_tx_timestamps(io, conn)) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+            events &= ~static_cast<uint32_t>(EPOLLERR);
+        } else {
+            if (running_) {
+                std::cerr << "[TcpServer] Socket error from " << format_address(conn->ip, conn->port)
+                          << ": " << strerror(error != 0 ? error : errno) << std::endl;
+            }
+            close_client(io, conn);
+            return;
+        }
+    }
+
+    // 已在就绪列表中的方向由 run_ready() 继续，新的边缘通知不额外加一轮
+    if ((events & EPOLLOUT) && !(conn->ready & READY_WRITE)) {
+        if (!handle_write(io, conn)) {
+            close_client(io, conn);
+            return;
+        }
+    }
+
+    if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && !(conn->ready & READY_READ)) {
+        // 暂停读取期间只处理对端关闭和错误
+        if (conn->pause_reasons.load(std::memory_order_relaxed) != 0
+            && !(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+            return;
+        }
+        bool alive = handle_read(io, conn);
+        end_dispatch(conn);
+        if (!alive) {
+            close_client(io, conn);
+        }
+    }
+}
+
+/**
+ * @brief 把读到的数据交给派生类
+ * @param conn 客户端连接
+ * @param data 数据起始地址
+ * @param length 数据长度
+ * @param consumed 输出已处理的字节数
+ * @return 数据是否合法
+ */
+bool TcpServerBase::dispatch(Connection* conn, const char* data, size_t length, size_t& consumed) {
+    consumed = 0;
+    if (!on_data(conn->fd, data, length, consumed)) {
+        std::cerr << "[TcpServer] Invalid data from " << format_address(conn->ip, conn->port) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取连接上的所有可读数据并记入连接统计
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ * @return 连接是否仍然有效
+ *
+ * @details 本次读到的字节数和分发的消息数由两项配额的消耗量得出，每次就绪读取只更新一次统计
+ */
+bool TcpServerBase::handle_read(IoLoop& io, Connection* conn) {
+    size_t read_budget = fairness_.read_bytes != 0 ? fairness_.read_bytes : SIZE_MAX;
+    size_t message_budget = fairness_.read_messages != 0 ? fairness_.read_messages : SIZE_MAX;
+    size_t read_left = read_budget;
+    message_quota_ = message_budget;
+
+    bool alive = read_available(io, conn, read_left);
+    connection_stats_.record_input(conn->fd, read_budget - read_left, message_budget - message_quota_,
+                                   Clock::cached_ns());
+    return alive;
+}
+
+/**
+ * @brief 读取连接上的所有可读数据
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ * @param read_left 剩余的字节配额，读取后更新
+ * @return 连接是否仍然有效
+ *
+ * @details
+ * 边缘触发模式下需要一直读到 EAGAIN。每次用 readv 同时填充
+ * 输入环形缓冲区的可写区域和事件循环的临时缓冲区（溢出部分）：
+ * - 环形缓冲区的可读区域总是连续的，分帧函数直接看到完整消息，无需 memmove
+ * - Eager 模式下连接始终持有环形缓冲区，为空时按预测大小换档
+ * - Lazy 模式下只有剩下半包时才按预测大小借用环形缓冲区，读空后立即归还
+ *
+ * 每轮的读取字节数和分发消息数受 FairnessBudget 限制：readv 的总长度不超过剩余字节配额，
+ * 配额用完时连接记入就绪列表，下一轮先交付上一轮留在环形缓冲区中的完整消息再继续读取。
+ */
+bool TcpServerBase::read_available(IoLoop& io, Connection* conn, size_t& read_left) {
+    // 上一轮因消息配额留下的完整消息先于新数据交付
+    if (conn->input && conn->input->size() > 0 && fairness_.read_messages != 0) {
+        MagicRingBuffer* input = conn->input;
+        size_t consumed = 0;
+        if (!dispatch(conn, input->read_ptr(), input->size(), consumed)) {
+            return false;
+        }
+        input->consume(consumed);
+        end_dispatch(conn);
+        if (input->size() == 0) {
+            release_input(conn, false);
+        }
+    }
+
+    while (true) {
+        if (read_left == 0 || message_quota_ == 0) {
+            defer_ready(io, conn, READY_READ);
+            break;
+        }
+
+        // 全局预算超限时按策略暂停读取或断开最大的连接
+        if (!check_input_budget(io, conn)) {
+            return true;
+        }
+
+        size_t predicted = conn->predictor.next_size();
+
+        if (buffer_mode_ == BufferMode::Eager) {
+            // 环形缓冲区为空且档位与预测不符时换档
+            if (conn->input && conn->input->size() == 0
+                && conn->input->capacity() != RingBufferPool::class_size(predicted)) {
+                release_input(conn, true);
+            }
+            if (!conn->input && !acquire_input(conn, predicted)) {
+                return false;
+            }
+        }
+
+        MagicRingBuffer* input = conn->input;
+        size_t ring_room = input ? std::min(input->writable(), read_left) : 0;
+
+        iovec iov[2];
+        int iov_count = 0;
+        if (ring_room > 0) {
+            iov[iov_count].iov_base = input->write_ptr();
+            iov[iov_count].iov_len = ring_room;
+            ++iov_count;
+        }
+        size_t scratch_room = std::min<size_t>(SCRATCH_SIZE, read_left - ring_room);
+        if (scratch_room > 0) {
+            iov[iov_count].iov_base = io.scratch;
+            iov[iov_count].iov_len = scratch_room;
+            ++iov_count;
+        }
+        // 被配额截短且读满的一次读取不代表对端的发送量，不计入预测
+        size_t requested = ring_room + scratch_room;
+        bool capped = requested < (input ? input->writable() : 0) + SCRATCH_SIZE;
+
+        // 接收数据（等同于 readv；开启接收时间戳时带上控制信息缓冲区）
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(iov_count);
+        alignas(cmsghdr) char control[Timestamping::CONTROL_SIZE];
+        if (timestamping_.rx) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+        }
+        ssize_t bytes_read = recvmsg(conn->fd, &msg, 0);
+
+        if (bytes_read == 0) {
+            // 客户端正常断开
+            std::cout << "[TcpServer] Client disconnected: " << format_address(conn->ip, conn->port) << std::endl;
+            return false;
+        }
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (running_) {
+                // 接收错误
+                std::cerr << "[TcpServer] Recv error from " << format_address(conn->ip, conn->port)
+                          << ": " << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+
+        if (!capped || static_cast<size_t>(bytes_read) < requested) {
+            conn->predictor.record(static_cast<size_t>(bytes_read));
+        }
+        conn->activity += static_cast<uint64_t>(bytes_read);
+        read_left -= static_cast<size_t>(bytes_read);
+
+        uint64_t read_ticks = 0;
+        if (timestamping_.rx) {
+            current_rx_timestamp_ = Timestamping::rx_timestamp(msg);
+            if (current_rx_timestamp_ != 0) {
+                int64_t queued_ns = Timestamping::realtime_ns() - current_rx_timestamp_;
+                if (Timestamping::plausible(queued_ns)) {
+                    io.latency->rx_queue.record(static_cast<uint64_t>(queued_ns));
+                }
+                read_ticks = Clock::ticks();
+            }
+        }
+
+        size_t in_ring = std::min(static_cast<size_t>(bytes_read), ring_room);
+        size_t in_scratch = static_cast<size_t>(bytes_read) - in_ring;
+
+        if (input) {
+            // 先切分环形缓冲区中的数据
+            input->commit(in_ring);
+            size_t consumed = 0;
+            if (!dispatch(conn, input->read_ptr(), input->size(), consumed)) {
+                return false;
+            }
+            input->consume(consumed);
+
+            // 仍有半包时，溢出到临时缓冲区的数据也追加进环形缓冲区
+            if (in_scratch > 0 && input->size() > 0) {
+                end_dispatch(conn);     // 追加可能覆盖或换掉环形缓冲区
+                if (!append_input(conn, io.scratch, in_scratch)) {
+                    return false;
+                }
+                input = conn->input;
+                if (!dispatch(conn, input->read_ptr(), input->size(), consumed)) {
+                    return false;
+                }
+                input->consume(consumed);
+                in_scratch = 0;
+            }
+        }
+
+        if (in_scratch > 0) {
+            // 直接在临时缓冲区中切分，只把剩余半包放入环形缓冲区
+            size_t consumed = 0;
+            if (!dispatch(conn, io.scratch, in_scratch, consumed)) {
+                return false;
+            }
+            size_t remaining = in_scratch - consumed;
+            if (remaining > 0) {
+                end_dispatch(conn);
+                if (!append_input(conn, io.scratch + consumed, remaining)) {
+                    return false;
+                }
+            }
+        }
+
+        // 批量分发时，本轮切出的消息必须在缓冲区被归还或覆盖之前交付
+        end_dispatch(conn);
+        if (read_ticks != 0) {
+            io.latency->rx_dispatch.record(static_cast<uint64_t>(Clock::elapsed_ns(read_ticks)));
+        }
+
+        if (conn->input && conn->input->size() == 0) {
+            release_input(conn, false);
+        }
+
+        if (conn->input && limits_.connection_input_bytes != 0
+            && conn->input->size() > limits_.connection_input_bytes) {
+            std::cerr << "[TcpServer] Frame too large from " << format_address(conn->ip, conn->port) << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 继续发送输出缓冲区中的数据
+ * @param conn 客户端连接
+ * @return 连接是否仍然有效
+ *
+ * @details
+ * 位于帧边界时先写紧急数据；否则用一次 writev 写出若干普通帧（跳过长度头）。
+ * 有紧急数据等待时只写完当前帧，随后回到帧边界让紧急数据插队。
+ *
+ * 每轮写出的字节数和写完的普通消息数受 FairnessBudget 限制：最后一个 iovec 按剩余字节配额截短
+ * （帧可以分多轮写完），配额用完而数据未写完时连接记入就绪列表。
+ */
+bool TcpServerBase::handle_write(IoLoop& io, Connection* conn) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    Buffer& output = conn->output;
+    Buffer& urgent = conn->urgent;
+    size_t write_budget = fairness_.write_bytes != 0 ? fairness_.write_bytes : SIZE_MAX;
+    size_t write_left = write_budget;
+    size_t frames_left = fairness_.write_messages != 0 ? fairness_.write_messages : SIZE_MAX;
+
+    while (true) {
+        // 积压写完后补发合并广播中每个键的最新值
+        if (output.size() == 0 && urgent.size() == 0 && !flush_conflated(*conn)) {
+            break;
+        }
+
+        bool write_urgent = urgent.size() > 0 && output.frame_left == 0;
+        if (write_left == 0 || (frames_left == 0 && !write_urgent)) {
+            defer_ready(io, conn, READY_WRITE);
+            publish_output(*conn, write_budget - write_left, 0);
+            return true;
+        }
+
+        ssize_t bytes_sent;
+        size_t frames = 0;
+        int64_t sent_ns = send_started(*conn);
+        if (write_urgent) {
+            bytes_sent = ::send(conn->fd, urgent.data + urgent.begin, std::min(urgent.size(), write_left), MSG_NOSIGNAL);
+        } else {
+            iovec iov[MAX_SEND_BATCH];
+            uint64_t expired_messages = 0;
+            uint64_t expired_bytes = 0;
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = output.gather_frames(iov, std::min(urgent.size() > 0 ? 1 : MAX_SEND_BATCH, frames_left),
+                                                  expired_messages, expired_bytes);
+            if (expired_messages > 0) {
+                conn->expired += expired_messages;
+                expired_messages_ += expired_messages;
+                expired_bytes_ += expired_bytes;
+            }
+            if (msg.msg_iovlen == 0) {
+                // 只丢弃了过期帧
+                continue;
+            }
+
+            // 每个 iovec 是一帧的剩余部分，完整写出的 iovec 即写完的消息；截短的最后一帧不计
+            size_t total = 0;
+            size_t whole = msg.msg_iovlen;
+            for (size_t i = 0; i < msg.msg_iovlen; ++i) {
+                if (iov[i].iov_len > write_left - total) {
+                    iov[i].iov_len = write_left - total;
+                    msg.msg_iovlen = i + 1;
+                    whole = i;
+                    break;
+                }
+                total += iov[i].iov_len;
+            }
+            bytes_sent = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+
+            size_t written = bytes_sent > 0 ? static_cast<size_t>(bytes_sent) : 0;
+            for (size_t i = 0; i < whole && written >= iov[i].iov_len; ++i) {
+                written -= iov[i].iov_len;
+                ++frames;
+            }
+        }
+        note_sent(*conn, bytes_sent, sent_ns);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            bool would_block = errno == EAGAIN || errno == EWOULDBLOCK;
+            publish_output(*conn, write_budget - write_left, 0);
+            return would_block;
+        }
+        conn->activity += static_cast<uint64_t>(bytes_sent);
+        write_left -= static_cast<size_t>(bytes_sent);
+        frames_left -= std::min(frames, frames_left);
+        if (write_urgent) {
+            urgent.begin += static_cast<uint32_t>(bytes_sent);
+        } else {
+            output.consume_frames(static_cast<size_t>(bytes_sent));
+        }
+
+        // 待发送数据回落到上限的一半以下时恢复读取
+        if ((conn->pause_reasons.load(std::memory_order_relaxed) & PAUSE_OUTPUT)
+            && output.size() + urgent.size() <= limits_.connection_output_bytes / 2) {
+            resume_reads(*conn, PAUSE_OUTPUT);
+        }
+    }
+
+    // 发送完毕，归还缓冲区并取消关注可写事件；紧急数据很少积压，缓冲块总是归还
+    release_buffer(output, false);
+    release_buffer(urgent, true);
+    if (conn->pause_reasons.load(std::memory_order_relaxed) & PAUSE_OUTPUT) {
+        resume_reads(*conn, PAUSE_OUTPUT);
+    }
+    update_interest(*conn);
+    publish_output(*conn, write_budget - write_left, 0);
+    return true;
+}
+
+/**
+ * @brief 记下一次写入，等待内核的发送时间戳
+ * @param conn 客户端连接
+ * @param bytes 写入的字节数
+ * @param sent_ns 写入调用前的时刻
+ */
+void TcpServerBase::note_sent(Connection& conn, ssize_t bytes, int64_t sent_ns) {
+    TxStamps* stamps = conn.tx_stamps.get();
+    if (!stamps || bytes <= 0) {
+        return;
+    }
+    stamps->offset += static_cast<uint32_t>(bytes);
+    if (stamps->tail - stamps->head == TxStamps::CAPACITY) {
+        ++stamps->head;
+    }
+    stamps->entries[stamps->tail % TxStamps::CAPACITY] = TxStamps::Entry{stamps->offset - 1, sent_ns};
+    ++stamps->tail;
+}
+
+/**
+ * @brief 读取错误队列中的发送时间戳并记录 tx_queue
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ * @return 是否读到了发送时间戳
+ *
+ * @details
+ * 时间戳按偏移递增到达。编号之前的记录所在的数据包被后续写入合并，不会再有时间戳，直接丢弃；
+ * 编号早于所有记录（记录已被覆盖）或延迟不合理时计入 tx_unmatched。
+ * 系统调用在锁外进行，每批时间戳只加一次锁。
+ */
+bool TcpServerBase::drain_tx_timestamps(IoLoop& io, Connection* conn) {
+    TxTimestamp stamps[Timestamping::TX_BATCH];
+    bool found = false;
+    bool more = true;
+    while (more) {
+        size_t count = Timestamping::read_tx(conn->fd, stamps, Timestamping::TX_BATCH, more);
+        if (count == 0) {
+            continue;
+        }
+        found = true;
+
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        TxStamps& pending = *conn->tx_stamps;
+        for (size_t i = 0; i < count; ++i) {
+            bool matched = false;
+            while (pending.head != pending.tail) {
+                const TxStamps::Entry& entry = pending.entries[pending.head % TxStamps::CAPACITY];
+                int32_t distance = static_cast<int32_t>(entry.last_byte - stamps[i].id);
+                if (distance > 0) {
+                    break;
+                }
+                ++pending.head;
+                if (distance == 0) {
+                    int64_t delay_ns = stamps[i].ns - entry.sent_ns;
+                    if (Timestamping::plausible(delay_ns)) {
+                        io.latency->tx_queue.record(static_cast<uint64_t>(delay_ns));
+                        matched = true;
+                    }
+                    break;
+                }
+            }
+            if (!matched) {
+                io.latency->tx_unmatched.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief 把连接加入事件循环的成员列表
+ * @param io 事件循环
+ * @param conn 客户端连接
+ */
+void TcpServerBase::add_member(IoLoop& io, Connection& conn) {
+    conn.member_index = static_cast<uint32_t>(io.members.size());
+    io.members.push_back(&conn);
+}
+
+/**
+ * @brief 把连接移出事件循环的成员列表
+ * @param io 事件循环
+ * @param conn 客户端连接
+ *
+ * @details 与末尾元素交换后删除；不在列表中的连接（如尚未注册）忽略
+ */
+void TcpServerBase::remove_member(IoLoop& io, Connection& conn) {
+    size_t index = conn.member_index;
+    if (index >= io.members.size() || io.members[index] != &conn) {
+        return;
+    }
+    Connection* last = io.members.back();
+    io.members[index] = last;
+    last->member_index = static_cast<uint32_t>(index);
+    io.members.pop_back();
+}
+
+/**
+ * @brief 采样本循环中到期连接的 TCP_INFO
+ * @param io 所属事件循环
+ *
+ * @details
+ * 第一次加锁从轮转位置起挑出到期的连接（最多检查 4 * max_per_tick 个，连接很多时每次只扫描一段），
+ * getsockopt 在锁外进行，第二次加锁写回采样并记入直方图。锁外期间连接可能被其他线程开始迁移，
+ * 但只有所属事件循环会关闭并释放它，写回前按 fd 确认它仍在表中。
+ */
+void TcpServerBase::sample_tcp_info(IoLoop& io) {
+    int64_t now_ns = Clock::cached_ns();
+    int64_t interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tcp_info_options_.interval).count();
+    size_t limit = std::max<size_t>(tcp_info_options_.max_per_tick, 1);
+
+    io.sampling.clear();
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        size_t count = io.members.size();
+        size_t scan = std::min(count, limit * 4);
+        for (size_t i = 0; i < scan && io.sampling.size() < limit; ++i) {
+            if (io.sample_cursor >= count) {
+                io.sample_cursor = 0;
+            }
+            Connection* conn = io.members[io.sample_cursor++];
+            if (conn->closing || !conn->tcp_info || now_ns - conn->tcp_info->sampled_ns < interval_ns) {
+                continue;
+            }
+            io.sampling.push_back(TcpInfoJob{conn, conn->fd, *conn->tcp_info});
+        }
+    }
+    if (io.sampling.empty()) {
+        return;
+    }
+
+    size_t kept = 0;
+    for (TcpInfoJob& job : io.sampling) {
+        if (TcpInfoSampler::sample(job.fd, job.sample, now_ns)) {
+            io.sampling[kept++] = job;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (size_t i = 0; i < kept; ++i) {
+        const TcpInfoJob& job = io.sampling[i];
+        auto it = clients_.find(job.fd);
+        if (it == clients_.end() || &it->second != job.conn || !it->second.tcp_info) {
+            continue;
+        }
+        *it->second.tcp_info = job.sample;
+        io.tcp_info->record(job.sample);
+    }
+}
+
+/**
+ * @brief 关闭指定客户端连接
+ * @param io 所属事件循环
+ * @param conn 要关闭的客户端连接
+ */
+void TcpServerBase::close_client(IoLoop& io, Connection* conn) {
+    int client_fd = conn->fd;
+    io.loop->remove(client_fd);
+    set_owner(client_fd, 0, 0);
+    unlink_ready(io, conn);
+
+    // 从客户端列表移除
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        if (conn->pause_reasons.load(std::memory_order_relaxed) != 0) {
+            --paused_connections_;
+        }
+        release_input(conn, true);
+        release_buffer(conn->output, true);
+        release_buffer(conn->urgent, true);
+        remove_member(io, *conn);
+        connection_stats_.close(client_fd);
+        clients_.erase(client_fd);
+    }
+
+    // 关闭 socket
+    shutdown(client_fd, SHUT_RDWR);
+    close(client_fd);
+
+    // 触发断开连接回调
+    on_disconnect(client_fd);
+}
+
+/**
+ * @brief 把配额用完的连接记入就绪列表
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ * @param direction 等待继续的读写方向
+ */
+void TcpServerBase::defer_ready(IoLoop& io, Connection* conn, uint8_t direction) {
+    if (conn->ready == 0) {
+        io.ready.push_back(conn);
+    }
+    conn->ready |= direction;
+    ++deferred_turns_;
+}
+
+/**
+ * @brief 把连接移出就绪列表
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ *
+ * @details 连接可能在下一轮的列表中，也可能在本轮尚未处理到的列表中（置空跳过）；
+ *          就绪方向保留在连接上，迁出的连接由目标事件循环接管时重新记入
+ */
+void TcpServerBase::unlink_ready(IoLoop& io, Connection* conn) {
+    if (conn->ready == 0) {
+        return;
+    }
+    auto it = std::find(io.ready.begin(), io.ready.end(), conn);
+    if (it != io.ready.end()) {
+        io.ready.erase(it);
+    }
+    std::replace(io.ready_turn.begin(), io.ready_turn.end(), conn, static_cast<Connection*>(nullptr));
+}
+
+/**
+ * @brief 继续读写上一轮让出的连接
+ * @param io 所属事件循环
+ * @return 是否仍有连接在就绪列表中
+ *
+ * @details 先换出整个列表再处理，本轮再次用完配额的连接排到下一轮，
+ *          每个连接每轮最多处理一次
+ */
+bool TcpServerBase::run_ready(IoLoop& io) {
+    if (io.ready.empty()) {
+        return false;
+    }
+
+    io.ready_turn.swap(io.ready);
+    for (size_t i = 0; i < io.ready_turn.size(); ++i) {
+        Connection* conn = io.ready_turn[i];
+        if (!conn) {
+            continue;
+        }
+        uint32_t events = 0;
+        if (conn->ready & READY_WRITE) {
+            events |= EPOLLOUT;
+        }
+        if (conn->ready & READY_READ) {
+            events |= EPOLLIN;
+        }
+        conn->ready = 0;
+        handle_event(io, conn, events);
+    }
+    io.ready_turn.clear();
+    return !io.ready.empty();
+}
+
+/**
+ * @brief 为连接借用输入环形缓冲区
+ * @param conn 客户端连接
+ * @param size 需要的容量
+ * @return 是否借用成功
+ */
+bool TcpServerBase::acquire_input(Connection* conn, size_t size) {
+    MagicRingBuffer* ring = ring_pool_->acquire(size);
+    if (!ring) {
+        std::cerr << "[TcpServer] Failed to allocate input buffer for " << format_address(conn->ip, conn->port) << std::endl;
+        return false;
+    }
+    conn->input = ring;
+    conn->input_bytes.store(static_cast<uint32_t>(ring->capacity()), std::memory_order_relaxed);
+    budget_.charge(MemoryBudget::Category::Input, ring->capacity());
+    return true;
+}
+
+/**
+ * @brief 向连接的输入环形缓冲区追加数据
+ * @param conn 客户端连接
+ * @param data 数据起始地址
+ * @param length 数据长度
+ * @return 是否追加成功
+ *
+ * @details 空间不足时换用更大档位的环形缓冲区（只拷贝一次已有的半包）
+ */
+bool TcpServerBase::append_input(Connection* conn, const char* data, size_t length) {
+    MagicRingBuffer* input = conn->input;
+
+    if (!input) {
+        if (!acquire_input(conn, std::max(length, conn->predictor.next_size()))) {
+            return false;
+        }
+    } else if (input->writable() < length) {
+        MagicRingBuffer* larger = ring_pool_->acquire(input->size() + length);
+        if (!larger) {
+            std::cerr << "[TcpServer] Failed to grow input buffer for " << format_address(conn->ip, conn->port) << std::endl;
+            return false;
+        }
+        larger->append(input->read_ptr(), input->size());
+        release_input(conn, true);
+        conn->input = larger;
+        conn->input_bytes.store(static_cast<uint32_t>(larger->capacity()), std::memory_order_relaxed);
+        budget_.charge(MemoryBudget::Category::Input, larger->capacity());
+    }
+
+    return conn->input->append(data, length);
+}
+
+/**
+ * @brief 归还连接的输入环形缓冲区
+ * @param conn 客户端连接
+ * @param force 是否强制归还（Eager 模式下非强制时保留）
+ */
+void TcpServerBase::release_input(Connection* conn, bool force) {
+    if (!conn->input || (!force && buffer_mode_ == BufferMode::Eager)) {
+        return;
+    }
+
+    budget_.release(MemoryBudget::Category::Input, conn->input->capacity());
+    ring_pool_->release(conn->input);
+    conn->input = nullptr;
+    conn->input_bytes.store(0, std::memory_order_relaxed);
+    on_memory_released();
+}
+
+/**
+ * @brief 向缓冲区追加数据
+ * @param buffer 目标缓冲区
+ * @param data 数据起始地址
+ * @param length 数据长度
+ */
+void TcpServerBase::append_buffer(Buffer& buffer, const char* data, size_t length) {
+    reserve_buffer(buffer, length);
+    memcpy(buffer.data + buffer.end, data, length);
+    buffer.end += static_cast<uint32_t>(length);
+}
+
+/**
+ * @brief 向缓冲区追加一帧
+ * @param buffer 目标缓冲区
+ * @param data 帧数据起始地址
+ * @param length 帧数据长度
+ * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+ */
+void TcpServerBase::append_frame(Buffer& buffer, const char* data, size_t length, int64_t expiry_ns) {
+    size_t header_size = FRAME_HEADER_SIZE + (expiry_ns != 0 ? FRAME_EXPIRY_SIZE : 0);
+    reserve_buffer(buffer, header_size + length);
+
+    char* position = buffer.data + buffer.end;
+    uint32_t header = static_cast<uint32_t>(length) | (expiry_ns != 0 ? FRAME_EXPIRY_FLAG : 0);
+    memcpy(position, &header, FRAME_HEADER_SIZE);
+    if (expiry_ns != 0) {
+        memcpy(position + FRAME_HEADER_SIZE, &expiry_ns, FRAME_EXPIRY_SIZE);
+    }
+    memcpy(position + header_size, data, length);
+    buffer.end += static_cast<uint32_t>(header_size + length);
+}
+
+/**
+ * @brief 从 begin 起收集帧数据
+ * @param iov 输出的 iovec 数组
+ * @param max_frames 最多收集的帧数
+ * @param expired_messages 累加丢弃的过期帧数
+ * @param expired_bytes 累加丢弃的字节数
+ * @return 填充的 iovec 数量
+ *
+ * @details 当前时刻只在遇到第一个带过期时间的帧时取一次（事件循环线程中为本轮缓存的时刻）
+ */
+size_t TcpServerBase::Buffer::gather_frames(iovec* iov, size_t max_frames,
+                                            uint64_t& expired_messages, uint64_t& expired_bytes) {
+    size_t count = 0;
+    uint32_t position = begin;
+    uint32_t left = frame_left;
+    int64_t now_ns = 0;
+    while (count < max_frames && position < end) {
+        if (left == 0) {
+            uint32_t header;
+            memcpy(&header, data + position, FRAME_HEADER_SIZE);
+            uint32_t header_size = FRAME_HEADER_SIZE;
+            left = header & ~FRAME_EXPIRY_FLAG;
+
+            if (header & FRAME_EXPIRY_FLAG) {
+                int64_t expiry_ns;
+                memcpy(&expiry_ns, data + position + FRAME_HEADER_SIZE, FRAME_EXPIRY_SIZE);
+                header_size += FRAME_EXPIRY_SIZE;
+                if (now_ns == 0) {
+                    now_ns = Clock::cached_ns();
+                }
+                if (expiry_ns <= now_ns) {
+                    if (count > 0) {
+                        // 先写出前面的帧，下一次写入时它位于开头再丢弃
+                        break;
+                    }
+                    position += header_size + left;
+                    begin = position;
+                    left = 0;
+                    ++expired_messages;
+                    expired_bytes += header & ~FRAME_EXPIRY_FLAG;
+                    continue;
+                }
+            }
+            position += header_size;
+        }
+        iov[count].iov_base = data + position;
+        iov[count].iov_len = left;
+        ++count;
+        position += left;
+        left = 0;
+    }
+    return count;
+}
+
+/**
+ * @brief 消费已写出的帧数据
+ * @param length 已写出的字节数（不含长度头）
+ *
+ * @details 写完一帧时停在下一帧的长度头之前，frame_left 为 0 表示正位于帧边界
+ */
+void TcpServerBase::Buffer::consume_frames(size_t length) {
+    while (length > 0) {
+        if (frame_left == 0) {
+            uint32_t header;
+            memcpy(&header, data + begin, FRAME_HEADER_SIZE);
+            begin += FRAME_HEADER_SIZE + ((header & FRAME_EXPIRY_FLAG) ? FRAME_EXPIRY_SIZE : 0);
+            frame_left = header & ~FRAME_EXPIRY_FLAG;
+        }
+        uint32_t step = static_cast<uint32_t>(std::min<size_t>(length, frame_left));
+        begin += step;
+        frame_left -= step;
+        length -= step;
+    }
+}
+
+/**
+ * @brief 保证缓冲区尾部有足够的空闲空间
+ * @param buffer 目标缓冲区
+ * @param length 需要的空闲字节数
+ *
+ * @details
+ * 依次尝试：借用缓冲块 -> 把有效数据移到头部 -> 换用更大档位的缓冲块
+ */
+void TcpServerBase::reserve_buffer(Buffer& buffer, size_t length) {
+    if (!buffer.data) {
+        size_t capacity = 0;
+        buffer.data = buffer_pool_->acquire(length, capacity);
+        buffer.capacity = static_cast<uint32_t>(capacity);
+        buffer.begin = buffer.end = 0;
+        budget_.charge(MemoryBudget::Category::Output, buffer.capacity);
+        return;
+    }
+
+    if (buffer.capacity - buffer.end >= length) {
+        return;
+    }
+
+    size_t size = buffer.size();
+    if (buffer.capacity - size >= length) {
+        memmove(buffer.data, buffer.data + buffer.begin, size);
+    } else {
+        size_t capacity = 0;
+        char* data = buffer_pool_->acquire(std::max<size_t>(buffer.capacity * 2, size + length), capacity);
+        memcpy(data, buffer.data + buffer.begin, size);
+        uint32_t frame_left = buffer.frame_left;
+        release_buffer(buffer, true);
+        buffer.frame_left = frame_left;
+        buffer.data = data;
+        buffer.capacity = static_cast<uint32_t>(capacity);
+        budget_.charge(MemoryBudget::Category::Output, buffer.capacity);
+    }
+    buffer.begin = 0;
+    buffer.end = static_cast<uint32_t>(size);
+}
+
+/**
+ * @brief 归还缓冲区
+ * @param buffer 目标缓冲区
+ * @param force 是否强制归还（Eager 模式下非强制时只清空）
+ *
+ * @details Eager 模式下扩容过的缓冲块换回最小档位，让积压释放的内存回到预算中
+ */
+void TcpServerBase::release_buffer(Buffer& buffer, bool force) {
+    buffer.begin = buffer.end = 0;
+    buffer.frame_left = 0;
+    if (!buffer.data) {
+        return;
+    }
+    if (!force && buffer_mode_ == BufferMode::Eager) {
+        if (buffer.capacity > SizeClassPool::MIN_CLASS_SIZE) {
+            release_buffer(buffer, true);
+            reserve_buffer(buffer, SizeClassPool::MIN_CLASS_SIZE);
+        }
+        return;
+    }
+
+    budget_.release(MemoryBudget::Category::Output, buffer.capacity);
+    buffer_pool_->release(buffer.data, buffer.capacity);
+    buffer.data = nullptr;
+    buffer.capacity = 0;
+    on_memory_released();
+}
+
+/**
+ * @brief 在持有 clients_mutex_ 的情况下发送数据
+ * @param conn 客户端连接
+ * @param data 数据起始地址
+ * @param length 数据长度
+ * @param priority 消息优先级
+ * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+ * @return 是否已发送或已排队
+ *
+ * @details
+ * 没有需要排在前面的数据时先直接发送；发不完（或需要排队以保证顺序）时
+ * 经内存上限检查后把剩余部分追加到对应优先级的输出缓冲区，并让事件循环关注可写事件。
+ */
+bool TcpServerBase::send_locked(Connection& conn, const char* data, size_t length, Priority priority,
+                                int64_t expiry_ns) {
+    if (conn.closing) {
+        return false;
+    }
+
+    int64_t now_ns = 0;
+    if (priority != Priority::Urgent && drop_if_expired(conn, length, expiry_ns, now_ns)) {
+        return false;
+    }
+
+    size_t sent = 0;
+
+    if (can_write_directly(conn, priority)) {
+        int64_t sent_ns = send_started(conn);
+        ssize_t bytes_sent = ::send(conn.fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        note_sent(conn, bytes_sent, sent_ns);
+        if (bytes_sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            bytes_sent = 0;
+        }
+        sent = static_cast<size_t>(bytes_sent);
+    }
+
+    if (sent == length) {
+        publish_output(conn, sent, 1);
+        return true;
+    }
+
+    // 已写出一部分的消息必须完整排队，只有整条消息才能被丢弃
+    if (!admit_output(conn, length - sent, priority, sent == 0)) {
+        publish_output(conn, sent, 0);
+        return false;
+    }
+
+    bool was_empty = conn.output.size() == 0 && conn.urgent.size() == 0;
+    queue_output(conn, data + sent, length - sent, priority, expiry_ns, sent > 0);
+    if (was_empty) {
+        // 连接尚未注册或正在迁移时，由注册方补上可写事件
+        update_interest(conn);
+    }
+    publish_output(conn, sent, 1);
+    return true;
+}
+
+/**
+ * @brief 连接是否可以直接写出该优先级的消息
+ * @param conn 客户端连接
+ * @param priority 消息优先级
+ * @return 是否可以直接写出
+ *
+ * @details 紧急消息只需普通数据位于帧边界且没有更早的紧急数据；其他消息需要两个缓冲区都为空。
+ *          迁移期间没有事件循环负责该连接，消息一律排队，由目标事件循环接管后写出
+ */
+bool TcpServerBase::can_write_directly(const Connection& conn, Priority priority) {
+    if (conn.migrating || conn.urgent.size() > 0) {
+        return false;
+    }
+    if (priority == Priority::Urgent) {
+        return conn.output.frame_left == 0;
+    }
+    return conn.output.size() == 0;
+}
+
+/**
+ * @brief 把消息剩余部分排入对应优先级的输出缓冲区
+ * @param conn 客户端连接
+ * @param data 数据起始地址
+ * @param length 数据长度
+ * @param priority 消息优先级
+ * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+ * @param partial 消息已写出一部分
+ *
+ * @details 已写出一部分的普通消息只会出现在空缓冲区中，剩余部分就是正在写出的帧，
+ *          不加长度头，直接记为 frame_left，保证紧急数据不会插进半帧，也不会再过期
+ */
+void TcpServerBase::queue_output(Connection& conn, const char* data, size_t length, Priority priority,
+                                 int64_t expiry_ns, bool partial) {
+    if (priority == Priority::Urgent) {
+        append_buffer(conn.urgent, data, length);
+    } else if (partial) {
+        append_buffer(conn.output, data, length);
+        conn.output.frame_left = static_cast<uint32_t>(length);
+    } else {
+        append_frame(conn.output, data, length, expiry_ns);
+    }
+}
+
+/**
+ * @brief 补发合并键的最新值
+ * @param conn 客户端连接
+ * @return 是否排入了数据
+ *
+ * @details 作为普通帧一起追加，由 handle_write() 合并成 writev 写出
+ */
+bool TcpServerBase::flush_conflated(Connection& conn) {
+    if (!conn.conflated || conn.conflated->order.empty()) {
+        return false;
+    }
+
+    ConflatedKeys& keys = *conn.conflated;
+    for (uint32_t index : keys.order) {
+        const std::string& value = conflation_values_[index];
+        append_frame(conn.output, value.data(), value.size(), 0);
+        keys.pending[index] = 0;
+    }
+    publish_output(conn, 0, keys.order.size());
+    keys.order.clear();
+    return conn.output.size() > 0;
+}
+
+/**
+ * @brief 检查消息是否已过期
+ * @param conn 客户端连接
+ * @param length 消息长度
+ * @param expiry_ns 过期时间（纳秒）
+ * @param now_ns 当前时间（纳秒），为 0 时取 Clock::cached_ns() 并回填
+ * @return 是否已过期
+ */
+bool TcpServerBase::drop_if_expired(Connection& conn, size_t length, int64_t expiry_ns, int64_t& now_ns) {
+    if (expiry_ns == 0) {
+        return false;
+    }
+    if (now_ns == 0) {
+        now_ns = Clock::cached_ns();
+    }
+    if (expiry_ns > now_ns) {
+        return false;
+    }
+    ++conn.expired;
+    ++expired_messages_;
+    expired_bytes_ += length;
+    return true;
+}
+
+/**
+ * @brief 查询连接所属的事件循环
+ * @param client_fd 客户端文件描述符
+ * @param generation 输出参数，登记时连接的代号
+ * @return 事件循环下标加一（迁移中带 OWNER_MIGRATING 标志），0 表示未知
+ *
+ * @details 代号与所属保存在同一个原子变量中，总是同一次登记的结果
+ */
+uint32_t TcpServerBase::owner_of(int client_fd, uint32_t& generation) const {
+    if (client_fd < 0 || static_cast<size_t>(client_fd) >= owner_capacity_) {
+        generation = 0;
+        return 0;
+    }
+    uint64_t entry = owners_[client_fd].load(std::memory_order_acquire);
+    generation = static_cast<uint32_t>(entry >> 32);
+    return static_cast<uint32_t>(entry);
+}
+
+/**
+ * @brief 登记或清除连接所属的事件循环
+ * @param client_fd 客户端文件描述符
+ * @param owner 事件循环下标加一，0 表示清除
+ * @param generation 连接代号，清除时为 0
+ */
+void TcpServerBase::set_owner(int client_fd, uint32_t owner, uint32_t generation) {
+    if (client_fd >= 0 && static_cast<size_t>(client_fd) < owner_capacity_) {
+        owners_[client_fd].store(static_cast<uint64_t>(generation) << 32 | owner, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief 投递发送请求
+ * @param io 目标事件循环
+ * @param client_fd 目标客户端
+ * @param generation 查询所属时得到的连接代号
+ * @param message 消息内容
+ * @param priority 消息优先级
+ * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+ * @return 是否已投递
+ *
+ * @details 请求与消息内容一次分配，计入任务预算。只有队列由空变为非空的投递者唤醒事件循环。
+ *          请求带上连接代号，投递之后 fd 被关闭并分配给新连接时，请求不会发给新连接
+ */
+bool TcpServerBase::enqueue_send(IoLoop& io, int client_fd, uint32_t generation, std::string_view message,
+                                 Priority priority, int64_t expiry_ns) {
+    size_t bytes = sizeof(SendRequest) + message.size();
+
+    // 低优先级消息在投递前就按全局预算丢弃，不必占用队列
+    if (priority == Priority::Low && limits_.policy == OverflowPolicy::DropLowPriority
+        && budget_.would_exceed(bytes)) {
+        ++dropped_messages_;
+        dropped_bytes_ += message.size();
+        return false;
+    }
+
+    SendRequest* request = static_cast<SendRequest*>(::operator new(bytes));
+    request->next = nullptr;
+    request->fd = client_fd;
+    request->generation = generation;
+    request->priority = priority;
+    request->length = static_cast<uint32_t>(message.size());
+    request->expiry_ns = expiry_ns;
+    memcpy(request->payload(), message.data(), message.size());
+    budget_.charge(MemoryBudget::Category::Task, bytes);
+
+    if (io.send_queue->push(request)) {
+        io.loop->wakeup();
+    }
+    return true;
+}
+
+/**
+ * @brief 取走并发送队列中的全部请求
+ * @param io 所属事件循环
+ *
+ * @details
+ * 整批请求只加一次锁。
+ */
+void TcpServerBase::drain_sends(IoLoop& io) {
+    SendRequest* request = io.send_queue->take_all();
+    if (!request) {
+        return;
+    }
+
+    size_t released = 0;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        released = send_requests_locked(io, request);
+    }
+
+    budget_.release(MemoryBudget::Category::Task, released);
+    on_memory_released();
+}
+
+/**
+ * @brief 发送一串请求并释放
+ * @param io 当前事件循环
+ * @param request 按投递顺序链接的请求
+ * @return 已释放的请求字节数
+ *
+ * @details
+ * 按投递顺序把同一连接相邻的请求合并为一次 writev，连接已断开（或 fd 已属于代号不同的新连接）的请求直接丢弃。
+ * 迁往本事件循环、尚未接管的连接的请求暂存到 held_sends，由 adopt_connection() 发送，
+ * 保证它们排在原事件循环队列中更早的请求之后。
+ */
+size_t TcpServerBase::send_requests_locked(IoLoop& io, SendRequest* request) {
+    size_t released = 0;
+    SendRequest* batch[MAX_SEND_BATCH];
+
+    while (request) {
+        int fd = request->fd;
+        uint32_t generation = request->generation;
+        size_t count = 0;
+        // 紧急消息单独处理，以便插队到帧边界
+        bool urgent = request->priority == Priority::Urgent;
+        while (request && request->fd == fd && request->generation == generation && count < MAX_SEND_BATCH
+               && (count == 0 || (!urgent && request->priority != Priority::Urgent))) {
+            batch[count++] = request;
+            request = request->next;
+        }
+
+        auto it = clients_.find(fd);
+        if (it != clients_.end() && it->second.generation != generation) {
+            it = clients_.end();
+        }
+        if (it != clients_.end() && it->second.migrating && &loops_[it->second.loop_index] == &io) {
+            io.held_sends.insert(io.held_sends.end(), batch, batch + count);
+            continue;
+        }
+        if (it != clients_.end()) {
+            send_batch_locked(it->second, batch, count);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            released += sizeof(SendRequest) + batch[i]->length;
+            ::operator delete(batch[i]);
+        }
+    }
+    return released;
+}
+
+/**
+ * @brief 用一次 writev 发送同一连接的多条消息
+ * @param conn 客户端连接
+ * @param batch 发送请求
+ * @param batch_count 请求数量
+ *
+ * @details
+ * 可以直接写出时（见 can_write_directly()）把所有消息作为一个 iovec 数组写出（sendmsg 等同于带 MSG_NOSIGNAL 的 writev），
+ * 写不完的部分与 send_locked() 一样经内存上限检查后排队：已写出一部分的消息完整排队，
+ * 尚未写出的消息可以按策略整条丢弃。
+ */
+void TcpServerBase::send_batch_locked(Connection& conn, SendRequest* const* batch, size_t batch_count) {
+    if (conn.closing) {
+        return;
+    }
+
+    // 在队列中等待期间过期的普通消息不再写出
+    SendRequest* requests[MAX_SEND_BATCH];
+    size_t count = 0;
+    int64_t now_ns = 0;
+    for (size_t i = 0; i < batch_count; ++i) {
+        SendRequest* request = batch[i];
+        if (request->priority != Priority::Urgent
+            && drop_if_expired(conn, request->length, request->expiry_ns, now_ns)) {
+            continue;
+        }
+        requests[count++] = request;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    bool was_empty = conn.output.size() == 0 && conn.urgent.size() == 0;
+    size_t sent = 0;
+
+    if (can_write_directly(conn, requests[0]->priority)) {
+        iovec iov[MAX_SEND_BATCH];
+        for (size_t i = 0; i < count; ++i) {
+            iov[i].iov_base = requests[i]->payload();
+            iov[i].iov_len = requests[i]->length;
+        }
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+
+        int64_t sent_ns = send_started(conn);
+        ssize_t bytes_sent = sendmsg(conn.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        note_sent(conn, bytes_sent, sent_ns);
+        if (bytes_sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // 连接出错，由事件循环读到错误后回收
+                return;
+            }
+            bytes_sent = 0;
+        }
+        sent = static_cast<size_t>(bytes_sent);
+    }
+
+    size_t bytes = sent;
+    size_t accepted = 0;
+    for (size_t i = 0; i < count; ++i) {
+        SendRequest* request = requests[i];
+        size_t written = std::min<size_t>(sent, request->length);
+        sent -= written;
+        if (written == request->length) {
+            ++accepted;
+            continue;
+        }
+
+        size_t remaining = request->length - written;
+        if (!admit_output(conn, remaining, request->priority, written == 0)) {
+            if (conn.closing) {
+                return;
+            }
+            continue;
+        }
+        ++accepted;
+        queue_output(conn, request->payload() + written, remaining, request->priority, request->expiry_ns,
+                     written > 0);
+    }
+
+    if (was_empty && (conn.output.size() > 0 || conn.urgent.size() > 0)) {
+        update_interest(conn);
+    }
+    publish_output(conn, bytes, accepted);
+}
+
+/**
+ * @brief 丢弃事件循环队列中尚未发送的请求
+ * @param io 事件循环
+ */
+void TcpServerBase::discard_sends(IoLoop& io) {
+    if (!io.send_queue) {
+        return;
+    }
+
+    size_t released = 0;
+    SendRequest* request = io.send_queue->take_all();
+    while (request) {
+        SendRequest* next = request->next;
+        released += sizeof(SendRequest) + request->length;
+        ::operator delete(request);
+        request = next;
+    }
+    for (SendRequest* held : io.held_sends) {
+        released += sizeof(SendRequest) + held->length;
+        ::operator delete(held);
+    }
+    io.held_sends.clear();
+    budget_.release(MemoryBudget::Category::Task, released);
+}
+
+/**
+ * @brief 检查待排队的输出是否超限并执行策略
+ * @param conn 客户端连接
+ * @param length 将要排队的字节数
+ * @param priority 消息优先级
+ * @param droppable 消息是否可以整条丢弃
+ * @return 是否允许排队
+ */
+bool TcpServerBase::admit_output(Connection& conn, size_t length, Priority priority, bool droppable) {
+    size_t cap = limits_.connection_output_bytes;
+    bool over_connection = cap != 0 && conn.output.size() + conn.urgent.size() + length > cap;
+    bool over_global = budget_.would_exceed(length);
+    if (!over_connection && !over_global) {
+        return true;
+    }
+
+    switch (limits_.policy) {
+    case OverflowPolicy::DropLowPriority:
+        if (priority == Priority::Low && droppable) {
+            ++dropped_messages_;
+            dropped_bytes_ += length;
+            return false;
+        }
+        return true;
+
+    case OverflowPolicy::DisconnectLargest: {
+        Connection* victim = over_connection ? &conn : largest_connection_locked();
+        if (victim) {
+            disconnect_locked(*victim);
+        }
+        return victim != &conn;
+    }
+
+    case OverflowPolicy::PauseReads:
+    default:
+        // 全局超限由各事件循环在下一次读取前暂停
+        if (over_connection) {
+            pause_reads(conn, PAUSE_OUTPUT);
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief 读取前检查全局预算
+ * @param io 所属事件循环
+ * @param conn 客户端连接
+ * @return 是否可以继续读取
+ */
+bool TcpServerBase::check_input_budget(IoLoop& io, Connection* conn) {
+    if (!budget_.exceeded()) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+
+    if (limits_.policy == OverflowPolicy::DisconnectLargest) {
+        // 被断开的连接（可能就是当前连接）会在下一次读取时读到 EOF
+        Connection* victim = largest_connection_locked();
+        if (victim) {
+            disconnect_locked(*victim);
+        }
+        return true;
+    }
+
+    // 输入数据无法丢弃，DropLowPriority 下同样暂停读取
+    pause_reads(*conn, PAUSE_GLOBAL);
+    io.paused_fds.push_back(conn->fd);
+    global_paused_ = true;
+
+    // 归还可能发生在置位之前，补做一次检查
+    on_memory_released();
+    return false;
+}
+
+/**
+ * @brief 计算连接应关注的事件
+ * @param conn 客户端连接
+ * @return epoll 事件掩码
+ */
+uint32_t TcpServerBase::interest_events(const Connection& conn) const {
+    uint32_t events = conn.pause_reasons.load(std::memory_order_relaxed) != 0 ? PAUSED_EVENTS : READ_EVENTS;
+    if (conn.output.size() > 0 || conn.urgent.size() > 0 || (conn.conflated && !conn.conflated->order.empty())) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+/**
+ * @brief 更新连接关注的事件
+ * @param conn 客户端连接
+ *
+ * @details 连接尚未注册或正在迁移时 fd 不在任何 epoll 中，
+ *          由 accept_loop() 或 adopt_connection() 注册时按 interest_events() 一并设置
+ */
+void TcpServerBase::update_interest(Connection& conn) {
+    if (!conn.registered || conn.migrating) {
+        return;
+    }
+    loops_[conn.loop_index].loop->modify(conn.fd, interest_events(conn), &conn);
+}
+
+/**
+ * @brief 暂停读取连接
+ * @param conn 客户端连接
+ * @param reason 暂停原因
+ */
+void TcpServerBase::pause_reads(Connection& conn, uint8_t reason) {
+    uint8_t previous = conn.pause_reasons.fetch_or(reason, std::memory_order_relaxed);
+    if (previous == 0) {
+        ++paused_connections_;
+        update_interest(conn);
+    }
+}
+
+/**
+ * @brief 撤销暂停原因
+ * @param conn 客户端连接
+ * @param reason 暂停原因
+ *
+ * @details 边缘触发下重新关注 EPOLLIN 时，若 socket 中已有数据会立即再次通知
+ */
+void TcpServerBase::resume_reads(Connection& conn, uint8_t reason) {
+    uint8_t previous = conn.pause_reasons.fetch_and(static_cast<uint8_t>(~reason), std::memory_order_relaxed);
+    if ((previous & reason) && (previous & ~reason) == 0) {
+        --paused_connections_;
+        update_interest(conn);
+    }
+}
+
+/**
+ * @brief 恢复本事件循环中因全局超限暂停的连接
+ * @param io 所属事件循环
+ */
+void TcpServerBase::resume_global_reads(IoLoop& io) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (int fd : io.paused_fds) {
+        auto it = clients_.find(fd);
+        if (it == clients_.end() || &loops_[it->second.loop_index] != &io) {
+            continue;
+        }
+        if (it->second.pause_reasons.load(std::memory_order_relaxed) & PAUSE_GLOBAL) {
+            resume_reads(it->second, PAUSE_GLOBAL);
+        }
+    }
+    io.paused_fds.clear();
+}
+
+/**
+ * @brief 缓冲区归还后检查是否可以恢复全局暂停的读取
+ *
+ * @details 用量回落到预算的 3/4 以下时，向每个事件循环投递一次恢复任务
+ */
+void TcpServerBase::on_memory_released() {
+    if (!global_paused_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    size_t limit = budget_.limit();
+    if (budget_.used() > limit - limit / 4) {
+        return;
+    }
+    if (!global_paused_.exchange(false)) {
+        return;
+    }
+
+    for (IoLoop& io : loops_) {
+        IoLoop* target = &io;
+        io.loop->queue_in_loop([this, target]() { resume_global_reads(*target); });
+    }
+}
+
+/**
+ * @brief 查找持有缓冲最多的连接
+ * @return 连接指针或 nullptr
+ */
+TcpServerBase::Connection* TcpServerBase::largest_connection_locked() {
+    Connection* largest = nullptr;
+    size_t largest_bytes = 0;
+    for (auto& [fd, conn] : clients_) {
+        if (conn.closing) {
+            continue;
+        }
+        size_t bytes = conn.output.capacity + conn.urgent.capacity + conn.input_bytes.load(std::memory_order_relaxed);
+        if (!largest || bytes > largest_bytes) {
+            largest = &conn;
+            largest_bytes = bytes;
+        }
+    }
+    return largest;
+}
+
+/**
+ * @brief 因内存超限断开连接
+ * @param conn 客户端连接
+ */
+void TcpServerBase::disconnect_locked(Connection& conn) {
+    if (conn.closing) {
+        return;
+    }
+
+    std::cerr << "[TcpServer] Memory limit exceeded, disconnecting " << format_address(conn.ip, conn.port) << std::endl;
+    conn.closing = true;
+    ++overflow_disconnects_;
+    release_buffer(conn.output, true);
+    release_buffer(conn.urgent, true);
+    shutdown(conn.fd, SHUT_RDWR);
+}
+
+/**
+ * @brief 向指定客户端发送消息
+ * @param client_fd 目标客户端文件描述符
+ * @param message 要发送的消息
+ * @param priority 消息优先级
+ * @param expiry 过期时间点
+ * @return 发送是否成功
+ *
+ * @details
+ * 不在所属事件循环线程中时投递到该循环的发送队列；所属未知（连接尚未注册或
+ * fd 超出登记表）时退回加锁直接发送。连接迁移期间总是投递给目标事件循环，由它在接管后发送。
+ *
+ * 查询所属与投递处于同一个 RCU 读临界区：迁移方更改所属后等待宽限期，
+ * 即可确认所有按旧所属进行的投递都已进入原事件循环的队列。
+ */
+bool TcpServerBase::send_to(int client_fd, std::string_view message, Priority priority, Expiry expiry) {
+    int64_t expiry_ns = expiry_to_ns(expiry);
+    {
+        Rcu::ReadGuard guard;
+        bool accepted = false;
+        if (hand_off_send(client_fd, message, priority, expiry_ns, accepted)) {
+            return accepted;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+
+    // 检查客户端是否存在
+    auto it = clients_.find(client_fd);
+    if (it == clients_.end()) {
+        return false;
+    }
+
+    return send_locked(it->second, message.data(), message.size(), priority, expiry_ns);
+}
+
+/**
+ * @brief 不在所属事件循环线程中时把消息投递给所属事件循环
+ * @param client_fd 目标客户端文件描述符
+ * @param message 要发送的消息
+ * @param priority 消息优先级
+ * @param expiry_ns 过期时间（纳秒），0 表示永不过期
+ * @param accepted 输出参数，已投递时为投递结果
+ * @return 是否已交给所属事件循环；false 表示调用方应加锁直接发送
+ *
+ * @details 调用方需处于 RCU 读临界区中，见 send_to()
+ */
+bool TcpServerBase::hand_off_send(int client_fd, std::string_view message, Priority priority, int64_t expiry_ns,
+                                  bool& accepted) {
+    uint32_t generation = 0;
+    uint32_t owner = owner_of(client_fd, generation);
+    if (owner == 0 || !running_) {
+        return false;
+    }
+    IoLoop& io = loops_[(owner & ~OWNER_MIGRATING) - 1];
+    if (!(owner & OWNER_MIGRATING) && io.loop->is_in_loop_thread()) {
+        return false;
+    }
+    accepted = enqueue_send(io, client_fd, generation, message, priority, expiry_ns);
+    return true;
+}
+
+/**
+ * @brief 向所有客户端广播消息
+ * @param message 要广播的消息
+ * @param priority 消息优先级
+ * @param expiry 过期时间点
+ *
+ * @details 与 send_to() 相同，每个连接只在其所属事件循环线程中直接写出，
+ *          其余连接的副本投递到所属事件循环的发送队列，排在此前投递给它的消息之后
+ */
+void TcpServerBase::broadcast(std::string_view message, Priority priority, Expiry expiry) {
+    int64_t expiry_ns = expiry_to_ns(expiry);
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    Rcu::ReadGuard guard;
+
+    for (auto& [fd, conn] : clients_) {
+        bool accepted = false;
+        if (!hand_off_send(fd, message, priority, expiry_ns, accepted)) {
+            send_locked(conn, message.data(), message.size(), priority, expiry_ns);
+        }
+    }
+}
+
+/**
+ * @brief 按键合并地广播最新值
+ * @param key 消息键
+ * @param message 最新值
+ *
+ * @details 最新值原地覆盖保存，容量够用时不分配内存。没有积压的连接与 broadcast() 一样
+ *          只由所属事件循环写出，其他线程调用时投递一份副本
+ */
+void TcpServerBase::broadcast_conflated(uint64_t key, std::string_view message) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    Rcu::ReadGuard guard;
+
+    auto [it, inserted] = conflation_index_.try_emplace(key, static_cast<uint32_t>(conflation_values_.size()));
+    if (inserted) {
+        conflation_values_.emplace_back();
+    }
+    uint32_t index = it->second;
+    conflation_values_[index].assign(message.data(), message.size());
+
+    for (auto& [fd, conn] : clients_) {
+        if (conn.closing) {
+            continue;
+        }
+
+        bool backlogged = conn.output.size() > 0 || conn.urgent.size() > 0
+                          || (conn.conflated && !conn.conflated->order.empty());
+        if (!backlogged) {
+            bool accepted = false;
+            if (!hand_off_send(fd, message, Priority::Normal, 0, accepted)) {
+                send_locked(conn, message.data(), message.size(), Priority::Normal, 0);
+            }
+            continue;
+        }
+
+        // 有积压时只记下键，补发时取当时的最新值
+        if (!conn.conflated) {
+            conn.conflated = std::make_unique<ConflatedKeys>();
+        }
+        ConflatedKeys& keys = *conn.conflated;
+        if (keys.pending.size() <= index) {
+            keys.pending.resize(conflation_values_.size(), 0);
+        }
+        if (keys.pending[index]) {
+            ++conflated_updates_;
+            continue;
+        }
+        keys.pending[index] = 1;
+        keys.order.push_back(index);
+        if (conn.output.size() == 0 && conn.urgent.size() == 0) {
+            // 只有待补发的键时也需要可写事件来触发补发
+            update_interest(conn);
+        }
+    }
+}
+
+/**
+ * @brief 获取连接上因过期被丢弃的消息数
+ * @param client_fd 客户端文件描述符
+ * @return 丢弃的消息数
+ */
+uint64_t TcpServerBase::expired_messages(int client_fd) const {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    auto it = clients_.find(client_fd);
+    return it == clients_.end() ? 0 : it->second.expired;
+}
+
+/**
+ * @brief 把连接迁移到另一个事件循环
+ * @param client_fd 客户端文件描述符
+ * @param loop_index 目标事件循环下标
+ * @return 是否已开始迁移
+ *
+ * @details 注销由原事件循环执行，保证此时它没有在处理该连接的事件
+ */
+bool TcpServerBase::migrate(int client_fd, size_t loop_index) {
+    if (!running_ || loop_index >= loops_.size()) {
+        return false;
+    }
+
+    size_t source;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        auto it = clients_.find(client_fd);
+        if (it == clients_.end() || !it->second.registered || it->second.closing || it->second.migrating
+            || it->second.loop_index == loop_index) {
+            return false;
+        }
+        source = it->second.loop_index;
+    }
+
+    loops_[source].loop->queue_in_loop([this, source, client_fd, loop_index]() {
+        start_migration(source, client_fd, loop_index);
+    });
+    return true;
+}
+
+/**
+ * @brief 在原事件循环中开始迁移指定连接
+ * @param source 原事件循环下标
+ * @param client_fd 客户端文件描述符
+ * @param target 目标事件循环下标
+ */
+void TcpServerBase::start_migration(size_t source, int client_fd, size_t target) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    auto it = clients_.find(client_fd);
+    if (it == clients_.end() || !it->second.registered || it->second.closing || it->second.migrating
+        || it->second.loop_index != source) {
+        return;
+    }
+    begin_migration_locked(source, it->second, target);
+}
+
+/**
+ * @brief 从事件循环中挑选一个连接迁往目标循环
+ * @param source 原事件循环下标
+ * @param target 目标事件循环下标
+ * @param source_load 原事件循环的利用率
+ * @param movable_load 可以迁走的利用率上限
+ *
+ * @details
+ * 按各连接近期读写的字节数把原循环的利用率分摊到连接上，选出不超过 movable_load 的
+ * 最大连接，迁走后两边的负载不会反转。挑选之后清零所有连接的计数，下一次按新的区间统计。
+ */
+void TcpServerBase::shed_connection(size_t source, size_t target, double source_load, double movable_load) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+
+    uint64_t total = 0;
+    for (const auto& [fd, conn] : clients_) {
+        if (conn.loop_index == source) {
+            total += conn.activity;
+        }
+    }
+    if (total == 0) {
+        return;
+    }
+
+    Connection* chosen = nullptr;
+    uint64_t chosen_activity = 0;
+    for (auto& [fd, conn] : clients_) {
+        if (conn.loop_index != source) {
+            continue;
+        }
+        uint64_t activity = conn.activity;
+        conn.activity = 0;
+        if (!conn.registered || conn.closing || conn.migrating || activity <= chosen_activity) {
+            continue;
+        }
+        double load = source_load * static_cast<double>(activity) / static_cast<double>(total);
+        if (load <= movable_load) {
+            chosen = &conn;
+            chosen_activity = activity;
+        }
+    }
+
+    if (chosen) {
+        begin_migration_locked(source, *chosen, target);
+    }
+}
+
+/**
+ * @brief 注销连接并把所有权交给目标事件循环
+ * @param source 原事件循环下标
+ * @param conn 客户端连接
+ * @param target 目标事件循环下标
+ *
+ * @details
+ * 注销之后原事件循环不再读写该连接；登记表改为目标事件循环并带上迁移标志，
+ * 此后的 send_to() 都投递给目标事件循环暂存。推进 RCU 纪元，等宽限期过后
+ * 按旧所属进行的投递都已进入原事件循环的队列。
+ */
+void TcpServerBase::begin_migration_locked(size_t source, Connection& conn, size_t target) {
+    int client_fd = conn.fd;
+    loops_[source].loop->remove(client_fd);
+    unlink_ready(loops_[source], &conn);
+    remove_member(loops_[source], conn);
+    conn.loop_index = static_cast<uint32_t>(target);
+    conn.migrating = true;
+    conn.activity = 0;
+    set_owner(client_fd, static_cast<uint32_t>(target + 1) | OWNER_MIGRATING, conn.generation);
+
+    uint64_t epoch = Rcu::advance();
+    loops_[source].loop->queue_in_loop([this, source, client_fd, target, epoch]() {
+        finish_migration(source, client_fd, target, epoch);
+    });
+}
+
+/**
+ * @brief 等待旧所属的投递完成，再通知目标事件循环接管
+ * @param source 原事件循环下标
+ * @param client_fd 客户端文件描述符
+ * @param target 目标事件循环下标
+ * @param epoch 更改所属之后推进的 RCU 纪元
+ *
+ * @details
+ * 事件循环的每一轮都处于读临界区中，不能同步等待宽限期，只能在之后的轮次中检查。
+ * 宽限期过后取走本循环队列中剩余的请求写入连接的缓冲区，它们都排在目标事件循环
+ * 暂存的请求之前。
+ */
+void TcpServerBase::finish_migration(size_t source, int client_fd, size_t target, uint64_t epoch) {
+    if (!running_) {
+        return;
+    }
+
+    IoLoop& io = loops_[source];
+    if (!Rcu::grace_passed(epoch)) {
+        io.loop->queue_in_loop([this, source, client_fd, target, epoch]() {
+            finish_migration(source, client_fd, target, epoch);
+        });
+        return;
+    }
+
+    drain_sends(io);
+    loops_[target].loop->queue_in_loop([this, target, client_fd]() { adopt_connection(target, client_fd); });
+}
+
+/**
+ * @brief 目标事件循环接管连接
+ * @param target 目标事件循环下标
+ * @param client_fd 客户端文件描述符
+ *
+ * @details
+ * 注册 fd（socket 中已有未读数据时边缘触发会立即通知），恢复登记表，
+ * 再按投递顺序发送迁移期间暂存的请求和队列中剩余的请求。因全局超限暂停的连接登记到本循环的暂停列表，
+ * 若全局暂停已经解除则立即恢复读取；在原循环中因配额让出的连接记入本循环的就绪列表。
+ */
+void TcpServerBase::adopt_connection(size_t target, int client_fd) {
+    IoLoop& io = loops_[target];
+    size_t released = 0;
+    std::string client_addr;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+
+        // 取出发给该连接的暂存请求，保持投递顺序
+        SendRequest* held = nullptr;
+        SendRequest** tail = &held;
+        size_t kept = 0;
+        for (SendRequest* request : io.held_sends) {
+            if (request->fd == client_fd) {
+                *tail = request;
+                tail = &request->next;
+            } else {
+                io.held_sends[kept++] = request;
+            }
+        }
+        *tail = nullptr;
+        io.held_sends.resize(kept);
+
+        auto it = clients_.find(client_fd);
+        if (it != clients_.end() && it->second.migrating) {
+            Connection& conn = it->second;
+            conn.migrating = false;
+            io.loop->add(client_fd, interest_events(conn), &conn);
+            set_owner(client_fd, static_cast<uint32_t>(target + 1), conn.generation);
+            add_member(io, conn);
+            connection_stats_.set_loop(client_fd, static_cast<uint32_t>(target));
+            if (conn.ready != 0) {
+                io.ready.push_back(&conn);
+            }
+
+            if (conn.pause_reasons.load(std::memory_order_relaxed) & PAUSE_GLOBAL) {
+                if (global_paused_) {
+                    io.paused_fds.push_back(client_fd);
+                } else {
+                    resume_reads(conn, PAUSE_GLOBAL);
+                }
+            }
+            ++migrated_connections_;
+            client_addr = format_address(conn.ip, conn.port);
+        }
+
+        // 本循环队列中尚未取出的请求也在接管前投递，紧接着发送，
+        // 避免本线程随后直接写出的消息越过它们
+        released = send_requests_locked(io, held);
+        released += send_requests_locked(io, io.send_queue->take_all());
+    }
+
+    budget_.release(MemoryBudget::Category::Task, released);
+    on_memory_released();
+
+    if (!client_addr.empty()) {
+        std::cout << "[TcpServer] Client migrated: " << client_addr << " (fd=" << client_fd
+                  << ") to loop " << target << std::endl;
+    }
+}
+
+/**
+ * @brief 再均衡线程
+ *
+ * @details 每个间隔采样一次各事件循环的忙碌时间，最忙与最闲的循环相差超过阈值时
+ *          让最忙的循环挑出一个连接迁往最闲的循环
+ */
+void TcpServerBase::rebalance_loop() {
+    size_t loop_count = loops_.size();
+    std::vector<uint64_t> last_busy(loop_count);
+    for (size_t i = 0; i < loop_count; ++i) {
+        last_busy[i] = loops_[i].loop->busy_time_ns();
+    }
+    int64_t last_ns = Clock::now_ns();
+
+    std::unique_lock<std::mutex> lock(rebalance_mutex_);
+    while (running_) {
+        rebalance_cv_.wait_for(lock, rebalance_options_.interval, [this]() { return !running_; });
+        if (!running_) {
+            break;
+        }
+
+        int64_t now_ns = Clock::now_ns();
+        double elapsed = static_cast<double>(now_ns - last_ns);
+        last_ns = now_ns;
+        if (elapsed <= 0) {
+            continue;
+        }
+
+        size_t busiest = 0;
+        size_t idlest = 0;
+        for (size_t i = 0; i < loop_count; ++i) {
+            // 并发采样可能有一轮以内的误差，不允许倒退
+            uint64_t busy = std::max(loops_[i].loop->busy_time_ns(), last_busy[i]);
+            utilization_[i] = std::min(1.0, static_cast<double>(busy - last_busy[i]) / elapsed);
+            last_busy[i] = busy;
+            if (utilization_[i] > utilization_[busiest]) {
+                busiest = i;
+            }
+            if (utilization_[i] < utilization_[idlest]) {
+                idlest = i;
+            }
+        }
+
+        double source_load = utilization_[busiest];
+        double gap = source_load - utilization_[idlest];
+        if (source_load < rebalance_options_.min_utilization || gap < rebalance_options_.imbalance) {
+            continue;
+        }
+        loops_[busiest].loop->queue_in_loop([this, busiest, idlest, source_load, gap]() {
+            shed_connection(busiest, idlest, source_load, gap / 2);
+        });
+    }
+}
+
+/**
+ * @brief 设置新连接的放置策略
+ * @param placement 放置策略
+ */
+void TcpServerBase::set_placement(Placement placement) {
+    placement_ = placement;
+}
+
+/**
+ * @brief 获取放置策略的命中统计
+ * @return 统计快照
+ */
+TcpServerBase::PlacementStats TcpServerBase::placement_stats() const {
+    PlacementStats stats;
+    stats.same_cpu = placed_same_cpu_;
+    stats.same_node = placed_same_node_;
+    stats.fallback = placed_fallback_;
+    return stats;
+}
+
+/**
+ * @brief 设置按利用率自动迁移连接的配置
+ * @param options 再均衡配置
+ */
+void TcpServerBase::set_rebalance_options(const RebalanceOptions& options) {
+    rebalance_options_ = options;
+}
+
+/**
+ * @brief 设置每个连接每轮的读写配额
+ * @param budget 读写配额
+ */
+void TcpServerBase::set_fairness_budget(const FairnessBudget& budget) {
+    fairness_ = budget;
+}
+
+/**
+ * @brief 获取各事件循环的负载指标
+ * @return 指标列表
+ */
+std::vector<TcpServerBase::LoopStats> TcpServerBase::loop_stats() const {
+    std::vector<LoopStats> stats(loops_.size());
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        stats[i].cpu = loops_[i].cpu;
+        stats[i].busy_ns = loops_[i].loop->busy_time_ns();
+    }
+    {
+        std::lock_guard<std::mutex> lock(rebalance_mutex_);
+        for (size_t i = 0; i < stats.size() && i < utilization_.size(); ++i) {
+            stats[i].utilization = utilization_[i];
+        }
+    }
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (const auto& [fd, conn] : clients_) {
+        if (conn.loop_index < stats.size()) {
+            ++stats[conn.loop_index].connections;
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief 获取内核时间戳测得的延迟
+ * @return 各事件循环汇总的三段延迟摘要
+ */
+WireLatencyStats TcpServerBase::wire_latency() const {
+    auto total = std::make_unique<WireLatency>();
+    for (const IoLoop& io : loops_) {
+        if (io.latency) {
+            total->merge(*io.latency);
+        }
+    }
+    return total->stats();
+}
+
+/**
+ * @brief 获取连接最近一次的 TCP_INFO 采样
+ * @param client_fd 客户端文件描述符
+ * @param sample 输出参数，最近一次采样
+ * @return 是否已有采样
+ */
+bool TcpServerBase::tcp_info(int client_fd, TcpInfoSample& sample) const {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    auto it = clients_.find(client_fd);
+    if (it == clients_.end() || !it->second.tcp_info || it->second.tcp_info->sampled_ns == 0) {
+        return false;
+    }
+    sample = *it->second.tcp_info;
+    return true;
+}
+
+/**
+ * @brief 获取所有连接 TCP_INFO 采样的汇总分布
+ * @return 各事件循环汇总的各项指标摘要
+ */
+TcpInfoStats TcpServerBase::tcp_info_stats() const {
+    auto total = std::make_unique<TcpInfoHistograms>();
+    for (const IoLoop& io : loops_) {
+        if (io.tcp_info) {
+            total->merge(*io.tcp_info);
+        }
+    }
+    return total->stats();
+}
+
+/**
+ * @brief 设置连接缓冲区的内存模式
+ * @param mode 内存模式
+ */
+void TcpServerBase::set_buffer_mode(BufferMode mode) {
+    buffer_mode_ = mode;
+}
+
+/**
+ * @brief 设置接收缓冲区所用内存区域的配置
+ * @param options 内存区域配置
+ */
+void TcpServerBase::set_buffer_arena_options(const BufferArena::Options& options) {
+    arena_options_ = options;
+}
+
+/**
+ * @brief 设置内存上限与超限处理策略
+ * @param limits 内存上限配置
+ */
+void TcpServerBase::set_memory_limits(const MemoryLimits& limits) {
+    limits_ = limits;
+    budget_.set_limit(limits.global_bytes);
+}
+
+/**
+ * @brief 获取内存用量指标
+ * @return 指标快照
+ */
+TcpServerBase::MemoryStats TcpServerBase::memory_stats() const {
+    MemoryStats stats;
+    stats.input_bytes = budget_.used(MemoryBudget::Category::Input);
+    stats.output_bytes = budget_.used(MemoryBudget::Category::Output);
+    stats.task_bytes = budget_.used(MemoryBudget::Category::Task);
+    stats.total_bytes = budget_.used();
+    stats.peak_bytes = budget_.peak();
+    stats.limit_bytes = budget_.limit();
+    stats.paused_connections = paused_connections_;
+    stats.dropped_messages = dropped_messages_;
+    stats.dropped_bytes = dropped_bytes_;
+    stats.overflow_disconnects = overflow_disconnects_;
+    stats.expired_messages = expired_messages_;
+    stats.expired_bytes = expired_bytes_;
+    stats.conflated_updates = conflated_updates_;
+    return stats;
+}
+
+/**
+ * @brief 获取所有已连接客户端的信息
+ * @return 客户端映射表的副本
+ */
+std::unordered_map<int, std::string> TcpServerBase::get_clients() const {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    std::unordered_map<int, std::string> clients;
+    for (const auto& [fd, conn] : clients_) {
+        clients[fd] = format_address(conn.ip, conn.port);
+    }
+    return clients;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file basic_udp_server.h
+ * @brief 静态分发的 UDP 服务器模板的头文件
+ * @author Your Name
+ * @date 2024
+ * @version 1.0.0
+ * 
+ * @details
+ * BasicUdpServer 在 UdpServerBase 之上按模板参数组合 Handler、Codec 和 Executor
+ * （含义同 BasicTcpServer）。接收循环在模板内实现，每个数据报按 Codec 切分后
+ * 直接调用 Handler，发送方地址以 sockaddr_in 传递，不做字符串转换。
+ * 
+ * Handler 需要提供 on_message 或 on_batch 之一：
+ * @code
+ * void on_message(Server& server, const sockaddr_in& sender, std::string_view message);
+ * void on_batch(Server& server, Span<const UdpMessage> messages);
+ * @endcode
+ * 
+ * on_batch 每次 recvmmsg 调用一次（见 set_receive_batch()），交付这一批数据报中的
+ * 全部消息；批量回调总是在接收线程中执行，不经过执行器。
+ * 两者都提供时默认逐条分发，派生类可以用 set_batch_dispatch() 切换。
+ * 
+ * @example
+ * @code
+ * struct EchoHandler {
+ *     template <typename Server>
+ *     void on_message(Server& server, const sockaddr_in& sender, std::string_view msg) {
+ *         server.send_to(sender, msg);
+ *     }
+ * };
+ * BasicUdpServer<EchoHandler> server("0.0.0.0", 8080);
+ * server.start();
+ * @endcode
+ */
+
+#ifndef BASIC_UDP_SERVER_H
+#define BASIC_UDP_SERVER_H
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "udp_server_base.h"
+#include "codec.h"
+#include "executor.h"
+#include "span.h"
+#include "rcu.h"
+#include "clock.h"
+
+/**
+ * @struct UdpMessage
+ * @brief 批量回调中的一条消息
+ */
+struct UdpMessage {
+    sockaddr_in sender;         ///< 发送方地址
+    std::string_view data;      ///< 消息内容，只在回调期间有效
+    int64_t rx_timestamp_ns;    ///< 所在数据报的内核接收时间戳（CLOCK_REALTIME 纳秒），未开启时为 0
+};
+
+namespace detail {
+
+/// @brief 检测 Handler 是否提供 UDP 的 on_message
+template <typename Handler, typename Server, typename = void>
+struct has_on_datagram : std::false_type {};
+
+template <typename Handler, typename Server>
+struct has_on_datagram<Handler, Server, std::void_t<decltype(std::declval<Handler&>().on_message(
+    std::declval<Server&>(), std::declval<const sockaddr_in&>(), std::declval<std::string_view>()))>>
+    : std::true_type {};
+
+/// @brief 检测 Handler 是否提供 UDP 的 on_batch
+template <typename Handler, typename Server, typename = void>
+struct has_on_datagram_batch : std::false_type {};
+
+template <typename Handler, typename Server>
+struct has_on_datagram_batch<Handler, Server, std::void_t<decltype(std::declval<Handler&>().on_batch(
+    std::declval<Server&>(), std::declval<Span<const UdpMessage>>()))>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * @class BasicUdpServer
+ * @brief 以 Handler / Codec / Executor 为模板参数的 UDP 服务器
+ * 
+ * @tparam Handler 事件处理类型
+ * @tparam Codec 分帧策略，一个数据报可以包含多条消息；非法或不完整的部分被丢弃
+ * @tparam Executor 消息回调执行器
+ * 
+ * @note Handler 可能在多个接收线程中并发调用
+ */
+template <typename Handler, typename Codec = RawCodec, typename Executor = InlineExecutor>
+class BasicUdpServer : public UdpServerBase {
+public:
+    /**
+     * @brief 构造函数，Handler / Codec / Executor 均默认构造
+     * @param ip 服务器绑定的 IP 地址
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小，默认为 4
+     */
+    BasicUdpServer(const std::string& ip, uint16_t port, size_t thread_pool_size = 4)
+        : UdpServerBase(ip, port, thread_pool_size) {
+        set_batch_dispatch(BATCH_ONLY);
+    }
+    
+    /**
+     * @brief 构造函数
+     * @param ip 服务器绑定的 IP 地址
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小
+     * @param handler 事件处理对象
+     * @param codec 分帧策略对象
+     * @param executor 执行器对象
+     */
+    BasicUdpServer(const std::string& ip, uint16_t port, size_t thread_pool_size,
+                   Handler handler, Codec codec = Codec(), Executor executor = Executor())
+        : UdpServerBase(ip, port, thread_pool_size)
+        , handler_(std::move(handler))
+        , codec_(std::move(codec))
+        , executor_(std::move(executor)) {
+        set_batch_dispatch(BATCH_ONLY);
+    }
+    
+    /**
+     * @brief 析构函数
+     * @details 先停止服务器，保证 Handler 析构后不再有回调
+     */
+    ~BasicUdpServer() override {
+        stop();
+    }
+    
+    /**
+     * @brief 获取事件处理对象
+     */
+    Handler& handler() { return handler_; }
+    
+    /**
+     * @brief 获取分帧策略对象
+     * @note 必须在 start() 之前修改；Codec 会被多个接收线程同时使用
+     */
+    Codec& codec() { return codec_; }
+    
+    /**
+     * @brief 获取执行器对象
+     */
+    Executor& executor() { return executor_; }
+    
+protected:
+    void run_receiver(char* buffer, BusyPoller& poller) override {
+        Datagram datagrams[MAX_RECEIVE_BATCH];
+        // 线程内复用，容量增长到位后不再分配内存
+        std::vector<UdpMessage> batch;
+        
+        while (is_running()) {
+            int count = receive(buffer, datagrams, poller);
+            if (count <= 0) {
+                continue;
+            }
+            
+            // 每批刷新一次缓存时刻，回调中通过 Clock::cached_ns() 取用
+            Clock::refresh();
+            
+            // 每批数据报是一个读临界区，阻塞接收期间不拖延宽限期
+            Rcu::ReadGuard guard;
+            bool batching = HAS_BATCH && batch_dispatch();
+            for (int i = 0; i < count; ++i) {
+                const Datagram& datagram = datagrams[i];
+                set_rx_timestamp(datagram.rx_timestamp_ns);
+                size_t offset = 0;
+                while (offset < datagram.length) {
+                    std::string_view message;
+                    size_t frame_length = codec_.decode(datagram.data + offset, datagram.length - offset, message);
+                    if (frame_length == 0 || frame_length == CODEC_ERROR) {
+                        break;
+                    }
+                    offset += frame_length;
+                    
+                    if (batching) {
+                        batch.push_back(UdpMessage{datagram.sender, message, datagram.rx_timestamp_ns});
+                    } else {
+                        deliver(datagram.sender, message);
+                    }
+                }
+            }
+            
+            if constexpr (HAS_BATCH) {
+                if (!batch.empty()) {
+                    handler_.on_batch(*this, Span<const UdpMessage>(batch.data(), batch.size()));
+                    batch.clear();
+                }
+            }
+            finish_batch();
+        }
+    }
+    
+private:
+    static constexpr bool HAS_MESSAGE = detail::has_on_datagram<Handler, BasicUdpServer>::value;
+    static constexpr bool HAS_BATCH = detail::has_on_datagram_batch<Handler, BasicUdpServer>::value;
+    static constexpr bool BATCH_ONLY = HAS_BATCH && !HAS_MESSAGE;
+    
+    static_assert(HAS_MESSAGE || HAS_BATCH, "Handler must provide on_message or on_batch");
+    
+    /**
+     * @brief 逐条分发一条消息
+     */
+    void deliver(const sockaddr_in& sender_addr, std::string_view message) {
+        if constexpr (HAS_MESSAGE) {
+            uint64_t key = (static_cast<uint64_t>(sender_addr.sin_addr.s_addr) << 16) | sender_addr.sin_port;
+            executor_.execute(key, message, [this, sender_addr](std::string_view m) {
+                handler_.on_message(*this, sender_addr, m);
+            });
+        } else {
+            (void)sender_addr;
+            (void)message;
+        }
+    }
+    
+    Handler handler_;       // 事件处理对象
+    Codec codec_;           // 分帧策略
+    Executor executor_;     // 消息回调执行器
+};
+
+#endif // BASIC_UDP_SERVER_H
@@ -35,6 +35,9 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include "rcu.h"
+#include "busy_poll.h"
+#include "realtime.h"
 
 /**
  * @class UdpClient
@@ -117,9 +120,33 @@ public:
     /**
      * @brief 设置消息接收回调
      * @param callback 接收到消息时调用的回调函数
+     * 
+     * @note 可以在运行中随时调用（包括在回调内部），旧回调在宽限期后释放
      */
     void set_message_callback(MessageCallback callback);
     
+    /**
+     * @brief 设置接收线程的忙轮询模式
+     * @param options 忙轮询配置
+     * 
+     * @details
+     * 必须在 start_receiving() 之前调用。启用后接收线程以 MSG_DONTWAIT 调用 recvfrom 自旋，
+     * 连续空转超过 idle_timeout 后退回带超时的阻塞接收，收到数据报后重新自旋。
+     * SO_BUSY_POLL / SO_PREFER_BUSY_POLL 被内核拒绝时打印警告并只保留自旋。
+     */
+    void set_busy_poll(const BusyPollOptions& options) { busy_poll_ = options; }
+    
+    /**
+     * @brief 设置接收线程的实时化配置
+     * @param options 实时化配置
+     * 
+     * @details
+     * 必须在 start_receiving() 之前调用。接收线程启动时以 io_priority 切换为 SCHED_FIFO、
+     * 预写入栈，lock_memory 为 true 时对整个进程 mlockall。
+     * 权限不足时退化为普通调度并打印一次警告，结果见 Realtime::report()。
+     */
+    void set_realtime(const RealtimeOptions& options) { realtime_ = options; }
+    
     /**
      * @brief 获取初始化状态
      * @return true 已初始化，false 未初始化
@@ -145,7 +172,9 @@ private:
     std::thread receive_thread_;            // 接收消息的线程
     std::mutex send_mutex_;                 // 发送操作的互斥锁
     
-    MessageCallback message_callback_;      // 消息接收回调
+    RcuCell<MessageCallback> message_callback_; // 消息接收回调（可在运行中替换）
+    BusyPollOptions busy_poll_;             // 接收线程的忙轮询配置
+    RealtimeOptions realtime_;              // 接收线程的实时化配置
 };
 
 #endif // UDP_CLIENT_H
@@ -8,9 +8,11 @@
  * @details
  * 提供 UDP 服务器功能，支持：
  * - 绑定指定地址和端口接收数据报
- * - 使用线程池处理接收到的消息
+ * - 线程池中的多个线程并发接收并处理数据报
  * - 向任意地址发送响应
- * - 通过回调处理接收到的消息
+ * - 通过回调处理接收到的消息，也可以按每批数据报批量接收
+ * 
+ * UdpServer 是 BasicUdpServer 基于 std::function 回调的实例化。
  * 
  * @note 该类不可拷贝
  * 
@@ -27,24 +29,22 @@
 #ifndef UDP_SERVER_H
 #define UDP_SERVER_H
 
+#include <arpa/inet.h>
 #include <string>
+#include <string_view>
 #include <functional>
-#include <atomic>
-#include <thread>
-#include <memory>
-#include "thread_pool.h"
+#include "basic_udp_server.h"
+#include "rcu.h"
 
 /**
- * @class UdpServer
- * @brief UDP 服务器类，用于接收和响应 UDP 数据报
+ * @class UdpCallbackHandler
+ * @brief 把 BasicUdpServer 的消息转发给 std::function 回调
  * 
  * @details
- * 该类实现了一个基于线程池的 UDP 服务器：
- * - 主接收线程负责接收数据报
- * - 线程池中的工作线程负责处理消息
- * - 使用回调机制通知上层应用
+ * 发送方地址和消息使用线程内复用的字符串，稳态下不分配内存。
+ * 回调保存在 RcuCell 中，服务器运行期间可以无锁地随时替换
  */
-class UdpServer {
+class UdpCallbackHandler {
 public:
     /**
      * @brief 消息接收回调函数类型
@@ -55,91 +55,87 @@ public:
     using MessageCallback = std::function<void(const std::string& sender_ip, uint16_t sender_port, const std::string& message)>;
     
     /**
-     * @brief 构造函数
-     * @param ip 服务器绑定的 IP 地址（如 "0.0.0.0" 表示所有接口）
-     * @param port 服务器监听的端口号
-     * @param thread_pool_size 线程池大小，默认为 4
-     */
-    UdpServer(const std::string& ip, uint16_t port, size_t thread_pool_size = 4);
-    
-    /**
-     * @brief 析构函数
-     * @details 自动停止服务器并释放资源
+     * @brief 批量消息回调函数类型
+     * @param messages 一次 recvmmsg 收到的全部消息，只在回调期间有效
      */
-    ~UdpServer();
+    using BatchCallback = std::function<void(Span<const UdpMessage> messages)>;
     
-    /// @brief 禁止拷贝构造
-    UdpServer(const UdpServer&) = delete;
-    /// @brief 禁止拷贝赋值
-    UdpServer& operator=(const UdpServer&) = delete;
+    RcuCell<MessageCallback> message_callback;  ///< 消息接收回调
+    RcuCell<BatchCallback> batch_callback;      ///< 批量消息回调
     
-    /**
-     * @brief 启动服务器
-     * @return true 启动成功，false 启动失败
-     * 
-     * @details
-     * 启动流程：
-     * 1. 创建 UDP socket
-     * 2. 绑定地址和端口
-     * 3. 启动接收线程
-     */
-    bool start();
+    template <typename Server>
+    void on_message(Server&, const sockaddr_in& sender_addr, std::string_view message) {
+        // 接收线程中已处于读临界区，这里只是嵌套计数
+        Rcu::ReadGuard guard;
+        const MessageCallback* callback = message_callback.load();
+        if (!callback || !*callback) {
+            return;
+        }
+        
+        thread_local std::string sender_ip;
+        thread_local std::string buffer;
+        
+        char ip_str[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &sender_addr.sin_addr, ip_str, sizeof(ip_str));
+        sender_ip.assign(ip_str);
+        buffer.assign(message.data(), message.size());
+        
+        (*callback)(sender_ip, ntohs(sender_addr.sin_port), buffer);
+    }
     
-    /**
-     * @brief 停止服务器
-     * 
-     * @details
-     * 停止流程：
-     * 1. 关闭 socket
-     * 2. 等待接收线程结束
-     */
-    void stop();
+    template <typename Server>
+    void on_batch(Server& server, Span<const UdpMessage> messages) {
+        Rcu::ReadGuard guard;
+        const BatchCallback* callback = batch_callback.load();
+        if (callback && *callback) {
+            (*callback)(messages);
+            return;
+        }
+        // 批量回调刚被清除时，已收到的消息逐条交给消息接收回调
+        for (const UdpMessage& message : messages) {
+            on_message(server, message.sender, message.data);
+        }
+    }
+};
+
+/**
+ * @class UdpServer
+ * @brief UDP 服务器类，用于接收和响应 UDP 数据报
+ * 
+ * @details
+ * 该类实现了一个基于线程池的 UDP 服务器：
+ * - 线程池中的每个线程都在同一个 socket 上接收数据报
+ * - 收到数据报的线程直接调用回调处理，不再跨线程投递
+ * - 使用回调机制通知上层应用（回调可能在多个线程中并发执行）
+ */
+class UdpServer : public BasicUdpServer<UdpCallbackHandler> {
+public:
+    using MessageCallback = UdpCallbackHandler::MessageCallback;
+    using BatchCallback = UdpCallbackHandler::BatchCallback;
     
     /**
-     * @brief 发送消息到指定地址
-     * @param ip 目标 IP 地址
-     * @param port 目标端口号
-     * @param message 要发送的消息内容
-     * @return true 发送成功，false 发送失败
+     * @brief 构造函数
+     * @param ip 服务器绑定的 IP 地址（如 "0.0.0.0" 表示所有接口）
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小，默认为 4
      */
-    bool send_to(const std::string& ip, uint16_t port, const std::string& message);
+    UdpServer(const std::string& ip, uint16_t port, size_t thread_pool_size = 4);
     
     /**
      * @brief 设置消息接收回调
      * @param callback 接收到消息时调用的回调函数
+     * 
+     * @note 可以在运行中随时调用（包括在回调内部），旧回调在宽限期后释放
      */
     void set_message_callback(MessageCallback callback);
     
     /**
-     * @brief 获取服务器运行状态
-     * @return true 正在运行，false 已停止
-     */
-    bool is_running() const { return running_; }
-    
-private:
-    /**
-     * @brief 消息接收循环（在独立线程中运行）
-     * @details 持续接收 UDP 数据报，并提交到线程池处理
-     */
-    void receive_loop();
-    
-    /**
-     * @brief 处理接收到的消息（在线程池中运行）
-     * @param sender_ip 发送方 IP 地址
-     * @param sender_port 发送方端口号
-     * @param message 接收到的消息内容
+     * @brief 设置批量消息回调
+     * @param callback 每次 recvmmsg 调用一次，交付这一批的全部消息；为空时恢复逐条回调
+     * 
+     * @details 通常配合 set_receive_batch()，可以在运行中随时调用；设置后不再调用消息接收回调
      */
-    void process_message(const std::string& sender_ip, uint16_t sender_port, const std::string& message);
-    
-    std::string ip_;                                // 服务器绑定的 IP 地址
-    uint16_t port_;                                 // 服务器监听的端口
-    int socket_fd_;                                 // socket 文件描述符
-    std::atomic<bool> running_;                     // 服务器运行状态标志
-    
-    std::unique_ptr<ThreadPool> thread_pool_;       // 线程池指针
-    std::thread receive_thread_;                    // 接收消息的线程
-    
-    MessageCallback message_callback_;              // 消息接收回调
+    void set_batch_callback(BatchCallback callback);
 };
 
 #endif // UDP_SERVER_H
@@ -0,0 +1,314 @@
+/**
+ * @file udp_server_base.h
+ * @brief UDP 服务器公共部分（非模板）的头文件
+ * @author Your Name
+ * @date 2024
+ * @version 1.0.0
+ * 
+ * @details
+ * 提供 UDP 服务器中与消息类型无关的部分：
+ * - 绑定指定地址和端口接收数据报
+ * - 在线程池的每个线程中运行接收循环，接收缓冲区来自预缺页的内存区域
+ * - 向任意地址发送响应
+ * - 可选 SO_REUSEPORT，配合 PreforkSupervisor 以多个工作进程各自绑定同一端口
+ * - 可选忙轮询：接收线程以 MSG_DONTWAIT 自旋，空转超时后退回阻塞接收
+ * - 可选内核收发时间戳（SO_TIMESTAMPING）：区分内核排队与用户态处理的延迟
+ * 
+ * 接收循环本身由模板 BasicUdpServer 实现（每个线程一次虚调用），
+ * 数据报的分帧与分发可以被编译器内联。
+ * 
+ * @note 该类不可拷贝，不能直接实例化；应使用 BasicUdpServer 或 UdpServer
+ */
+
+#ifndef UDP_SERVER_BASE_H
+#define UDP_SERVER_BASE_H
+
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <future>
+#include <mutex>
+#include "thread_pool.h"
+#include "buffer_arena.h"
+#include "busy_poll.h"
+#include "realtime.h"
+#include "timestamping.h"
+
+/**
+ * @class UdpServerBase
+ * @brief UDP 服务器的非模板公共部分
+ * 
+ * @details
+ * 线程池中的每个线程都在同一个 socket 上接收数据报，
+ * 收到数据报的线程直接在本线程内处理，不跨线程投递。
+ */
+class UdpServerBase {
+public:
+    /// @brief 一次 recvmmsg 最多接收的数据报数
+    static constexpr size_t MAX_RECEIVE_BATCH = 64;
+    
+    /**
+     * @brief 构造函数
+     * @param ip 服务器绑定的 IP 地址（如 "0.0.0.0" 表示所有接口）
+     * @param port 服务器监听的端口号
+     * @param thread_pool_size 线程池大小，默认为 4
+     */
+    UdpServerBase(const std::string& ip, uint16_t port, size_t thread_pool_size = 4);
+    
+    /**
+     * @brief 析构函数
+     * @details 派生类必须在自己的析构函数中调用 stop()，保证接收循环不会在派生部分析构后运行
+     */
+    virtual ~UdpServerBase();
+    
+    /// @brief 禁止拷贝构造
+    UdpServerBase(const UdpServerBase&) = delete;
+    /// @brief 禁止拷贝赋值
+    UdpServerBase& operator=(const UdpServerBase&) = delete;
+    
+    /**
+     * @brief 启动服务器
+     * @return true 启动成功，false 启动失败
+     * 
+     * @details
+     * 启动流程：
+     * 1. 创建 UDP socket
+     * 2. 绑定地址和端口
+     * 3. 在线程池的每个线程中启动接收循环
+     */
+    bool start();
+    
+    /**
+     * @brief 停止服务器
+     * 
+     * @details
+     * 停止流程：
+     * 1. 关闭 socket
+     * 2. 等待所有接收循环结束
+     */
+    void stop();
+    
+    /**
+     * @brief 发送消息到指定地址
+     * @param ip 目标 IP 地址
+     * @param port 目标端口号
+     * @param message 要发送的消息内容
+     * @return true 发送成功，false 发送失败
+     */
+    bool send_to(const std::string& ip, uint16_t port, std::string_view message);
+    
+    /**
+     * @brief 发送消息到指定地址
+     * @param dest_addr 目标地址（如接收回调中的发送方地址）
+     * @param message 要发送的消息内容
+     * @return true 发送成功，false 发送失败
+     * 
+     * @details 省去 IP 字符串的解析，适合在接收回调中直接回复
+     */
+    bool send_to(const sockaddr_in& dest_addr, std::string_view message);
+    
+    /**
+     * @brief 设置接收缓冲区所用内存区域的配置
+     * @param options 内存区域配置（大页、预缺页、mlock 等）
+     *
+     * @details
+     * 必须在 start() 之前调用。start() 会按该配置映射并预缺页接收缓冲区，
+     * size 为 0 时为每个接收线程映射一个最大数据报大小的缓冲区。
+     */
+    void set_buffer_arena_options(const BufferArena::Options& options);
+    
+    /**
+     * @brief 设置每次系统调用最多接收的数据报数
+     * @param max_datagrams 数据报数，取值范围 [1, MAX_RECEIVE_BATCH]，默认为 1
+     * 
+     * @details
+     * 必须在首次 start() 之前调用。大于 1 时使用 recvmmsg 一次取走多个数据报，
+     * 每个接收线程的缓冲区相应增大为 max_datagrams 个最大数据报。
+     */
+    void set_receive_batch(size_t max_datagrams);
+    
+    /**
+     * @brief 设置是否开启 SO_REUSEPORT
+     * @param enabled 是否允许多个 socket（通常位于不同进程）绑定同一地址和端口，默认为 false
+     * 
+     * @details
+     * 必须在 start() 之前调用。配合 PreforkSupervisor 使用时，每个工作进程各自
+     * 绑定一个 socket，由内核按四元组哈希把数据报分配给它们。
+     */
+    void set_reuse_port(bool enabled) { reuse_port_ = enabled; }
+    
+    /**
+     * @brief 设置接收线程的忙轮询模式
+     * @param options 忙轮询配置
+     * 
+     * @details
+     * 必须在 start() 之前调用。启用后每个接收线程以 MSG_DONTWAIT 调用 recvmmsg 自旋，
+     * 连续空转超过 idle_timeout 后退回阻塞接收，收到数据报后重新自旋。
+     * SO_BUSY_POLL / SO_PREFER_BUSY_POLL 被内核拒绝时打印警告并只保留自旋。
+     * 每个接收线程会占满一个 CPU。
+     */
+    void set_busy_poll(const BusyPollOptions& options) { busy_poll_ = options; }
+    
+    /**
+     * @brief 设置接收线程的实时化配置
+     * @param options 实时化配置
+     * 
+     * @details
+     * 必须在 start() 之前调用。每个接收线程启动时以 io_priority 切换为 SCHED_FIFO、
+     * 预写入栈，lock_memory 为 true 时首个线程对整个进程 mlockall。
+     * 权限不足时退化为普通调度并打印一次警告，结果见 Realtime::report()。
+     */
+    void set_realtime(const RealtimeOptions& options) { realtime_ = options; }
+    
+    /**
+     * @brief 设置内核收发时间戳
+     * @param options 时间戳配置
+     * 
+     * @details
+     * 必须在 start() 之前调用。开启接收时间戳后，每个数据报的内核收包时间通过
+     * UdpMessage::rx_timestamp_ns（批量回调）或 rx_timestamp_ns()（逐条回调）交付，
+     * 并记录 rx_queue 与 rx_dispatch 两段延迟；开启发送时间戳后，接收线程在每批数据报
+     * 分发完毕时读取错误队列，记录 tx_queue。
+     * 
+     * 发送时间戳按发送顺序编号，开启后 send_to() 在一把锁内完成编号与发送。
+     * 内核不支持时打印警告并关闭时间戳。
+     */
+    void set_timestamping(const TimestampingOptions& options);
+    
+    /**
+     * @brief 获取内核时间戳测得的延迟
+     * @return 三段延迟的摘要（纳秒），未开启时各项为空
+     * 
+     * @note 该函数是线程安全的
+     */
+    WireLatencyStats wire_latency() const;
+    
+    /**
+     * @brief 当前数据报的内核接收时间戳
+     * @return CLOCK_REALTIME 纳秒，未开启或内核没有提供时为 0
+     * 
+     * @details 只在接收线程的逐条回调中有效（InlineExecutor）；
+     *          投递到其他线程的回调应在投递前取出
+     */
+    static int64_t rx_timestamp_ns() { return current_rx_timestamp_; }
+    
+    /**
+     * @brief 获取服务器运行状态
+     * @return true 正在运行，false 已停止
+     */
+    bool is_running() const { return running_; }
+    
+protected:
+    /**
+     * @struct Datagram
+     * @brief receive() 收到的一个数据报
+     */
+    struct Datagram {
+        sockaddr_in sender;     // 发送方地址
+        char* data;             // 数据起始地址（位于接收缓冲区中）
+        size_t length;          // 数据长度
+        int64_t rx_timestamp_ns;// 内核接收时间戳（CLOCK_REALTIME 纳秒），未开启时为 0
+    };
+    
+    /**
+     * @brief 消息接收循环（在线程池的工作线程中运行，由派生类实现）
+     * @param buffer 本线程的接收缓冲区
+     * @param poller 本线程的忙轮询状态
+     * @details 应在 is_running() 为 true 期间持续调用 receive()
+     */
+    virtual void run_receiver(char* buffer, BusyPoller& poller) = 0;
+    
+    /**
+     * @brief 接收一批数据报
+     * @param buffer 接收缓冲区（run_receiver() 的参数）
+     * @param datagrams 输出参数，至少 MAX_RECEIVE_BATCH 个元素
+     * @param poller 本线程的忙轮询状态（run_receiver() 的参数）
+     * @return 收到的数据报数，自旋中暂无数据时返回 0，出错时返回 -1
+     * 
+     * @details 阻塞到至少收到一个数据报，然后不再等待地取走已到达的数据报；
+     *          忙轮询的自旋阶段不阻塞
+     */
+    int receive(char* buffer, Datagram* datagrams, BusyPoller& poller);
+    
+    /**
+     * @brief 一批数据报分发完毕（派生类在每次 receive() 收到数据并分发后调用）
+     * 
+     * @details 开启接收时间戳时记录 rx_dispatch，开启发送时间戳时读取错误队列
+     */
+    void finish_batch() {
+        if (timestamping_.rx || timestamping_.tx) {
+            record_batch();
+        }
+    }
+    
+    /**
+     * @brief 设置当前数据报的接收时间戳（派生类在逐条分发前调用）
+     */
+    static void set_rx_timestamp(int64_t ns) { current_rx_timestamp_ = ns; }
+    
+    /**
+     * @brief 启用或关闭批量分发（运行中也可以切换）
+     */
+    void set_batch_dispatch(bool enabled) { batch_dispatch_.store(enabled, std::memory_order_relaxed); }
+    
+    /**
+     * @brief 是否启用批量分发
+     */
+    bool batch_dispatch() const { return batch_dispatch_.load(std::memory_order_relaxed); }
+    
+private:
+    /**
+     * @brief 接收线程入口
+     * @param buffer 本线程的接收缓冲区，nullptr 时使用堆上缓冲区
+     */
+    void receiver_main(char* buffer);
+    
+    /**
+     * @brief 记录本批的分发延迟并读取发送时间戳
+     */
+    void record_batch();
+    
+    /**
+     * @struct TxSlot
+     * @brief 一次发送的编号与时刻，按编号取模存放
+     */
+    struct TxSlot {
+        std::atomic<uint64_t> id{UINT64_MAX};   // 发送编号，UINT64_MAX 表示空
+        std::atomic<int64_t> sent_ns{0};        // 发送调用前的时刻（CLOCK_REALTIME 纳秒）
+    };
+    
+    /// @brief 保留的发送时刻数，超过该数量仍未读到时间戳的发送不再能对应
+    static constexpr size_t TX_SLOTS = 4096;
+    
+    inline static thread_local int64_t current_rx_timestamp_ = 0;  // 当前数据报的接收时间戳
+    inline static thread_local uint64_t batch_ticks_ = 0;          // 本批 recvmmsg 返回时的周期计数
+    
+    std::string ip_;                                // 服务器绑定的 IP 地址
+    uint16_t port_;                                 // 服务器监听的端口
+    int socket_fd_;                                 // socket 文件描述符
+    std::atomic<bool> running_;                     // 服务器运行状态标志
+    size_t receive_batch_;                          // 每次系统调用最多接收的数据报数
+    bool reuse_port_;                               // 是否开启 SO_REUSEPORT
+    BusyPollOptions busy_poll_;                     // 接收线程的忙轮询配置
+    RealtimeOptions realtime_;                      // 接收线程的实时化配置
+    TimestampingOptions timestamping_;              // 内核时间戳配置
+    std::unique_ptr<WireLatency> latency_;          // 延迟直方图，开启时间戳时创建
+    std::unique_ptr<TxSlot[]> tx_slots_;            // 发送编号 -> 发送时刻，开启发送时间戳时创建
+    std::mutex tx_mutex_;                           // 串行化编号与发送
+    uint64_t tx_sequence_;                          // 下一次发送的编号，受 tx_mutex_ 保护
+    std::atomic<bool> batch_dispatch_;              // 是否启用批量分发
+    
+    BufferArena::Options arena_options_;            // 内存区域配置
+    std::unique_ptr<BufferArena> arena_;            // 接收缓冲区的内存区域
+    std::vector<char*> recv_buffers_;               // 每个接收线程的缓冲区（位于 arena_ 中）
+    
+    std::unique_ptr<ThreadPool> thread_pool_;       // 线程池指针（运行接收循环）
+    std::vector<std::future<void>> receive_futures_;// 接收循环任务的 future
+};
+
+#endif // UDP_SERVER_BASE_H
@@ -7,6 +7,7 @@
  */
 
 #include "udp_client.h"
+#include "clock.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -15,6 +16,8 @@
 #include <iostream>
 
 /// @brief 接收缓冲区大小（UDP 最大数据报大小）
+/// @note 数据报一次读完，缓冲区小于数据报会被截断，因此每个接收线程固定持有一个；
+///       消息按实际长度拷贝，缓冲区也不再逐次清零
 constexpr int BUFFER_SIZE = 65535;
 
 /**
@@ -132,7 +135,6 @@ bool UdpClient::send_to(const std::string& ip, uint16_t port, const std::string&
         return false;
     }
     
-    std::cout << "[UdpClient] Sent to " << ip << ":" << port << " - " << message << std::endl;
     return bytes_sent == static_cast<ssize_t>(message.size());
 }
 
@@ -177,6 +179,7 @@ void UdpClient::stop_receiving() {
  * 使用接收超时机制，以便能够响应 stop_receiving() 调用。
  */
 void UdpClient::receive_loop() {
+    Realtime::configure_io_thread(realtime_);
     char buffer[BUFFER_SIZE];
     
     // 设置接收超时，以便能够检查 receiving_ 标志
@@ -185,20 +188,29 @@ void UdpClient::receive_loop() {
     timeout.tv_usec = 0;
     setsockopt(socket_fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     
+    if (!BusyPoller::apply_socket_options(socket_fd_, busy_poll_)) {
+        std::cerr << "[UdpClient] Kernel busy polling unavailable, spinning only: " << strerror(errno) << std::endl;
+    }
+    BusyPoller poller(busy_poll_);
+    
+    // 复用的字符串，容量增长到位后不再分配内存
+    std::string sender_ip;
+    std::string message;
+    sender_ip.reserve(INET_ADDRSTRLEN);
+    
     while (receiving_) {
         sockaddr_in sender_addr{};
         socklen_t addr_len = sizeof(sender_addr);
         
-        // 清空缓冲区
-        memset(buffer, 0, sizeof(buffer));
-        
-        // 接收数据
-        ssize_t bytes_read = recvfrom(socket_fd_, buffer, sizeof(buffer) - 1, 0,
+        // 接收数据（忙轮询的自旋阶段不阻塞）
+        int flags = poller.spinning() ? MSG_DONTWAIT : 0;
+        ssize_t bytes_read = recvfrom(socket_fd_, buffer, sizeof(buffer) - 1, flags,
                                        reinterpret_cast<sockaddr*>(&sender_addr), &addr_len);
         
         if (bytes_read < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 接收超时，继续循环检查 receiving_ 标志
+                // 自旋空转或接收超时，继续循环检查 receiving_ 标志
+                poller.on_idle();
                 continue;
             }
             if (receiving_) {
@@ -206,24 +218,27 @@ void UdpClient::receive_loop() {
             }
             continue;
         }
+        poller.on_work();
+        Clock::refresh();
         
         // 获取发送方地址
         char ip_str[INET_ADDRSTRLEN];
         inet_ntop(AF_INET, &sender_addr.sin_addr, ip_str, sizeof(ip_str));
-        std::string sender_ip(ip_str);
+        sender_ip.assign(ip_str);
         uint16_t sender_port = ntohs(sender_addr.sin_port);
         
         // 构造消息字符串
-        std::string message(buffer, bytes_read);
-        
-        std::cout << "[UdpClient] Received from " << sender_ip << ":" << sender_port 
-                  << " - " << message << std::endl;
+        message.assign(buffer, static_cast<size_t>(bytes_read));
         
-        // 触发消息回调
-        if (message_callback_) {
-            message_callback_(sender_ip, sender_port, message);
+        // 触发消息回调（读临界区内只做一次加载，不加锁）
+        Rcu::ReadGuard guard;
+        const MessageCallback* callback = message_callback_.load();
+        if (callback && *callback) {
+            (*callback)(sender_ip, sender_port, message);
         }
     }
+    
+    Clock::invalidate();
 }
 
 /**
@@ -231,5 +246,5 @@ void UdpClient::receive_loop() {
  * @param callback 回调函数
  */
 void UdpClient::set_message_callback(MessageCallback callback) {
-    message_callback_ = std::move(callback);
+    message_callback_.store(std::move(callback));
 }
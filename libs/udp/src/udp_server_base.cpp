@@ -0,0 +1,390 @@
+/**
+ * @file udp_server_base.cpp
+ * @brief UDP 服务器公共部分的实现文件
+ * @author Your Name
+ * @date 2024
+ * @version 1.0.0
+ */
+
+#include "udp_server_base.h"
+#include "clock.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+/// @brief 接收缓冲区大小（UDP 最大数据报大小）
+/// @note 数据报一次读完，缓冲区小于数据报会被截断，因此每个接收线程固定持有
+///       receive_batch_ 个；消息按实际长度交付，缓冲区也不再逐次清零
+constexpr size_t BUFFER_SIZE = 65535;
+
+/**
+ * @brief 构造函数实现
+ * @param ip 服务器绑定的 IP 地址
+ * @param port 服务器监听的端口
+ * @param thread_pool_size 线程池大小
+ */
+UdpServerBase::UdpServerBase(const std::string& ip, uint16_t port, size_t thread_pool_size)
+    : ip_(ip)
+    , port_(port)
+    , socket_fd_(-1)
+    , running_(false)
+    , receive_batch_(1)
+    , reuse_port_(false)
+    , tx_sequence_(0)
+    , batch_dispatch_(false)
+    , thread_pool_(std::make_unique<ThreadPool>(thread_pool_size)) {
+    // 区域大小默认为每个接收线程一个最大数据报
+    arena_options_.size = 0;
+}
+
+/**
+ * @brief 析构函数实现
+ */
+UdpServerBase::~UdpServerBase() {
+}
+
+/**
+ * @brief 启动服务器
+ * @return 启动是否成功
+ */
+bool UdpServerBase::start() {
+    // 检查是否已在运行
+    if (running_) {
+        return false;
+    }
+    
+    // 创建 UDP socket
+    socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_fd_ < 0) {
+        std::cerr << "[UdpServer] Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // 设置地址复用选项
+    int opt = 1;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        std::cerr << "[UdpServer] Failed to set socket options: " << strerror(errno) << std::endl;
+        ::close(socket_fd_);
+        return false;
+    }
+    
+    // 多个进程各自绑定同一端口，由内核分配数据报
+    if (reuse_port_ && setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        std::cerr << "[UdpServer] Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+        ::close(socket_fd_);
+        return false;
+    }
+    
+    // 内核忙轮询选项被拒绝时（如超过 net.core.busy_read 而没有 CAP_NET_ADMIN）只保留自旋
+    if (!BusyPoller::apply_socket_options(socket_fd_, busy_poll_)) {
+        std::cerr << "[UdpServer] Kernel busy polling unavailable, spinning only: " << strerror(errno) << std::endl;
+    }
+    
+    // 内核不支持时关闭时间戳，收发照常进行
+    if (!Timestamping::enable(socket_fd_, timestamping_)) {
+        std::cerr << "[UdpServer] SO_TIMESTAMPING unavailable, timestamping disabled: " << strerror(errno) << std::endl;
+        timestamping_ = TimestampingOptions();
+    }
+    tx_sequence_ = 0;
+    
+    // 设置服务器地址结构
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port_);
+    
+    // 转换 IP 地址
+    if (inet_pton(AF_INET, ip_.c_str(), &server_addr.sin_addr) <= 0) {
+        std::cerr << "[UdpServer] Invalid IP address: " << ip_ << std::endl;
+        ::close(socket_fd_);
+        return false;
+    }
+    
+    // 绑定地址
+    if (bind(socket_fd_, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) < 0) {
+        std::cerr << "[UdpServer] Failed to bind: " << strerror(errno) << std::endl;
+        ::close(socket_fd_);
+        return false;
+    }
+    
+    size_t receiver_count = thread_pool_->size();
+    
+    // 首次启动时映射接收缓冲区并完成预缺页
+    if (!arena_) {
+        BufferArena::Options options = arena_options_;
+        if (options.size == 0) {
+            options.size = (BUFFER_SIZE * receive_batch_ + 64) * receiver_count;
+        }
+        arena_ = std::make_unique<BufferArena>(options);
+        for (size_t i = 0; i < receiver_count; ++i) {
+            recv_buffers_.push_back(static_cast<char*>(arena_->allocate(BUFFER_SIZE * receive_batch_)));
+        }
+    }
+    
+    running_ = true;
+    
+    // 在线程池的每个线程中启动接收循环
+    for (char* buffer : recv_buffers_) {
+        receive_futures_.push_back(thread_pool_->submit([this, buffer]() { this->receiver_main(buffer); }));
+    }
+    
+    std::cout << "[UdpServer] Server started on " << ip_ << ":" << port_ << std::endl;
+    return true;
+}
+
+/**
+ * @brief 停止服务器
+ */
+void UdpServerBase::stop() {
+    // 检查是否在运行
+    if (!running_) {
+        return;
+    }
+    
+    running_ = false;
+    
+    // 关闭 socket，使 recvfrom() 退出阻塞
+    if (socket_fd_ >= 0) {
+        shutdown(socket_fd_, SHUT_RDWR);
+        ::close(socket_fd_);
+        socket_fd_ = -1;
+    }
+    
+    // 等待所有接收循环结束
+    for (std::future<void>& future : receive_futures_) {
+        future.wait();
+    }
+    receive_futures_.clear();
+    
+    std::cout << "[UdpServer] Server stopped" << std::endl;
+}
+
+/**
+ * @brief 接收线程入口
+ * @param buffer 本线程的接收缓冲区
+ */
+void UdpServerBase::receiver_main(char* buffer) {
+    // 映射失败时退回堆上缓冲区
+    std::unique_ptr<char[]> fallback;
+    if (!buffer) {
+        fallback.reset(new char[BUFFER_SIZE * receive_batch_]);
+        buffer = fallback.get();
+    }
+    Realtime::configure_io_thread(realtime_);
+    BusyPoller poller(busy_poll_);
+    run_receiver(buffer, poller);
+    Clock::invalidate();
+}
+
+/**
+ * @brief 接收一批数据报
+ * @param buffer 接收缓冲区
+ * @param datagrams 输出数据报
+ * @param poller 本线程的忙轮询状态
+ * @return 数据报数、0（自旋中暂无数据）或 -1
+ * 
+ * @details
+ * 多个线程阻塞在同一个 socket 上，由内核把数据报分发给其中之一。
+ * MSG_WAITFORONE 使 recvmmsg 在收到第一个数据报后不再等待，只取走已到达的部分；
+ * 自旋阶段加上 MSG_DONTWAIT，连第一个数据报也不等待
+ */
+int UdpServerBase::receive(char* buffer, Datagram* datagrams, BusyPoller& poller) {
+    mmsghdr headers[MAX_RECEIVE_BATCH];
+    iovec iovs[MAX_RECEIVE_BATCH];
+    alignas(cmsghdr) char control[MAX_RECEIVE_BATCH][Timestamping::CONTROL_SIZE];
+    
+    for (size_t i = 0; i < receive_batch_; ++i) {
+        iovs[i].iov_base = buffer + i * BUFFER_SIZE;
+        iovs[i].iov_len = BUFFER_SIZE - 1;
+        memset(&headers[i], 0, sizeof(headers[i]));
+        headers[i].msg_hdr.msg_name = &datagrams[i].sender;
+        headers[i].msg_hdr.msg_namelen = sizeof(datagrams[i].sender);
+        headers[i].msg_hdr.msg_iov = &iovs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+        if (timestamping_.rx) {
+            headers[i].msg_hdr.msg_control = control[i];
+            headers[i].msg_hdr.msg_controllen = Timestamping::CONTROL_SIZE;
+        }
+    }
+    
+    int flags = poller.spinning() ? MSG_WAITFORONE | MSG_DONTWAIT : MSG_WAITFORONE;
+    int count = recvmmsg(socket_fd_, headers, static_cast<unsigned int>(receive_batch_), flags, nullptr);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            poller.on_idle();
+            return 0;
+        }
+        if (running_ && errno != EINTR) {
+            std::cerr << "[UdpServer] Recvmmsg failed: " << strerror(errno) << std::endl;
+        }
+        return -1;
+    }
+    
+    poller.on_work();
+    
+    for (int i = 0; i < count; ++i) {
+        datagrams[i].data = static_cast<char*>(iovs[i].iov_base);
+        datagrams[i].length = headers[i].msg_len;
+        datagrams[i].rx_timestamp_ns = 0;
+    }
+    
+    // 一批只读一次时钟：排队时间为内核收包到本次调用返回
+    if (timestamping_.rx) {
+        int64_t now_ns = Timestamping::realtime_ns();
+        for (int i = 0; i < count; ++i) {
+            int64_t stamp = Timestamping::rx_timestamp(headers[i].msg_hdr);
+            datagrams[i].rx_timestamp_ns = stamp;
+            if (stamp != 0 && Timestamping::plausible(now_ns - stamp)) {
+                latency_->rx_queue.record(static_cast<uint64_t>(now_ns - stamp));
+            }
+        }
+        batch_ticks_ = Clock::ticks();
+    }
+    return count;
+}
+
+/**
+ * @brief 发送消息到指定地址
+ * @param ip 目标 IP 地址
+ * @param port 目标端口
+ * @param message 要发送的消息
+ * @return 发送是否成功
+ */
+bool UdpServerBase::send_to(const std::string& ip, uint16_t port, std::string_view message) {
+    // 检查运行状态
+    if (!running_) {
+        return false;
+    }
+    
+    // 设置目标地址
+    sockaddr_in dest_addr{};
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(port);
+    
+    // 转换 IP 地址
+    if (inet_pton(AF_INET, ip.c_str(), &dest_addr.sin_addr) <= 0) {
+        std::cerr << "[UdpServer] Invalid destination IP: " << ip << std::endl;
+        return false;
+    }
+    
+    return send_to(dest_addr, message);
+}
+
+/**
+ * @brief 发送消息到指定地址
+ * @param dest_addr 目标地址
+ * @param message 要发送的消息
+ * @return 发送是否成功
+ */
+bool UdpServerBase::send_to(const sockaddr_in& dest_addr, std::string_view message) {
+    // 检查运行状态
+    if (!running_) {
+        return false;
+    }
+    
+    // 发送数据
+    ssize_t bytes_sent;
+    if (timestamping_.tx) {
+        // 内核按发送调用的顺序编号，编号与发送必须在同一把锁内
+        std::lock_guard<std::mutex> lock(tx_mutex_);
+        TxSlot& slot = tx_slots_[tx_sequence_ % TX_SLOTS];
+        slot.sent_ns.store(Timestamping::realtime_ns(), std::memory_order_relaxed);
+        slot.id.store(tx_sequence_, std::memory_order_release);
+        bytes_sent = sendto(socket_fd_, message.data(), message.size(), 0,
+                            reinterpret_cast<const sockaddr*>(&dest_addr), sizeof(dest_addr));
+        if (bytes_sent >= 0) {
+            ++tx_sequence_;
+        }
+    } else {
+        bytes_sent = sendto(socket_fd_, message.data(), message.size(), 0,
+                            reinterpret_cast<const sockaddr*>(&dest_addr), sizeof(dest_addr));
+    }
+    
+    if (bytes_sent < 0) {
+        std::cerr << "[UdpServer] Sendto failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    return bytes_sent == static_cast<ssize_t>(message.size());
+}
+
+/**
+ * @brief 记录本批的分发延迟并读取发送时间戳
+ * 
+ * @details 错误队列由所有接收线程共享，哪个线程先读到就由哪个线程记录；
+ *          编号对应的发送记录已被覆盖或延迟不合理时计入 tx_unmatched
+ */
+void UdpServerBase::record_batch() {
+    if (timestamping_.rx && batch_ticks_ != 0) {
+        latency_->rx_dispatch.record(static_cast<uint64_t>(Clock::elapsed_ns(batch_ticks_)));
+        batch_ticks_ = 0;
+    }
+    if (!timestamping_.tx) {
+        return;
+    }
+    
+    TxTimestamp stamps[Timestamping::TX_BATCH];
+    bool more = true;
+    while (more) {
+        size_t count = Timestamping::read_tx(socket_fd_, stamps, Timestamping::TX_BATCH, more);
+        for (size_t i = 0; i < count; ++i) {
+            const TxSlot& slot = tx_slots_[stamps[i].id % TX_SLOTS];
+            uint64_t id = slot.id.load(std::memory_order_acquire);
+            int64_t delay_ns = stamps[i].ns - slot.sent_ns.load(std::memory_order_relaxed);
+            if (id != UINT64_MAX && static_cast<uint32_t>(id) == stamps[i].id && Timestamping::plausible(delay_ns)) {
+                latency_->tx_queue.record(static_cast<uint64_t>(delay_ns));
+            } else {
+                latency_->tx_unmatched.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 设置内核收发时间戳
+ * @param options 时间戳配置
+ */
+void UdpServerBase::set_timestamping(const TimestampingOptions& options) {
+    if (running_) {
+        std::cerr << "[UdpServer] Timestamping must be set before start()" << std::endl;
+        return;
+    }
+    timestamping_ = options;
+    if ((options.rx || options.tx) && !latency_) {
+        latency_ = std::make_unique<WireLatency>();
+    }
+    if (options.tx && !tx_slots_) {
+        tx_slots_ = std::make_unique<TxSlot[]>(TX_SLOTS);
+    }
+}
+
+/**
+ * @brief 获取内核时间戳测得的延迟
+ * @return 三段延迟的摘要
+ */
+WireLatencyStats UdpServerBase::wire_latency() const {
+    return latency_ ? latency_->stats() : WireLatencyStats();
+}
+
+/**
+ * @brief 设置接收缓冲区所用内存区域的配置
+ * @param options 内存区域配置
+ */
+void UdpServerBase::set_buffer_arena_options(const BufferArena::Options& options) {
+    arena_options_ = options;
+}
+
+/**
+ * @brief 设置每次系统调用最多接收的数据报数
+ * @param max_datagrams 数据报数
+ */
+void UdpServerBase::set_receive_batch(size_t max_datagrams) {
+    if (arena_) {
+        std::cerr << "[UdpServer] Receive batch must be set before the first start()" << std::endl;
+        return;
+    }
+    receive_batch_ = std::min(std::max<size_t>(max_datagrams, 1), MAX_RECEIVE_BATCH);
+}
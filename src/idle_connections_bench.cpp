@@ -0,0 +1,172 @@
+/**
+ * 空闲连接内存开销基准测试
+ *
+ * 功能：
+ * - 启动 TcpServer，建立大量连接，每个连接回显一次后保持空闲
+ * - 统计每个空闲连接的常驻内存（RSS）增量和连接持有的缓冲区字节数
+ * - 对比 eager 与 lazy 两种缓冲区内存模式
+ *
+ * 使用方法：
+ *   ./idle_connections_bench [connections] [eager|lazy|both]
+ *   默认：10000 both
+ *
+ * 注意：
+ *   客户端与服务端在同一进程中，需要 2 * connections 个文件描述符，
+ *   程序会尝试把 RLIMIT_NOFILE 提升到硬上限。
+ */
+
+#include "tcp_server.h"
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 读取当前进程的常驻内存（字节）
+size_t read_rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// 把文件描述符上限提升到硬上限
+void raise_fd_limit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// 建立一个阻塞的客户端连接
+int connect_client(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 运行一种内存模式，返回是否成功
+bool run_mode(TcpServer::BufferMode mode, const char* name, size_t connections, uint16_t port) {
+    TcpServer server("127.0.0.1", port, 4);
+    server.set_buffer_mode(mode);
+
+    // 不预缺页，让 RSS 只反映真正被使用的内存
+    BufferArena::Options arena_options;
+    arena_options.use_hugepages = false;
+    arena_options.populate = false;
+    arena_options.size = 0;
+    server.set_buffer_arena_options(arena_options);
+
+    std::atomic<size_t> accepted(0);
+    std::atomic<size_t> echoed(0);
+    server.set_connection_callback([&accepted](int, const std::string&) { ++accepted; });
+    server.set_message_callback([&server, &echoed](int client_fd, const std::string& message) {
+        server.send_to(client_fd, message);
+        ++echoed;
+    });
+
+    // 屏蔽库内部的逐连接日志
+    std::streambuf* saved = std::cout.rdbuf(nullptr);
+
+    if (!server.start()) {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+        std::cerr << "Failed to start server for mode " << name << std::endl;
+        return false;
+    }
+
+    std::vector<int> clients;
+    clients.reserve(connections);
+    size_t rss_before = read_rss_bytes();
+
+    // 建立连接
+    for (size_t i = 0; i < connections; ++i) {
+        int fd = connect_client(port);
+        if (fd < 0) {
+            break;
+        }
+        clients.push_back(fd);
+    }
+    while (accepted < clients.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // 每个连接回显一次，之后保持空闲
+    char reply[16];
+    for (int fd : clients) {
+        ::send(fd, "ping", 4, 0);
+    }
+    for (int fd : clients) {
+        recv(fd, reply, sizeof(reply), 0);
+    }
+
+    size_t rss_after = read_rss_bytes();
+    size_t buffer_bytes = server.buffer_bytes_in_use();
+
+    for (int fd : clients) {
+        close(fd);
+    }
+    server.stop();
+
+    std::cout.rdbuf(saved);
+    std::cout.clear();
+
+    size_t count = clients.empty() ? 1 : clients.size();
+    double rss_per_conn = rss_after > rss_before ? static_cast<double>(rss_after - rss_before) / count : 0.0;
+    std::cout << "[" << name << "] connections=" << clients.size()
+              << " echoed=" << echoed
+              << " rss_delta/conn=" << rss_per_conn << " B"
+              << " buffers_held/conn=" << static_cast<double>(buffer_bytes) / count << " B"
+              << std::endl;
+    return clients.size() == connections;
+}
+
+int main(int argc, char* argv[]) {
+    size_t connections = 10000;
+    std::string mode = "both";
+
+    if (argc >= 2) {
+        connections = static_cast<size_t>(std::stoul(argv[1]));
+    }
+    if (argc >= 3) {
+        mode = argv[2];
+    }
+
+    raise_fd_limit();
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "    Idle Connection Memory Benchmark" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    bool ok = true;
+    if (mode == "eager" || mode == "both") {
+        ok = run_mode(TcpServer::BufferMode::Eager, "eager", connections, 19090) && ok;
+    }
+    if (mode == "lazy" || mode == "both") {
+        ok = run_mode(TcpServer::BufferMode::Lazy, "lazy", connections, 19091) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
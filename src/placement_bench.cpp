@@ -0,0 +1,184 @@
+/**
+ * 连接放置策略基准测试
+ *
+ * 功能：
+ * - 每个 CPU 一个事件循环，客户端线程分别绑定到各个 CPU 上，与服务端一问一答地回显
+ * - 对比轮询分配（RoundRobin）与按收包 CPU 分配（IncomingCpu）的吞吐和往返延迟
+ * - 输出按收包 CPU 命中的连接数
+ *
+ * 使用方法：
+ *   ./placement_bench [connections] [messages] [round-robin|incoming-cpu|both]
+ *   默认：每个 CPU 2 个连接，每个连接 20000 条消息，both
+ *
+ * 注意：
+ *   回环接口的收包软中断运行在发送方所在的 CPU 上，因此客户端线程绑定的 CPU
+ *   就是服务端读到的 SO_INCOMING_CPU。只有一个 CPU 时两种策略没有区别。
+ */
+
+#include "tcp_server.h"
+#include "cpu_topology.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief 每条消息的长度
+constexpr size_t MESSAGE_SIZE = 64;
+
+/// @brief 事件循环数量上限
+constexpr size_t MAX_LOOPS = 16;
+
+// 固定长度分帧
+size_t split_fixed(const char*, size_t length) {
+    return length >= MESSAGE_SIZE ? MESSAGE_SIZE : 0;
+}
+
+// 建立一个阻塞的客户端连接
+int connect_client(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// 读满 length 字节
+bool read_full(int fd, char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = recv(fd, data, length, 0);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 运行一种策略
+bool run(TcpServer::Placement placement, const char* name, size_t connections, size_t messages, uint16_t port) {
+    CpuTopology topology;
+    const std::vector<int>& cpus = topology.cpus();
+    size_t loops = std::min(cpus.size(), MAX_LOOPS);
+
+    TcpServer server("127.0.0.1", port, loops);
+    server.set_placement(placement);
+    server.set_frame_splitter(split_fixed);
+    server.set_message_callback([&server](int client_fd, const std::string& message) {
+        server.send_to(client_fd, message);
+    });
+    if (!server.start()) {
+        std::cerr << "[" << name << "] Failed to start" << std::endl;
+        return false;
+    }
+
+    std::atomic<bool> failed(false);
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::thread> clients;
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < connections; ++i) {
+        clients.emplace_back([&, i]() {
+            // 先绑核再连接，握手的收包也在该 CPU 上处理
+            CpuTopology::pin_current_thread(cpus[i % cpus.size()]);
+            int fd = connect_client(port);
+            if (fd < 0) {
+                failed = true;
+                return;
+            }
+
+            char payload[MESSAGE_SIZE] = {};
+            char reply[MESSAGE_SIZE];
+            latencies[i].reserve(messages);
+            for (size_t m = 0; m < messages; ++m) {
+                auto start = std::chrono::steady_clock::now();
+                if (send(fd, payload, sizeof(payload), 0) != static_cast<ssize_t>(sizeof(payload))
+                    || !read_full(fd, reply, sizeof(reply))) {
+                    failed = true;
+                    break;
+                }
+                latencies[i].push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+            close(fd);
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    TcpServer::PlacementStats placed = server.placement_stats();
+    server.stop();
+    if (failed) {
+        std::cerr << "[" << name << "] Echo failed" << std::endl;
+        return false;
+    }
+
+    std::vector<double> all;
+    for (const std::vector<double>& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all.empty() ? 0.0 : all[static_cast<size_t>(p * (all.size() - 1))]; };
+
+    std::cout << "[" << name << "] loops=" << loops << " connections=" << connections
+              << " msgs/s=" << static_cast<uint64_t>(all.size() / seconds)
+              << " p50=" << percentile(0.50) << "us"
+              << " p99=" << percentile(0.99) << "us"
+              << " same_cpu=" << placed.same_cpu
+              << " same_node=" << placed.same_node
+              << " fallback=" << placed.fallback << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    CpuTopology topology;
+    size_t connections = std::min(topology.cpus().size(), MAX_LOOPS) * 2;
+    size_t messages = 20000;
+    std::string mode = "both";
+
+    if (argc >= 2) {
+        connections = static_cast<size_t>(std::stoul(argv[1]));
+    }
+    if (argc >= 3) {
+        messages = static_cast<size_t>(std::stoul(argv[2]));
+    }
+    if (argc >= 4) {
+        mode = argv[3];
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "    Connection Placement Benchmark" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    bool ok = true;
+    if (mode == "round-robin" || mode == "both") {
+        ok = run(TcpServer::Placement::RoundRobin, "round-robin", connections, messages, 19110) && ok;
+    }
+    if (mode == "incoming-cpu" || mode == "both") {
+        ok = run(TcpServer::Placement::IncomingCpu, "incoming-cpu", connections, messages, 19111) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
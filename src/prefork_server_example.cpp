@@ -0,0 +1,117 @@
+/**
+ * 多进程（pre-fork）服务端示例
+ *
+ * 功能：
+ * - 监督者 fork 出 N 个工作进程，每个进程各自以 SO_REUSEPORT 监听同一端口上的
+ *   TCP 与 UDP，运行只有一个事件循环/接收线程的服务器，回显收到的消息
+ * - 工作进程崩溃后由监督者自动重启（TCP 客户端发送 "/crash" 可以触发一次崩溃）
+ * - 各工作进程把指标写入共享内存，监督者每秒汇总输出一次
+ *
+ * 使用方法：
+ *   ./prefork_server [workers] [port]
+ *   默认：每个 CPU 一个工作进程，端口 8888
+ *
+ * 注意：
+ *   按 Ctrl+C 时监督者和工作进程都会收到 SIGINT，工作进程正常退出后监督者随之结束
+ */
+
+#include "prefork_supervisor.h"
+#include "tcp_server.h"
+#include "udp_server.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/// @brief 计数器下标
+enum Counter {
+    TCP_MESSAGES = 0,
+    UDP_DATAGRAMS = 1
+};
+
+/// @brief 瞬时值下标
+enum Gauge {
+    TCP_CONNECTIONS = 0,
+    BUFFER_BYTES = 1
+};
+
+PreforkSupervisor* g_supervisor = nullptr;
+
+void signal_handler(int) {
+    if (g_supervisor) {
+        g_supervisor->stop();
+    }
+}
+
+// 工作进程入口：各自监听，定期发布指标，收到停止信号后退出
+int run_worker(PreforkSupervisor::Worker& worker, uint16_t port) {
+    TcpServer tcp("0.0.0.0", port, 1);
+    tcp.set_reuse_port(true);
+    tcp.set_message_callback([&tcp, &worker](int client_fd, const std::string& message) {
+        if (message.compare(0, 6, "/crash") == 0) {
+            std::abort();
+        }
+        worker.add(TCP_MESSAGES, 1);
+        tcp.send_to(client_fd, message);
+    });
+
+    UdpServer udp("0.0.0.0", port, 1);
+    udp.set_reuse_port(true);
+    udp.set_message_callback([&udp, &worker](const std::string& sender_ip, uint16_t sender_port, const std::string& message) {
+        worker.add(UDP_DATAGRAMS, 1);
+        udp.send_to(sender_ip, sender_port, message);
+    });
+
+    if (!tcp.start() || !udp.start()) {
+        return 1;
+    }
+
+    while (worker.wait(std::chrono::milliseconds(200))) {
+        worker.set(TCP_CONNECTIONS, tcp.connection_count());
+        worker.set(BUFFER_BYTES, tcp.buffer_bytes_in_use());
+    }
+
+    tcp.stop();
+    udp.stop();
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    PreforkSupervisor::Options options;
+    uint16_t port = 8888;
+
+    if (argc >= 2) {
+        options.workers = static_cast<size_t>(std::stoul(argv[1]));
+    }
+    if (argc >= 3) {
+        port = static_cast<uint16_t>(std::stoi(argv[2]));
+    }
+
+    PreforkSupervisor supervisor([port](PreforkSupervisor::Worker& worker) {
+        return run_worker(worker, port);
+    }, options);
+    g_supervisor = &supervisor;
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "       Pre-fork Server Example" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "Workers: " << supervisor.worker_count() << ", port: " << port << " (TCP and UDP)" << std::endl;
+    std::cout << "Press Ctrl+C to stop" << std::endl;
+    std::cout << "----------------------------------------" << std::endl;
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    supervisor.set_report_handler(std::chrono::seconds(1), [](const PreforkSupervisor::Metrics& metrics) {
+        std::cout << "[Main] running=" << metrics.running
+                  << " restarts=" << metrics.restarts
+                  << " tcp_messages=" << metrics.counters[TCP_MESSAGES]
+                  << " udp_datagrams=" << metrics.counters[UDP_DATAGRAMS]
+                  << " connections=" << metrics.gauges[TCP_CONNECTIONS]
+                  << " buffer_bytes=" << metrics.gauges[BUFFER_BYTES] << std::endl;
+    });
+
+    bool ok = supervisor.run();
+    g_supervisor = nullptr;
+    return ok ? 0 : 1;
+}
@@ -14,7 +14,7 @@
  * 命令：
  *   直接输入文字 - 广播给所有客户端
  *   /send <fd> <消息> - 发送给指定客户端
- *   /list - 列出所有连接的客户端
+ *   /list - 列出所有连接的客户端及其收发统计
  *   /quit - 退出服务器
  */
 
@@ -28,6 +28,8 @@
 #include <cerrno>
 #include <cstring>
 #include <sstream>
+#include <vector>
+#include <arpa/inet.h>
 
 std::atomic<bool> g_running(true);
 TcpServer* g_server = nullptr;
@@ -164,14 +166,25 @@ int main(int argc, char* argv[]) {
             if (input == "/quit") {
                 break;
             } else if (input == "/list") {
-                // 列出所有客户端
-                auto clients = server.get_clients();
-                if (clients.empty()) {
+                // 分页列出所有客户端，不阻塞服务器
+                if (server.connection_count() == 0) {
                     std::cout << "[Info] No clients connected." << std::endl;
                 } else {
-                    std::cout << "[Info] Connected clients (" << clients.size() << "):" << std::endl;
-                    for (const auto& [fd, addr] : clients) {
-                        std::cout << "  fd=" << fd << " -> " << addr << std::endl;
+                    std::cout << "[Info] Connected clients (" << server.connection_count() << "):" << std::endl;
+                    std::vector<ConnectionStats> page;
+                    int64_t now_ns = Clock::now_ns();
+                    for (int cursor = 0; cursor >= 0;) {
+                        cursor = server.scan_connections(cursor, 256, ConnectionFilter(), page);
+                        for (const ConnectionStats& client : page) {
+                            char ip[INET_ADDRSTRLEN];
+                            in_addr addr{client.ip};
+                            inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+                            std::cout << "  fd=" << client.fd << " -> " << ip << ":" << client.port
+                                      << " in=" << client.messages_in << " msgs/" << client.bytes_in << " B"
+                                      << " out=" << client.messages_out << " msgs/" << client.bytes_out << " B"
+                                      << " queued=" << client.queued_bytes << " B"
+                                      << " idle=" << (now_ns - client.last_activity_ns) / 1000000 << " ms" << std::endl;
+                        }
                     }
                 }
                 std::cout << "> " << std::flush;
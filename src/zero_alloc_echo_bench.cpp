@@ -0,0 +1,180 @@
+/**
+ * 稳态回显零分配基准测试
+ *
+ * 功能：
+ * - 在同一进程中启动服务端和客户端，按一问一答的方式回显固定长度的消息
+ * - 预热后统计整个进程（服务端事件循环/接收线程 + 客户端接收线程）的堆分配
+ * - 输出每条消息的分配次数和字节数，非零时以失败退出
+ *
+ * 使用方法：
+ *   ./zero_alloc_echo_bench [messages] [tcp|tcp-lazy|udp|all]
+ *   默认：20000 all
+ *
+ * 注意：
+ *   本程序链接 alloc_tracker，替换了全局 operator new/delete。
+ *   消息长度大于 std::string 的短字符串优化阈值，逐条构造字符串会被统计到。
+ */
+
+#include "tcp_server.h"
+#include "tcp_client.h"
+#include "udp_server.h"
+#include "udp_client.h"
+#include "alloc_tracker.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/// @brief 每条消息的长度
+constexpr size_t MESSAGE_SIZE = 64;
+
+/// @brief 预热消息数
+constexpr size_t WARMUP_MESSAGES = 2000;
+
+/// @brief 等待单条回显的超时时间
+constexpr auto REPLY_TIMEOUT = std::chrono::seconds(2);
+
+// 固定长度分帧
+size_t split_fixed(const char*, size_t length) {
+    return length >= MESSAGE_SIZE ? MESSAGE_SIZE : 0;
+}
+
+// 等待回显计数达到 expected，超时返回 false（忙等，不分配内存）
+bool wait_for(const std::atomic<size_t>& counter, size_t expected) {
+    auto deadline = std::chrono::steady_clock::now() + REPLY_TIMEOUT;
+    while (counter.load(std::memory_order_acquire) < expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// 输出结果并判断是否为零分配
+bool report(const char* name, size_t messages, const AllocCounters& delta) {
+    double per_message = static_cast<double>(delta.allocations) / messages;
+    double bytes_per_message = static_cast<double>(delta.bytes) / messages;
+    bool ok = delta.allocations == 0;
+    std::cout << "[" << name << "] messages=" << messages
+              << " allocations=" << delta.allocations
+              << " allocs/msg=" << per_message
+              << " bytes/msg=" << bytes_per_message
+              << (ok ? " PASS" : " FAIL") << std::endl;
+    return ok;
+}
+
+// TCP 回显
+bool run_tcp(TcpServer::BufferMode mode, const char* name, size_t messages, uint16_t port) {
+    TcpServer server("127.0.0.1", port, 2);
+    server.set_buffer_mode(mode);
+    server.set_frame_splitter(split_fixed);
+    server.set_message_callback([&server](int client_fd, const std::string& message) {
+        server.send_to(client_fd, message);
+    });
+
+    TcpClient client;
+    std::atomic<size_t> received(0);
+    client.set_frame_splitter(split_fixed);
+    client.set_message_callback([&received](const std::string&) {
+        received.fetch_add(1, std::memory_order_release);
+    });
+
+    if (!server.start() || !client.connect("127.0.0.1", port)) {
+        std::cerr << "[" << name << "] Failed to start" << std::endl;
+        return false;
+    }
+
+    const std::string payload(MESSAGE_SIZE, 'x');
+    bool ok = true;
+    AllocRegion region(AllocRegion::Scope::Process);
+
+    for (size_t i = 0; i < WARMUP_MESSAGES + messages && ok; ++i) {
+        if (i == WARMUP_MESSAGES) {
+            region.reset();
+        }
+        ok = client.send(payload) && wait_for(received, i + 1);
+    }
+    AllocCounters delta = region.delta();
+
+    client.disconnect();
+    server.stop();
+
+    if (!ok) {
+        std::cerr << "[" << name << "] Echo timed out after " << received << " messages" << std::endl;
+        return false;
+    }
+    return report(name, messages, delta);
+}
+
+// UDP 回显
+bool run_udp(size_t messages, uint16_t port) {
+    UdpServer server("127.0.0.1", port, 2);
+    server.set_message_callback([&server](const std::string& ip, uint16_t sender_port, const std::string& message) {
+        server.send_to(ip, sender_port, message);
+    });
+
+    UdpClient client;
+    std::atomic<size_t> received(0);
+    client.set_message_callback([&received](const std::string&, uint16_t, const std::string&) {
+        received.fetch_add(1, std::memory_order_release);
+    });
+
+    if (!server.start() || !client.init(0)) {
+        std::cerr << "[udp] Failed to start" << std::endl;
+        return false;
+    }
+    client.start_receiving();
+
+    const std::string server_ip = "127.0.0.1";
+    const std::string payload(MESSAGE_SIZE, 'x');
+    bool ok = true;
+    AllocRegion region(AllocRegion::Scope::Process);
+
+    for (size_t i = 0; i < WARMUP_MESSAGES + messages && ok; ++i) {
+        if (i == WARMUP_MESSAGES) {
+            region.reset();
+        }
+        ok = client.send_to(server_ip, port, payload) && wait_for(received, i + 1);
+    }
+    AllocCounters delta = region.delta();
+
+    client.close();
+    server.stop();
+
+    if (!ok) {
+        std::cerr << "[udp] Echo timed out after " << received << " messages" << std::endl;
+        return false;
+    }
+    return report("udp", messages, delta);
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = 20000;
+    std::string mode = "all";
+
+    if (argc >= 2) {
+        messages = static_cast<size_t>(std::stoul(argv[1]));
+    }
+    if (argc >= 3) {
+        mode = argv[2];
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "    Zero-Allocation Echo Benchmark" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    bool ok = true;
+    if (mode == "tcp" || mode == "all") {
+        ok = run_tcp(TcpServer::BufferMode::Eager, "tcp", messages, 19100) && ok;
+    }
+    if (mode == "tcp-lazy" || mode == "all") {
+        ok = run_tcp(TcpServer::BufferMode::Lazy, "tcp-lazy", messages, 19101) && ok;
+    }
+    if (mode == "udp" || mode == "all") {
+        ok = run_udp(messages, 19102) && ok;
+    }
+
+    return ok ? 0 : 1;
+}